@@ -0,0 +1,83 @@
+#pragma once
+
+#include "pch.hh"
+
+#include <algorithm>
+#include <type_traits>
+
+
+namespace arena
+{
+
+    // size of the blocks the Arena allocates from
+    #define ARENA_BLOCK_SIZE 65536
+
+
+    // bump allocator for the objects of a single compilation
+    // objects are never freed one by one, they are all released together
+    // by release() or when the Arena is destroyed
+    class Arena
+    {
+    private:
+
+        // blocks of raw memory objects are allocated from
+        std::vector<char*> blocks;
+
+        // first free byte of the last block
+        char* current;
+
+        // bytes left in the last block
+        size_t remaining;
+
+
+        // allocates a new block of at least the given size
+        void grow(size_t size);
+
+    public:
+
+        Arena();
+
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+
+        // returns uninitialized memory with the given size and alignment
+        void* allocate(size_t size, size_t alignment);
+
+
+        // constructs an object inside the Arena
+        // objects must be trivially destructible since their destructor is never called
+        template <typename T, typename... Args>
+        T* make(Args&&... args)
+        {
+            static_assert(std::is_trivially_destructible<T>::value,
+                "Arena objects are never destroyed");
+
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+
+        // copies the given elements to an array inside the Arena
+        template <typename T>
+        T* makeArray(std::initializer_list<T> elements)
+        {
+            static_assert(std::is_trivially_destructible<T>::value,
+                "Arena objects are never destroyed");
+
+            T* array = (T*) allocate(sizeof(T) * elements.size(), alignof(T));
+            std::copy(elements.begin(), elements.end(), array);
+
+            return array;
+        }
+
+
+        // frees every object allocated so far
+        // the Arena can be used again afterwards
+        void release();
+
+    };
+
+};
+
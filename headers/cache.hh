@@ -0,0 +1,112 @@
+#pragma once
+
+#include "pch.hh"
+
+#include "pvm.hh"
+
+#include <mutex>
+
+
+namespace cache
+{
+
+    // name of the file the Statistics are kept in, inside the cache directory
+    #define CACHE_STATISTICS_FILE "statistics"
+
+
+    // outcome of the cache lookups
+    typedef struct Statistics
+    {
+        size_t hits = 0;
+        size_t misses = 0;
+
+        // compilation time the hits didn't have to spend
+        uint64_t savedMicros = 0;
+
+    } Statistics;
+
+
+    // identifies a compilation by its preprocessed script along with
+    // everything else its executable depends on
+    typedef struct Key
+    {
+        // 64 bit FNV-1a hash
+        uint64_t hash;
+        // size of the preprocessed script, tells apart most colliding hashes
+        uint64_t size;
+
+    } Key;
+
+
+    // on disk cache of compiled executables, addressed by Key
+    // entries are written to a temporary file and renamed, so concurrent
+    // compilations never read a partial entry
+    class Cache
+    {
+    private:
+
+        std::string directory;
+
+        // whether the directory exists and can be written to
+        bool usable;
+
+        // counted by this process, added to the stored ones by saveStatistics()
+        Statistics session;
+
+        // guards session when files are compiled on several threads
+        std::mutex sessionLock;
+
+
+        // path of the entry file of the given Key with the given extension
+        std::string entryPath(const Key& key, const char* extension) const;
+
+    public:
+
+        // creates the directory if it doesn't exist
+        // failing to do so doesn't report an error, see isUsable()
+        Cache(const std::string& directory);
+
+        Cache(const Cache&) = delete;
+        Cache& operator=(const Cache&) = delete;
+
+
+        // $XDG_CACHE_HOME/pcc, ~/.cache/pcc without it
+        static std::string defaultDirectory();
+
+
+        // whether the directory could be created and written to
+        // an unusable cache shouldn't be used, compilations go on without it
+        bool isUsable() const;
+
+
+        // the Key of a preprocessed script
+        // the compiler executable is part of the Key, so rebuilding pcc
+        // invalidates the entries of the previous build
+        Key keyOf(std::string_view script, bool optimize) const;
+
+
+        // copies the executable stored under the Key to the given file
+        // returns false on a miss
+        bool fetch(const Key& key, const char* outputName);
+
+
+        // stores the executable under the Key, along with the time it took to compile
+        // a cache that can't be written to doesn't fail the compilation
+        void store(const Key& key, const pvm::ByteCode& byteCode, const pvm::ByteCode& lineTable, uint64_t compileMicros);
+
+
+        // adds the Statistics of this process to the stored ones
+        // returns the updated totals
+        Statistics saveStatistics();
+
+
+        // the Statistics counted by this process
+        Statistics getSession();
+
+    };
+
+};
+
+
+std::ostream& operator<<(std::ostream& stream, const cache::Statistics& statistics);
+
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "pch.hh"
+
+#include "arena.hh"
+#include "interner.hh"
+#include "symbol_table.hh"
+#include "scanner.hh"
+
+#include <memory>
+
+
+// PREDECLARATIONS
+
+namespace syntax_tree { class SyntaxTree; };
+
+
+namespace compilation
+{
+
+    // state of a single compilation
+    // nothing is shared between Contexts, so separate compilations can run
+    // concurrently as long as each one has its own Context
+    class Context
+    {
+    public:
+
+        // owns the front-end nodes of the compilation
+        arena::Arena arena;
+
+        // names of the symbols of the script
+        interner::StringInterner interner;
+
+        // scopes being evaluated and the stack layout of their symbols
+        symbol_table::SymbolTable symbolTable;
+
+        // whether to apply optimizations to the compiled byte code
+        const bool optimize;
+
+        // finds the ends of names, numbers and blanks while tokenizing
+        // the fastest one the CPU supports unless replaced
+        const scanner::Scanner* scanner;
+
+        // SyntaxTrees of the nested scopes whose byte code isn't used yet
+        // owned here, so that an error in the middle of parsing doesn't leak them
+        std::vector<std::unique_ptr<syntax_tree::SyntaxTree>> scopeTrees;
+
+
+        Context(bool optimize);
+
+        ~Context();
+
+        Context(const Context&) = delete;
+        Context& operator=(const Context&) = delete;
+
+
+        // takes ownership of the SyntaxTree of a nested scope
+        syntax_tree::SyntaxTree* addScopeTree(std::unique_ptr<syntax_tree::SyntaxTree> tree);
+
+        // deletes a SyntaxTree of a nested scope once its byte code is used
+        void releaseScopeTree(syntax_tree::SyntaxTree* tree);
+
+    };
+
+};
+
@@ -6,9 +6,42 @@
 #include "token.hh"
 #include "op_codes.hh"
 
+#include <stdexcept>
+
 
 namespace errors
 {
+
+    // an error reported while errors are being captured
+    // the message is the one that would have been printed
+    class Error : public std::runtime_error
+    {
+    public:
+
+        using std::runtime_error::runtime_error;
+
+    };
+
+
+    // while a Capture exists, the errors of its thread are thrown as errors::Error
+    // instead of being printed before exiting the process
+    // meant for hosts that embed the compiler or the Pvm
+    class Capture
+    {
+    private:
+
+        bool previous;
+
+    public:
+
+        Capture();
+        ~Capture();
+
+        Capture(const Capture&) = delete;
+        Capture& operator=(const Capture&) = delete;
+
+    };
+
     
     void UnexpectedBehaviourError(const std::string& message);
 
@@ -37,6 +70,10 @@ namespace errors
 
 
     void ZeroDivisionError(const Tokens::Token& caller, const Tokens::Token& op1, const Tokens::Token& op2);
+    void ZeroDivisionError(long dividend);
+
+
+    void DivisionOverflowError();
 
 
     void InvalidPreprocessorError(const char* name);
@@ -45,6 +82,18 @@ namespace errors
     void InvalidIncludeEnclosureError(char c);
 
 
+    void RecursiveIncludeError(const char* file);
+
+
+    void InvalidMacroNameError(const char* name);
+
+
+    void UnmatchedConditionalError(const char* directive);
+
+
+    void UnterminatedConditionalError(const char* file, uint32_t line);
+
+
     void FileReadError(const char* file);
 
 
@@ -53,5 +102,36 @@ namespace errors
 
     void MissingClosingParenthesisError(const Tokens::Token& caller, const std::string& message);
 
+
+    void MissingClosingScopeError(const Tokens::Token& caller);
+
+
+    void MissingStatementError(const Tokens::Token& caller, const char* message);
+
+
+    void NotImplementedError(const Tokens::Token& caller);
+
+
+    // the Token can't be printed, its fields are
+    void UndefinedTokenError(const Tokens::Token& token);
+
+
+    void InvalidByteCodeError(const std::string& message);
+
+
+    void InvalidExecutableError(const char* file, const std::string& message);
+
+
+    void OutOfMemoryError(size_t size);
+
+
+    void StackOverflowError();
+
+
+    void InsufficientMemoryError(size_t required, size_t available);
+
+
+    void CCompilerError(const char* compiler);
+
 };
 
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "pch.hh"
+
+
+namespace interner
+{
+
+    // dense integer identifier of an interned string
+    typedef unsigned int StringId;
+
+
+    // maps every distinct identifier to a StringId so that the rest of the
+    // compiler can compare and hash integers instead of strings
+    class StringInterner
+    {
+    private:
+
+        // interned strings, indexed by their StringId
+        // a deque is used so that the views in the map never dangle
+        std::deque<std::string> strings;
+
+        std::unordered_map<std::string_view, StringId> ids;
+
+    public:
+
+        StringInterner();
+
+        // the map's keys view the strings of this instance
+        StringInterner(const StringInterner&) = delete;
+        StringInterner& operator=(const StringInterner&) = delete;
+
+
+        // returns the StringId of the given string, interning it if it's new
+        StringId intern(std::string_view string);
+
+
+        // returns a new StringId that no string maps to
+        // used for anonymous symbols such as temporary values
+        StringId unique();
+
+
+        // returns the string a StringId was interned from
+        // anonymous ids map to an empty string
+        const std::string& get(StringId id) const;
+
+    };
+
+};
+
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "pch.hh"
+
+#include "pvm.hh"
+
+
+// native code generation is only implemented for x86-64
+// other architectures always fall back to the interpreter
+#if defined(__x86_64__)
+    #define PVM_JIT 1
+#else
+    #define PVM_JIT 0
+#endif
+
+
+// baseline JIT compiler, translates decoded Pvm programs to native code
+namespace jit
+{
+
+    // REGISTER_COUNT names the Registers enum unqualified
+    typedef pvm::Registers Registers;
+
+
+    // errors the native code ends a run with, raised by NativeProgram::run()
+    // exceptions can't be thrown through the native code, it has no unwind information
+    typedef enum class Error : long
+    {
+        NONE,
+        STACK_OVERFLOW,
+        ZERO_DIVISION,
+        DIVISION_OVERFLOW,
+
+    } Error;
+
+
+    // machine state shared between the Pvm and the native code
+    // the native code reads it on entry and writes it back on EXIT
+    typedef struct Context
+    {
+        // first byte of the Pvm memory
+        pvm::Byte* memory;
+        size_t memorySize;
+
+        long stackPointer;
+
+        // register file, indexed by pvm::Registers
+        long registers[REGISTER_COUNT];
+
+        // set by the native code when the run ends with an error instead of EXIT
+        Error error;
+
+    } Context;
+
+
+    // signature of the translated program
+    // returns the exit code of the program
+    typedef pvm::Byte (*NativeFunction)(Context* context);
+
+
+    /*
+        A program translated to x86-64 machine code, one template per OpCode.
+        The Pvm registers are pinned to callee saved host registers and memory
+        is addressed off a fixed base register, so that the only state kept in
+        the Context is the stack pointer.
+    */
+    class NativeProgram
+    {
+    private:
+
+        // executable mapping holding the machine code
+        void* code;
+        size_t size;
+
+    public:
+
+        // translates the given program
+        // programs that can't be translated are left unsupported, see isSupported()
+        NativeProgram(const std::vector<pvm::Instruction>& program);
+
+        ~NativeProgram();
+
+        NativeProgram(const NativeProgram&) = delete;
+        NativeProgram& operator=(const NativeProgram&) = delete;
+
+
+        // whether the program was translated
+        // unsupported programs must be run by the interpreter
+        bool isSupported() const;
+
+        // runs the translated program on the given machine state
+        // errors are reported through errors:: once the native code has returned
+        pvm::Byte run(Context& context) const;
+
+    };
+
+};
+
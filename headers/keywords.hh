@@ -11,36 +11,31 @@ namespace keywords
     const char* keywordName(OpCodes keyword);
 
 
-    // maps string to a keyword
-    extern const std::unordered_map<std::string, OpCodes> keywordsMap;
-
-
-    // a constant structure holding a keyword's predefined value
-    typedef struct KeywordValue
+    // a word of the script with a meaning of its own, either a keyword or
+    // a predefined value
+    typedef struct Word
     {
-        const Value value;
-        const Tokens::TokenType type;
-
-        KeywordValue(Value value, Tokens::TokenType type);
+        std::string_view text;
 
-    } KeywordValue;
+        // NO_OP for predefined values
+        OpCodes keyword = OpCodes::NO_OP;
 
+        // predefined value and its type, only set if the word isn't a keyword
+        Value value = 0;
+        Tokens::TokenType type = Tokens::TokenType::NONE;
 
-    // maps a keyword to a value
-    extern const std::unordered_map<std::string, KeywordValue> keywordValues;
+    } Word;
 
 
-    // whether the given keyword has a predefiend value or not
-    bool hasValue(std::string const& word, Value& value, Tokens::TokenType& type);
+    // the keyword or predefined value the word stands for, nullptr for any other name
+    // takes a single probe of a perfect hash table
+    const Word* findWord(std::string_view word);
 
 
     // returns the priority of a given keyword using a switch statement
     int keywordPriority(OpCodes keyword);
 
 
-    OpCodes isKeyword(std::string const& word);
-
-
     Tokens::TokenType declarationType(OpCodes keyword);
 
 };
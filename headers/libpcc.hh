@@ -0,0 +1,128 @@
+#pragma once
+
+#include "pvm.hh"
+
+#include <variant>
+
+
+// PREDECLARATIONS
+
+namespace preprocessor { class Output; };
+
+
+/*
+    In-process interface of the compiler, for hosts that compile scripts
+    without launching pcc. Errors are returned as Diagnostics instead of
+    ending the process. Every call has its own compiler state, so
+    compilations can run concurrently on separate threads.
+*/
+
+namespace pcc
+{
+
+    // either a value or the error that prevented it
+    template <typename T, typename E>
+    class Result
+    {
+    private:
+
+        std::variant<T, E> content;
+
+    public:
+
+        Result(T&& value)
+        :   content(std::in_place_index<0>, std::move(value))
+        {
+
+        }
+
+        Result(E&& error)
+        :   content(std::in_place_index<1>, std::move(error))
+        {
+
+        }
+
+
+        bool isOk() const
+        {
+            return content.index() == 0;
+        }
+
+        // only valid if isOk()
+        const T& getValue() const
+        {
+            return std::get<0>(content);
+        }
+
+        // only valid if isOk()
+        T& getValue()
+        {
+            return std::get<0>(content);
+        }
+
+        // only valid if !isOk()
+        const E& getError() const
+        {
+            return std::get<1>(content);
+        }
+
+    };
+
+
+    // an object-like macro defined before the script is preprocessed
+    typedef struct Macro
+    {
+        std::string name;
+        std::string value;
+
+    } Macro;
+
+
+    typedef struct Options
+    {
+        // same as pcc -O
+        bool optimize = false;
+
+        // same as pcc -D NAME=VALUE
+        std::vector<Macro> macros;
+
+    } Options;
+
+
+    // an error that stopped the compilation
+    typedef struct Diagnostic
+    {
+        // the message pcc would have printed
+        std::string message;
+
+    } Diagnostic;
+
+
+    typedef std::vector<Diagnostic> Diagnostics;
+
+
+    // the output of a successful compilation
+    typedef struct Compilation
+    {
+        std::vector<pvm::Byte> byteCode;
+
+        // source locations of the byte code, in the layout of the DEBUG section
+        std::vector<pvm::Byte> lineTable;
+
+
+        // views of the buffers above, valid as long as the Compilation exists
+        pvm::ByteCode getByteCode();
+        pvm::ByteCode getLineTable();
+
+    } Compilation;
+
+
+    // compiles the given script, #include directives are resolved like pcc does
+    Result<Compilation, Diagnostics> compile(std::string_view source, const Options& options = Options());
+
+    // compiles a script the caller already preprocessed, so it isn't preprocessed twice
+    // the script is the text of the Output, or the source itself if preprocessing didn't change it
+    // the Output gives the locations of the line table, the macros of the Options are ignored
+    Result<Compilation, Diagnostics> compile(std::string_view script, const preprocessor::Output& output, const Options& options);
+
+};
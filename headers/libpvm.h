@@ -0,0 +1,93 @@
+#pragma once
+
+/*
+    C interface of the Perma Virtual Machine, for hosts that run many programs
+    in their own process. Programs are loaded and decoded once, instances keep
+    their memory between runs and are reset before each one.
+    Errors are returned as a status, pvm_last_error() describes the last one.
+    C++ hosts can also use pvm::Pvm directly, see Pvm::reset().
+
+    Threading rules:
+    - a program is never modified once loaded, any number of threads can run it at once
+    - an instance can only be used by one thread at a time, instances can be
+      created, run and freed on different threads concurrently
+    - pvm_last_error() is kept per thread
+
+    Stack overflows are caught on guard pages around the memory of each
+    instance, with a SIGSEGV handler installed when the first instance is
+    created. They are returned as PVM_ERROR like any other error.
+    Faults outside the guard pages are passed on to the SIGSEGV handler that
+    was installed before. A host that installs its own handler afterwards
+    replaces the library's, stack overflows then reach that handler.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// bumped whenever the interface changes in an incompatible way
+#define PVM_API_VERSION 1
+
+
+// a decoded program, can be run by any number of instances
+typedef struct PvmProgram PvmProgram;
+
+// a virtual machine along with its memory
+typedef struct PvmInstance PvmInstance;
+
+
+typedef enum PvmStatus
+{
+    PVM_OK,
+    // see pvm_last_error()
+    PVM_ERROR,
+
+} PvmStatus;
+
+
+// the PVM_API_VERSION the library was built with
+unsigned int pvm_api_version(void);
+
+
+// loads the code section of a .pfx executable
+PvmStatus pvm_load_executable(const char* name, PvmProgram** program);
+
+// loads raw byte code, the bytes are copied
+// byte code that could run past its last instruction is rejected
+PvmStatus pvm_load_byte_code(const uint8_t* byteCode, size_t size, PvmProgram** program);
+
+void pvm_free_program(PvmProgram* program);
+
+
+// a memory size of 0 stands for the default size
+// the size is rounded up to whole pages
+PvmStatus pvm_create_instance(size_t memorySize, PvmInstance** instance);
+
+void pvm_free_instance(PvmInstance* instance);
+
+
+// resets the instance, then runs the program until it exits
+// the registers and the memory are left as the program left them
+PvmStatus pvm_run(PvmInstance* instance, const PvmProgram* program, uint8_t* exitCode);
+
+
+// value of the given register after the last run, 0 for invalid registers
+// registers are numbered like pvm::Registers
+long pvm_get_register(const PvmInstance* instance, unsigned int reg);
+
+// memory of the instance after the last run, valid until the instance is freed
+const uint8_t* pvm_get_memory(const PvmInstance* instance, size_t* size);
+
+
+// description of the last error of the calling thread
+const char* pvm_last_error(void);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,6 +8,9 @@
 #include <fstream>
 #include <optional>
 #include <unordered_map>
+#include <vector>
+#include <deque>
+#include <string_view>
 
 #include <stdlib.h>
 #include <memory.h>
@@ -1,6 +1,9 @@
 #pragma once
 
-#include <iostream>
+#include "pch.hh"
+#include "utils.hh"
+
+#include <memory>
 
 
 namespace preprocessor
@@ -11,14 +14,181 @@ namespace preprocessor
         INCLUDE,
         DEFINE,
         IFDEF,
-        IFNDEF
+        IFNDEF,
+        ELSE,
+        ENDIF,
+        PRAGMA
 
     } Preps;
 
 
-    // applies preprocessor rules to the provided script
-    // changes the string
-    void process(std::string& script);
+    // a file read by the preprocessor, or the script itself
+    typedef struct SourceFile
+    {
+        // as resolved from the #include directive, empty for the script
+        std::string path;
+
+        std::string_view content;
+
+        // owns the content of included files, mapped in memory
+        // the content of the script is owned by the caller
+        std::optional<file_utils::SourceBuffer> buffer;
+
+        // owns the value of macros
+        std::string storage;
+
+        // set by #pragma once, the file is included only the first time
+        bool once = false;
+
+        bool included = false;
+
+        // whether the file is being scanned, including it again would never end
+        bool scanning = false;
+
+    } SourceFile;
+
+
+    // a range of a SourceFile that is part of the output
+    typedef struct Piece
+    {
+        const SourceFile* file;
+
+        size_t offset;
+        size_t length;
+
+        // line of the file the range begins at
+        uint32_t line;
+
+    } Piece;
+
+
+    // where a character of the output comes from
+    typedef struct Location
+    {
+        const SourceFile* file;
+        uint32_t line;
+
+    } Location;
+
+
+    // an #ifdef or #ifndef that hasn't been closed by #endif yet
+    typedef struct Conditional
+    {
+        // whether the lines are part of the output
+        bool active;
+
+        // whether the lines around the conditional are part of the output
+        bool enclosing;
+
+        bool hasElse;
+
+        // line of the #ifdef or #ifndef
+        uint32_t line;
+
+    } Conditional;
+
+
+    // the preprocessed script as a list of Pieces of the source files
+    // nothing is copied until toString() is called
+    class Output
+    {
+    private:
+
+        std::vector<Piece> pieces;
+
+        // where every Piece begins in the output
+        std::vector<size_t> offsets;
+
+        size_t size;
+
+    public:
+
+        Output();
+
+
+        // appends a range of the file, empty ranges are left out
+        void add(const SourceFile* file, size_t offset, size_t length, uint32_t line);
+
+
+        const std::vector<Piece>& getPieces() const;
+
+        const std::vector<size_t>& getOffsets() const;
+
+        size_t getSize() const;
+
+
+        // the file and line the character at the given output offset comes from
+        // only valid for offsets inside the output
+        Location locate(size_t offset) const;
+
+
+        // copies the Pieces to a single string
+        std::string toString() const;
+
+    };
+
+
+    // applies the preprocessor rules to a script in a single pass
+    // included files are read once, however many times they're included
+    class Preprocessor
+    {
+    private:
+
+        SourceFile script;
+
+        // included files by path
+        std::unordered_map<std::string, std::unique_ptr<SourceFile>> files;
+
+        // the value of every definition of a macro, its name is the path
+        // values that were redefined stay alive, Pieces may still reference them
+        std::vector<std::unique_ptr<SourceFile>> macroValues;
+
+        // current value of the macros by name
+        std::unordered_map<std::string_view, const SourceFile*> macros;
+
+        // whether any macro name begins with the character
+        // most names in a script are rejected without being hashed
+        bool macroStarts[256];
+
+
+        // reads the file the first time it's requested
+        SourceFile* load(const std::string& path);
+
+        // adds the file to the output, following its directives
+        void scan(SourceFile* file, Output& output);
+
+        // adds a range of the file to the output, replacing the macros it uses
+        void expand(const SourceFile* file, size_t offset, size_t length, uint32_t line, Output& output);
+
+        // handles the directive on the given line of the file
+        // directives are never part of the output
+        void applyDirective(SourceFile* file, std::string_view directive, uint32_t line, std::vector<Conditional>& conditionals, Output& output);
+
+        void include(std::string_view argument, Output& output);
+
+    public:
+
+        Preprocessor();
+
+        Preprocessor(const Preprocessor&) = delete;
+        Preprocessor& operator=(const Preprocessor&) = delete;
+
+
+        // defines an object-like macro, replacing its previous definition
+        // the value is substituted as it is, macros it uses aren't expanded
+        void define(std::string_view name, std::string_view value);
+
+
+        // the Pieces of the Output reference the script and the files of the
+        // Preprocessor, they are valid as long as both exist
+        Output process(std::string_view script);
+
+
+        // whether the Output differs from the script
+        // a script without directives is its own output, no need to copy it
+        bool changes(const Output& output) const;
+
+    };
 
 };
 
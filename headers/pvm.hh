@@ -4,6 +4,12 @@
 
 #include "utils.hh"
 
+#include <functional>
+
+#include <setjmp.h>
+#include <signal.h>
+#include <stdint.h>
+
 
 // DEFINITIONS
 
@@ -11,7 +17,21 @@ typedef unsigned long size_t;
 
 // whether the given register is a bit register
 // dependant on constant enum values
-#define isBitRegister(reg) (reg > Registers::RESULT)
+#define isBitRegister(reg) (reg == Registers::ZERO_FLAG || reg == Registers::SIGN_FLAG)
+
+// whether the given OpCode is a jump instruction
+#define isJump(opCode) (opCode == OpCode::JMP || opCode == OpCode::IF_JUMP \
+    || opCode == OpCode::IF_NOT_JUMP || opCode == OpCode::IF_NOT_MEM_JUMP \
+    || opCode == OpCode::IF_NOT_REG_JUMP)
+
+
+// direct threaded dispatch requires the "labels as values" GNU extension
+// other compilers fall back to the switch dispatch
+#if defined(__GNUC__)
+    #define PVM_COMPUTED_GOTO 1
+#else
+    #define PVM_COMPUTED_GOTO 0
+#endif
 
 
 // Perma Virtual Machine
@@ -101,28 +121,161 @@ namespace pvm
 
         PRINT,              // prints the content of register A
 
+        // fused instructions, generated by ByteList::fuseInstructions()
+        // they leave registers as the instruction sequences they replace
+
+        ADD_MEM_8,          // add two 8 bytes memory values into a memory address
+        ADD_MEM_4,          // add two 4 bytes memory values into a memory address
+        ADD_MEM_CONST_8,    // add a constant to an 8 bytes memory value into a memory address
+        ADD_MEM_CONST_4,    // add a constant to a 4 bytes memory value into a memory address
+
+        SUB_MEM_8,          // subtract two 8 bytes memory values into a memory address
+        SUB_MEM_4,          // subtract two 4 bytes memory values into a memory address
+        SUB_MEM_CONST_8,    // subtract a constant from an 8 bytes memory value into a memory address
+        SUB_MEM_CONST_4,    // subtract a constant from a 4 bytes memory value into a memory address
+
+        MUL_MEM_8,          // multiply two 8 bytes memory values into a memory address
+        MUL_MEM_4,          // multiply two 4 bytes memory values into a memory address
+        MUL_MEM_CONST_8,    // multiply an 8 bytes memory value by a constant into a memory address
+        MUL_MEM_CONST_4,    // multiply a 4 bytes memory value by a constant into a memory address
+
+        CMP_MEM_8,          // compare two 8 bytes memory values, set the ZERO FLAG
+        CMP_MEM_4,          // compare two 4 bytes memory values, set the ZERO FLAG
+        CMP_MEM_CONST_8,    // compare an 8 bytes memory value with a constant, set the ZERO FLAG
+        CMP_MEM_CONST_4,    // compare a 4 bytes memory value with a constant, set the ZERO FLAG
+
+        CMP_REVERSE_MEM_8,      // compare two 8 bytes memory values, set the ZERO FLAG
+        CMP_REVERSE_MEM_4,      // compare two 4 bytes memory values, set the ZERO FLAG
+        CMP_REVERSE_MEM_CONST_8,// compare an 8 bytes memory value with a constant, set the ZERO FLAG
+        CMP_REVERSE_MEM_CONST_4,// compare a 4 bytes memory value with a constant, set the ZERO FLAG
+
+        IF_NOT_MEM_JUMP,    // conditional jump based on a memory bit (0 = true, 1 = false)
+
+        // register instructions, generated by ByteList::allocateRegisters()
+        // general registers hold values already converted to their data size
+
+        LD_REG_8,           // load 8 bytes from memory into a register
+        LD_REG_4,           // load 4 bytes from memory into a register
+        LD_REG_1,           // load 1 byte from memory into a register
+        LD_REG_BIT,         // load 1 bit from memory into a register
+
+        LD_CONST_REG,       // load an 8 bytes constant into a register
+
+        REG_TO_REG_4,       // copy an int value from a register to another
+        REG_TO_REG_1,       // copy 1 byte from a register to another
+        REG_TO_REG_BIT,     // copy 1 bit from a register to another
+
+        // fused register instructions, generated by ByteList::fuseInstructions()
+        // like the other fused instructions, they leave registers as the sequences they replace
+
+        ADD_REG_8,          // add two registers into a register
+        ADD_REG_4,          // add two registers into a register, as an int
+        ADD_REG_CONST_8,    // add a constant to a register into a register
+        ADD_REG_CONST_4,    // add a constant to a register into a register, as an int
+
+        SUB_REG_8,          // subtract two registers into a register
+        SUB_REG_4,          // subtract two registers into a register, as an int
+        SUB_REG_CONST_8,    // subtract a constant from a register into a register
+        SUB_REG_CONST_4,    // subtract a constant from a register into a register, as an int
+
+        MUL_REG_8,          // multiply two registers into a register
+        MUL_REG_4,          // multiply two registers into a register, as an int
+        MUL_REG_CONST_8,    // multiply a register by a constant into a register
+        MUL_REG_CONST_4,    // multiply a register by a constant into a register, as an int
+
+        CMP_REG,            // compare two registers, set the ZERO FLAG
+        CMP_REG_CONST,      // compare a register with a constant, set the ZERO FLAG
+        CMP_REVERSE_REG,    // compare two registers, set the ZERO FLAG
+        CMP_REVERSE_REG_CONST, // compare a register with a constant, set the ZERO FLAG
+
+        IF_NOT_REG_JUMP,    // conditional jump based on a bit in a register (0 = true, 1 = false)
+
         NO_OP,              // does nothing
 
 
     } OpCode;
 
 
+    // memory size used when none is specified
+    #define PVM_DEFAULT_MEMORY_SIZE (8 * 1024 * 1024)
+
+
+    /*
+        The memory is a single anonymous mapping laid out as
+            [guard page] [usable memory] [guard page]
+        Pages are only committed the first time they are touched, so reserving
+        a large memory is cheap. Accessing a guard page means the stack grew
+        past either end of the memory, which is reported as a stack overflow
+        instead of silently corrupting the process. This way memory accesses
+        need no bounds checking.
+        The fault is caught by a SIGSEGV handler installed along with the first
+        Memory. Faults on the guard pages of a Memory with an armed Trap on the
+        faulting thread jump back to the Trap, every other fault goes to the
+        handler that was installed before.
+    */
     class Memory
     {
     private:
 
-        // memory size in bytes
+        // usable memory size in bytes, a multiple of the page size
         size_t size;
 
-        // the stack section 
+        // size of each guard page
+        size_t guardSize;
+
+        // the stack section, right after the first guard page
         Byte* stack = nullptr;
 
+
+        // whether the address is in one of the guard pages
+        bool isGuardPage(const void* address) const;
+
+        // tells stack overflows apart from any other segmentation fault
+        static void onSegmentationFault(int signal, siginfo_t* info, void* context);
+
     public:
 
+        // where a run goes back to when it faults on a guard page
+        // Traps are armed per thread, so each thread can run its own Memory
+        typedef struct Trap
+        {
+            // set by sigsetjmp() before the Trap is armed
+            sigjmp_buf context;
+
+            const Memory* memory;
+
+            // Trap armed before this one on the same thread
+            struct Trap* previous;
+
+        } Trap;
+
+
         Memory(size_t size);
 
         ~Memory();
 
+        Memory(const Memory&) = delete;
+        Memory& operator=(const Memory&) = delete;
+
+
+        // usable memory size in bytes
+        size_t getSize() const;
+
+        // address of the first usable byte, for native code
+        Byte* getBase() const;
+
+        // zeroes the usable memory without reallocating it
+        // the touched pages are given back and committed again on their next access
+        void clear();
+
+
+        // faults on the guard pages of this Memory jump back to the Trap's context
+        // until it's disarmed
+        void arm(Trap& trap) const;
+
+        // has to be called whether or not the Trap was sprung, before its frame returns
+        static void disarm(const Trap& trap);
+
 
         void set(Address address, long value);
         void set(Address address, int value);
@@ -149,6 +302,9 @@ namespace pvm
         // bit registers
         ZERO_FLAG,
         SIGN_FLAG,
+        // general purpose registers, assigned to variables by ByteList::allocateRegisters()
+        R0, R1, R2, R3, R4, R5, R6, R7,
+        R8, R9, R10, R11, R12, R13, R14, R15,
 
     } Registers;
 
@@ -156,6 +312,88 @@ namespace pvm
     // string representation of register
     const char* registerName(Registers reg);
 
+
+    // number of Registers values, used to size the register file
+    #define REGISTER_COUNT ((unsigned int) Registers::R15 + 1)
+
+    // number of general purpose registers available to the register allocator
+    #define GENERAL_REGISTER_COUNT ((unsigned int) Registers::R15 - (unsigned int) Registers::R0 + 1)
+
+
+    // number of OpCode values, used to size lookup tables
+    #define OP_CODE_COUNT ((unsigned int) OpCode::NO_OP + 1)
+
+
+    // returns the size in bytes of an instruction, operands included
+    size_t instructionSize(OpCode opCode);
+
+
+    // fixed-width instruction decoded from the variable-length byte code
+    // operands are already parsed and aligned, jump targets are instruction indices
+    typedef struct Instruction
+    {
+        OpCode opCode;
+
+        // register operands, as indices in the register file
+        Byte reg;
+        Byte reg2;
+        Byte reg3;
+
+        // addresses, constants and jump targets
+        // constants are already converted to the instruction's data size
+        // jump targets are always the first operand
+        long first;
+        long second;
+        long third;
+
+    } Instruction;
+
+
+    struct ByteCode;
+
+
+    // decodes the byte code into an array of Instructions
+    // jump targets are resolved to instruction indices
+    // malformed byte code is rejected, as well as programs that can run past
+    // their last instruction: it has to be EXIT or JMP and jumps can't target the end
+    std::vector<Instruction> decode(const ByteCode& byteCode);
+
+
+    // number of bytes of memory the static addresses of a program reach
+    size_t requiredMemory(const std::vector<Instruction>& program);
+
+
+    // ways the Pvm can dispatch instructions
+    typedef enum class Engine
+    {
+        // one switch on the OpCode for every instruction
+        SWITCH,
+        // table of handler addresses, one per instruction (computed goto)
+        THREADED,
+
+    } Engine;
+
+
+    // string representation of an execution engine
+    const char* engineName(Engine engine);
+
+
+    // microseconds of cpu time between two samples of Pvm::executeSampling()
+    #define PVM_SAMPLING_INTERVAL 1000
+
+
+    // execution statistics of a single instruction, gathered by Pvm::executeProfiling()
+    typedef struct InstructionProfile
+    {
+        // number of times the instruction was executed
+        size_t count;
+
+        // time spent executing the instruction, in timestamp counter cycles
+        // nanoseconds on architectures without a timestamp counter
+        uint64_t cycles;
+
+    } InstructionProfile;
+
     
     // Perma Virtual Machine
     class Pvm
@@ -166,38 +404,118 @@ namespace pvm
 
         // REGISTERS
 
-        // general purpose register A
-        long rGeneralA;
-        // general purpose register B
-        long rGeneralB;
-
-        // result register, result of the last performed operation
-        long rResult;
-
-        // division remainder register, remainder of the last division operation
-        long rDivisionRemainder;
+        /*
+            register file, indexed by Registers:
+            - general purpose registers A and B
+            - result register, result of the last performed operation
+            - division remainder register, remainder of the last division operation
+            - zero flag register, whether the result of the last operation was 0 (see x86 assembly for reference)
+            - sign flag register, holds the sign of the last operation (see x86 assembly for reference)
+            - general purpose registers R0 to R15, holding register allocated variables
+            bit registers only ever hold 0 or 1
+        */
+        long registers[REGISTER_COUNT];
 
         // stack pointer, points to the last used address in the stack
         long rStackPointer;
-        
-        // zero flag register, whether the result of the last operation was 0 (see x86 assembly for reference)
-        bool rZeroFlag;
 
-        // sign flag register, holds the sign of the last operation (see x86 assembly for reference)
-        bool rSignFlag;
 
+        // number of instructions executed by the last counted run
+        size_t instructionCount;
+
+        // statistics of every instruction of the last profiled run, indexed like the program
+        std::vector<InstructionProfile> profile;
+
+        // samples taken on every instruction during the last sampled run, indexed like the program
+        std::vector<size_t> samples;
+
+        // handler addresses of the threaded engine, one per instruction
+        // kept here so that no destructor is skipped when a run is trapped
+        std::vector<const void*> dispatchTable;
 
-        // returns a pointer to the requested register
-        // the returned pointer has to be cast to the right type
-        void* getRegister(Registers reg) const;
+
+        // bookkeeping done by the dispatch loop before every instruction
+        typedef enum class Instrumentation
+        {
+            NONE,
+            // count the executed instructions
+            COUNTING,
+            // count and time every instruction
+            TIMING,
+            // let the SIGPROF handler know which instruction is running
+            SAMPLING,
+
+        } Instrumentation;
+
+
+        // returns a reference to the requested register
+        long& getRegister(Registers reg);
+
+        // the dispatch loop, instantiated once for every engine and instrumentation
+        // uninstrumented instantiations pay nothing for the others
+        template <bool threaded, Instrumentation instrumentation>
+        Byte run(const std::vector<Instruction>& program);
+
+        // calls the run with a Trap armed on the memory
+        // a run that faults on a guard page is reported as a StackOverflowError
+        // the run can't own anything that needs destroying, its frames are left with siglongjmp()
+        template <typename Run>
+        Byte trapOverflows(Run run);
 
     public:
 
-        Pvm(size_t memSize);
+        Pvm(size_t memSize = PVM_DEFAULT_MEMORY_SIZE);
 
         // execute the given ByteCode in the PVM
+        // the byte code is decoded first
         // returns an exit code
-        Byte execute(const Byte* bytecode);
+        Byte execute(const ByteCode& byteCode, Engine engine = Engine::THREADED);
+
+        // execute an already decoded program in the PVM
+        // returns an exit code
+        Byte execute(const std::vector<Instruction>& program, Engine engine = Engine::THREADED);
+
+        // translate the program to native code and execute it
+        // programs the JIT can't translate are executed by the interpreter
+        // returns an exit code
+        Byte executeNative(const std::vector<Instruction>& program);
+
+        // brings the registers and the memory back to their initial state
+        // the memory is kept, so reusing a Pvm is cheaper than creating a new one
+        void reset();
+
+        // the value of a register, as left by the last execution
+        long getRegisterValue(Registers reg) const;
+
+        // the memory, as left by the last execution
+        const Memory& getMemory() const;
+
+        // prints the registers and the memory up to its last non-zero byte, as left by the last execution
+        // native executables run with -v print their state in the same format
+        void printState(std::ostream& stream) const;
+
+        // execute the given program while counting the executed instructions
+        // slower than execute(), meant for benchmarking the engines
+        Byte executeCounting(const std::vector<Instruction>& program, Engine engine);
+
+        // number of instructions executed by the last executeCounting() call
+        size_t getInstructionCount() const;
+
+        // execute the given program while timing every instruction
+        // much slower than execute(), see getProfile() for the results
+        Byte executeProfiling(const std::vector<Instruction>& program, Engine engine);
+
+        // statistics of the last executeProfiling() call, indexed like the program
+        const std::vector<InstructionProfile>& getProfile() const;
+
+        // execute the given program while sampling the running instruction
+        // a SIGPROF timer fires every interval microseconds of the calling thread's cpu time
+        // each thread samples its own run, several threads can sample at once
+        // only a store per instruction slower than execute(), see getSamples() for the results
+        Byte executeSampling(const std::vector<Instruction>& program, Engine engine, unsigned int interval);
+
+        // samples of the last executeSampling() call, indexed like the program
+        const std::vector<size_t>& getSamples() const;
 
     };
 
@@ -219,66 +537,277 @@ namespace pvm
     typedef unsigned char InstructionSize;
 
 
-    // node of doubly-linked list of instuctions
-    typedef struct ByteNode
+    // source location of a range of byte code
+    // stored as it is in the DEBUG section of executables
+    typedef struct LineEntry
     {
-        ByteNode* next;
-        ByteNode* prev;
+        // the range goes on until the offset of the next entry
+        uint64_t offset;
 
-        Value data;
-        InstructionSize dataSize; 
+        // both start at 1, a line of 0 means the location is unknown
+        uint32_t line;
+        uint32_t column;
 
-        ByteNode(OpCode data);
-        ByteNode(Registers data);
-        ByteNode(Value data, InstructionSize dataSize);       
+    } LineEntry;
 
-    } ByteNode;
 
+    // maps byte code offsets back to source locations
+    // a view of entries sorted by offset, nothing is copied
+    class LineTable
+    {
+    private:
+
+        const LineEntry* entries;
+        size_t count;
+
+    public:
+
+        LineTable(const LineEntry* entries, size_t count);
+        LineTable();
+
+        // returns the entry covering the given offset, nullptr if the location is unknown
+        const LineEntry* find(size_t offset) const;
+
+        bool isEmpty() const;
+
+    };
+
+
+    // an instruction of a ByteList, as seen by the optimization passes
+    typedef struct ListInstruction
+    {
+        // offset of the instruction before the pass
+        size_t offset;
+
+        bool isJumpTarget;
 
+        // the OpCode followed by its operands
+        const Byte* bytes;
+
+        OpCode opCode() const
+        {
+            return (OpCode) bytes[0];
+        }
+
+        // operands begin right after the OpCode
+        const Byte* operands() const
+        {
+            return bytes + 1;
+        }
+
+    } ListInstruction;
+
+
+    // contiguous, growable byte code emitter
     class ByteList
     {
     private:
 
-        ByteNode* start;
-        ByteNode* end;
+        // the emitted byte code
+        std::vector<Byte> bytes;
+
+        // offsets of the jump target operands in this list
+        // jump targets are relative to the beginning of the list they're in,
+        // they are relocated when the list is appended to another one
+        std::vector<size_t> jumpTargets;
 
-        size_t nodeCount;
-        size_t byteSize;
+        // source locations of the emitted byte code, sorted by offset
+        // relocated along with the jump targets
+        std::vector<LineEntry> lineTable;
+
+
+        // emits the instructions beginning at index i in their rewritten form
+        // returns the number of rewritten instructions, 0 to copy the instruction as it is
+        typedef std::function<size_t (const std::vector<ListInstruction>& instructions, size_t i, ByteList& output)> Rewriter;
+
+        // splits the list into instructions and marks the jump targets
+        // returns false if the list isn't a sequence of valid instructions
+        // or if any of its jumps can't be relocated
+        bool splitInstructions(std::vector<ListInstruction>& instructions) const;
+
+        // replaces the list with its instructions passed through the rewriter
+        // jump targets are updated to the new instruction offsets
+        void rewrite(const std::vector<ListInstruction>& instructions, const Rewriter& rewriter);
 
     public:
 
         ByteList();
-        
-        ~ByteList();
 
-        // add a new ByteNode to the list
-        // update nodeCount and byteSize counters
-        void add(ByteNode* node);
+        // append an OpCode to the list
+        void add(OpCode opCode);
+
+        // append a register operand to the list
+        void add(Registers reg);
+
+        // append the first dataSize bytes of data to the list
+        void add(Value data, InstructionSize dataSize);
+
+        // append a jump target operand to the list
+        // the target is an offset relative to the beginning of this list
+        // returns the offset of the operand, to be patched with setJumpTarget()
+        size_t addJumpTarget(size_t target = 0);
+
+        // patch the jump target operand at the given offset
+        void setJumpTarget(size_t operand, size_t target);
+
+        // byte code appended from now on comes from the given source location
+        void setLocation(uint32_t line, uint32_t column);
 
         // extends this ByteList with the elements of the other ByteList
+        // the other ByteList's jump targets are relocated
         // destructive for the other ByteList, don't use it afterwards
-        // updates nodeCount and byteSize counters
         void extend(ByteList& other);
 
-        // resets the ByteList to its default values
-        // - sets size counters to 0
-        // - sets pointers to nullptr
+        // resets the ByteList to an empty list
         void clear();
 
         ByteCode toByteCode() const;
 
+        // the line table in the layout of the DEBUG section of executables
+        ByteCode lineTableToByteCode() const;
+
+        // replaces common instruction sequences with fused instructions
+        // jump targets are updated to the new instruction offsets
+        // the list is left untouched if it can't be split into instructions
+        void fuseInstructions();
+
+        // keeps variables in the general purpose registers instead of memory
+        // the memory left by the program is the same as without allocation
+        // meant to run before fuseInstructions(), which fuses the register instructions
+        // the list is left untouched if it can't be split into instructions
+        void allocateRegisters();
+
 
         size_t getCurrentSize() const;
 
     };
 
 
-    // loads byte code from an executable file
-    ByteCode loadByteCode(const char* executable);
+    // EXECUTABLE FILES
+
+    // first bytes of every executable
+    #define PFX_MAGIC "\x7fPFX"
+    #define PFX_MAGIC_SIZE 4
+
+    // bumped whenever the executable layout changes
+    #define PFX_VERSION 1
+
+    // every section begins at a multiple of this many bytes
+    #define PFX_SECTION_ALIGNMENT 16
+
+
+    // sections of an executable, in file order
+    typedef enum class Section
+    {
+        // the byte code to execute
+        CODE,
+        // constant data referenced by the code
+        CONSTANTS,
+        // information for debuggers and profilers
+        DEBUG,
+
+    } Section;
+
+
+    #define SECTION_COUNT ((unsigned int) Section::DEBUG + 1)
+
+
+    // where a section lies in an executable file
+    typedef struct SectionEntry
+    {
+        // from the beginning of the file
+        uint64_t offset;
+        uint64_t size;
+
+    } SectionEntry;
+
+
+    // the first bytes of an executable file
+    typedef struct ExecutableHeader
+    {
+        char magic[PFX_MAGIC_SIZE];
+        uint32_t version;
+        // checksum of the header, computed with this field set to 0
+        uint32_t checksum;
+        uint32_t sectionCount;
+        SectionEntry sections[SECTION_COUNT];
+
+    } ExecutableHeader;
+
+
+    // an executable file mapped in memory
+    // sections are read straight from the mapping, nothing is copied
+    // invalid or truncated files are rejected
+    class Executable
+    {
+    private:
+
+        // the whole file
+        Byte* mapping;
+        size_t mappingSize;
+
+        const ExecutableHeader* header;
+
+    public:
+
+        Executable(const char* name);
+
+        ~Executable();
+
+        Executable(const Executable&) = delete;
+        Executable& operator=(const Executable&) = delete;
+
+
+        // returns a view of the requested section
+        // the view is valid as long as the Executable exists
+        ByteCode getSection(Section section) const;
+
+        // returns a view of the code section
+        ByteCode getByteCode() const;
+
+        // returns a view of the line table held in the debug section
+        // empty if the executable was built without one
+        LineTable getLineTable() const;
+
+    };
 
 
     // writes the byte code to an executable file
-    void generateExecutable(ByteCode byteCode, const char* name);
+    // the line table goes to the DEBUG section, it may be empty
+    void generateExecutable(ByteCode byteCode, ByteCode lineTable, const char* name);
+
+
+    // writes a standalone C translation of the byte code
+    // the generated program has a memory of the given size
+    void generateC(const ByteCode& byteCode, std::ostream& stream, size_t memorySize);
+
+
+    // writes the C translation of the byte code to a file
+    void generateCFile(const ByteCode& byteCode, const char* name, size_t memorySize);
+
+
+    // builds a native executable from the C translation of the byte code
+    // the C compiler is taken from the CC environment variable, cc by default
+    void generateNativeExecutable(const ByteCode& byteCode, const char* name, size_t memorySize);
+
+
+    // prints the statistics of a profiled run, per OpCode and per byte code offset
+    // the most expensive entries come first
+    void printProfile(const std::vector<Instruction>& program, const std::vector<InstructionProfile>& profile, std::ostream& stream);
+
+
+    // writes the statistics of a profiled run as tab separated values
+    void writeProfile(const std::vector<Instruction>& program, const std::vector<InstructionProfile>& profile, const char* name);
+
+
+    // prints the samples of a sampled run per source line, the hottest lines first
+    // falls back to byte code offsets when the line table is empty
+    void printSamples(const std::vector<Instruction>& program, const std::vector<size_t>& samples, const LineTable& lineTable, std::ostream& stream);
+
+
+    // writes the samples of a sampled run as folded stacks, the input format of flame graph tools
+    // every stack is made of the root frame followed by the source line
+    void writeFoldedSamples(const std::vector<Instruction>& program, const std::vector<size_t>& samples, const LineTable& lineTable, const char* root, const char* name);
 
 
 };
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "pch.hh"
+
+#include <algorithm>
+
+
+// vectorized scanners are only implemented for x86-64
+// other architectures always use the scalar one
+#if defined(__x86_64__)
+    #define SCANNER_SIMD 1
+#else
+    #define SCANNER_SIMD 0
+#endif
+
+
+// characters classified at a time, one bit of a mask each
+#define SCANNER_BLOCK_SIZE 64
+
+
+namespace scanner
+{
+
+    // instruction sets a Scanner can be built on
+    typedef enum class Isa
+    {
+        SCALAR,
+        SSE2,
+        AVX2,
+
+    } Isa;
+
+
+    // classes of SCANNER_BLOCK_SIZE characters as masks
+    // bit n of a mask is set if the nth character belongs to the class
+    typedef struct Block
+    {
+        // letters, digits and '_'
+        uint64_t name;
+
+        uint64_t digit;
+
+        // ' ', '\t', '\r' and ',', which only separate Tokens
+        // newlines aren't blanks, lines are counted by the caller
+        uint64_t blank;
+
+    } Block;
+
+
+    // classifies SCANNER_BLOCK_SIZE characters, all of them have to be readable
+    typedef void (*Classifier)(const char* chars, Block& block);
+
+
+    typedef struct Scanner
+    {
+        Isa isa;
+        const char* name;
+
+        Classifier classify;
+
+    } Scanner;
+
+
+    // the Scanner built on the instruction set, nullptr if the CPU doesn't support it
+    const Scanner* get(Isa isa);
+
+    // the fastest Scanner the CPU supports, chosen the first time it's requested
+    const Scanner& best();
+
+
+    // finds where runs of names, digits and blanks of a text end
+    // the text is classified a Block at a time, so finding the end of a run
+    // only takes a few bit operations
+    class Cursor
+    {
+    private:
+
+        const char* text;
+        size_t size;
+
+        Classifier classify;
+
+        // offset of the classified Block, a multiple of SCANNER_BLOCK_SIZE
+        size_t blockStart;
+        Block block;
+
+
+        // classifies the Block that begins at the offset
+        void load(size_t offset);
+
+
+        // the first character at or after the offset outside the class, or the size of the text
+        size_t skip(size_t offset, uint64_t Block::* mask)
+        {
+            while (offset < size)
+            {
+                const size_t start = offset & ~(size_t) (SCANNER_BLOCK_SIZE - 1);
+
+                if (start != blockStart)
+                {
+                    load(start);
+                }
+
+                // characters past the Block are shifted in as part of the class
+                const uint64_t outside = ~(block.*mask) >> (offset - start);
+
+                if (outside != 0)
+                {
+                    return std::min(offset + (size_t) __builtin_ctzll(outside), size);
+                }
+
+                offset = start + SCANNER_BLOCK_SIZE;
+            }
+
+            return size;
+        }
+
+    public:
+
+        // the text has to outlive the Cursor
+        Cursor(std::string_view text, const Scanner& scanner);
+
+
+        size_t skipName(size_t offset)
+        {
+            return skip(offset, &Block::name);
+        }
+
+        size_t skipDigits(size_t offset)
+        {
+            return skip(offset, &Block::digit);
+        }
+
+        size_t skipBlanks(size_t offset)
+        {
+            return skip(offset, &Block::blank);
+        }
+
+    };
+
+};
+
@@ -3,6 +3,7 @@
 #include "pch.hh"
 
 #include "token.hh"
+#include "interner.hh"
 #include "syntax_tree.hh"
 
 
@@ -27,18 +28,21 @@ namespace symbol_table
     } Symbol;
 
 
-    // an unordered map mapping a string (symbol name) to a Symbol
-    typedef std::unordered_map<std::string, Symbol* const> Table;
+    // an unordered map mapping an interned symbol name to a Symbol
+    typedef std::unordered_map<interner::StringId, Symbol* const> Table;
 
 
     // keeps track of the symbols in scope
     typedef struct Scope
     {
-        // outer table is optional since it can be undefined
-        // for independent scopes
-        std::optional<Table> outer;
+        // symbols declared in this scope
         Table local;
 
+        // enclosing Scope whose symbols are visible from this one
+        // nullptr for independent scopes
+        // outer Scopes are never copied, symbols are searched by walking the chain
+        const Scope* outer;
+
         // number of bytes to push to the stack when evaluating the scope
         size_t localSymbolsSize;
         // index where the scope begins on the stack
@@ -53,58 +57,68 @@ namespace symbol_table
         Scope();
 
         // initialize a new Scope that inherits from
-        // the previous Scope
-        Scope(const Table& _local, const std::optional<Table>& _outer);
+        // the given outer Scope and begins at the given stack index
+        Scope(const Scope* outer, size_t stackIndex);
 
         ~Scope();
 
     } Scope;
 
 
-    // Singleton
+    // keeps track of the scopes of a compilation
     class SymbolTable
     {
     private:
 
-        static size_t stackPointer;
+        // names the symbols in error messages
+        const interner::StringInterner& interner;
 
-        // references the first scope in the scopeStack
-        static Scope* globalScope;
+        size_t stackPointer;
 
-        static Scope* scopeStack;
+        // references the first scope in the scopeStack
+        Scope* globalScope;
 
-        SymbolTable() = delete;
+        Scope* scopeStack;
 
     public:
 
-        static void assign(std::string* identifier, Value newValue);
+        SymbolTable(const interner::StringInterner& interner);
+
+        // pops any scope left behind by a failed compilation
+        ~SymbolTable();
+
+        SymbolTable(const SymbolTable&) = delete;
+        SymbolTable& operator=(const SymbolTable&) = delete;
+
+
+        void assign(interner::StringId identifier, Value newValue);
 
 
-        static void declare(std::string* identifier, Symbol* symbol);
+        void declare(interner::StringId identifier, Symbol* symbol);
 
 
-        static void pushScope(bool inherits);
+        void pushScope(bool inherits);
 
 
-        static void popScope();
+        void popScope();
 
         
-        static Symbol* get(std::string* identifier);
+        Symbol* get(interner::StringId identifier) const;
 
 
         // returns the last Scope on the scopeStack
-        static const Scope* getScope();
+        const Scope* getScope() const;
 
         
         // initializes the SymbolTable
         // pushes the global scope
-        static void init();
+        void init();
 
 
-        // pops the global scope
-        static void clear();
+        // pops the global scope along with any scope left behind by a failed compilation
+        void clear();
 
-        static size_t getStackPointer();
+        size_t getStackPointer() const;
 
     };
 
@@ -112,9 +126,9 @@ namespace symbol_table
     typedef struct Parameter
     {
         Symbol symbol;
-        std::string name;
+        interner::StringId name;
 
-        Parameter(Symbol&& symbol, std::string&& name);
+        Parameter(Symbol&& symbol, interner::StringId name);
 
     } Parameter;
 
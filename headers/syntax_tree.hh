@@ -33,7 +33,9 @@ namespace syntax_tree
         Statement();
 
 
-        void remove(Tokens::Token* token, bool del = false);
+        // unlinks the token from the statement
+        // the token's memory is released along with the compilation's Arena
+        void remove(Tokens::Token* token);
 
 
         Tokens::Token* getLast() const;
@@ -64,10 +66,11 @@ namespace syntax_tree
 
     typedef struct ControlFlowNode
     {
-        pvm::ByteNode* byteNode;
+        // offset of the jump target operand in the tree's ByteList
+        size_t jumpTarget;
         OpCodes opCode;
 
-        ControlFlowNode(pvm::ByteNode* byteNode, OpCodes opCode);
+        ControlFlowNode(size_t jumpTarget, OpCodes opCode);
 
     } ControlFlowNode;
 
@@ -80,12 +83,19 @@ namespace syntax_tree
 
         Statements statements;
 
-        // stores pointers to the ByteNodes of flow control operators such as
+        // owns the Tokens, Statements and operand arrays of the compilation
+        // along with its symbols, shared with the trees of nested scopes
+        compilation::Context* context;
+
+        // stores the jump target operands of flow control operators such as
         // "break" and "continue"
         std::vector<ControlFlowNode> controlFlowNodes;
 
 
         // constructs the SyntaxTree of the given Statement
+        // Tokens are satisfied from the highest priority to the lowest, leftmost first
+        // function declarations are satisfied before anything else
+        // Tokens past a scope are considered only after the scope is satisfied
         void parseStatement(Statement* statement);
 
         // satisfy the requirements of a Token
@@ -119,14 +129,16 @@ namespace syntax_tree
         
         SyntaxTree();
         SyntaxTree(Tokens::TokenList& tokens);
-        SyntaxTree(Statements&& statements);
-       
-        // returns the token with the highest priority in the statement
-        // does not check for empty statements
-        Tokens::Token* getHighestPriority(Tokens::Token* root);
+        SyntaxTree(Statements&& statements, compilation::Context* context);
 
+        // releases the compilation's Arena once the byte code is generated
+        // the Tokens the tree was built from can't be accessed anymore afterwards
         pvm::ByteCode parseToByteCode();
 
+        // the source locations of the byte code returned by parseToByteCode()
+        // in the layout of the DEBUG section of executables
+        pvm::ByteCode lineTableToByteCode() const;
+
     };
 
 
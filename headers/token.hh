@@ -3,6 +3,8 @@
 #include "pch.hh"
 
 #include "utils.hh"
+#include "arena.hh"
+#include "interner.hh"
 #include "op_codes.hh"
 
 
@@ -11,6 +13,15 @@
 #define isText(x) ((64 < x && x < 91) || (x == '_') || (96 < x && x < 123))
 
 
+// PREDECLARATIONS
+
+namespace compilation { class Context; };
+
+namespace symbol_table { class SymbolTable; };
+
+namespace preprocessor { class Output; };
+
+
 namespace Tokens 
 {
 
@@ -69,11 +80,18 @@ namespace Tokens
         Token* prev = nullptr;
         Token* next = nullptr;
 
+        // where the Token begins in the script, both start at 1
+        // 0 for Tokens that don't come from the script
+        uint32_t line = 0;
+        uint32_t column = 0;
+
+        // name of the symbol referenced by TEXT Tokens, viewing the interned string
+        // characters of STRING literals, viewing the script
+        std::string_view name;
+
         Token(TokenType type, size_t priority, OpCodes opCode, Value value);
         Token(TokenType type, size_t priority, OpCodes opCode);
 
-        ~Token();
-
         // removes the token from where it is located
         // data-structure specific methods are preferred to this
         static void removeToken(Token* token);
@@ -82,20 +100,29 @@ namespace Tokens
 
 
     // doubly-linked list of Tokens
+    // Tokens are allocated in the compilation's Arena, string literals view
+    // the script, which has to outlive them
     class TokenList
     {
     public:
         Token* first = nullptr;
         Token* last = nullptr;
+
+        // owns the Tokens of the list and the names they reference
+        compilation::Context* context;
         
 
-        TokenList(std::string& script);
+        // the preprocessor Output the script was copied from gives Tokens
+        // the lines of the file they come from, instead of the script's ones
+        // the script doesn't need a null terminator, it may view a mapped file
+        TokenList(std::string_view script, compilation::Context& context, const preprocessor::Output* source = nullptr);
 
         // adds the Token to the doubly-linked list 
         void add(Token* token);
 
         // removes the specified Token from the doubly-linked list
         // does not check if token is actually in list
+        // the Token's memory is released along with the Arena
         void remove(Token* token);
 
     };
@@ -106,7 +133,7 @@ namespace Tokens
     - returns the TokenType of it's value if token is a variable
     - throws exception if token is not declared
     */
-    TokenType tokenTypeOf(const Token* token);
+    TokenType tokenTypeOf(const Token* token, const symbol_table::SymbolTable& symbolTable);
 
 
     // copies all releveant data during parsing from a token to another
@@ -15,9 +15,39 @@ typedef unsigned long Value;
 namespace file_utils
 {
 
-    // loads a file in the string
-    // returns true if successful, false if not
-    bool loadFile(const char* path, std::string& output);
+    // the read-only content of a source file
+    // regular files are mapped in memory, anything else, like a pipe, is read
+    // once into a string
+    class SourceBuffer
+    {
+    private:
+
+        // nullptr if the file isn't mapped
+        char* mapping;
+        size_t mappingSize;
+
+        // the content of files that can't be mapped
+        std::string content;
+
+    public:
+
+        // reports a FileReadError if the file can't be opened or read
+        SourceBuffer(const char* path);
+
+        ~SourceBuffer();
+
+        SourceBuffer(const SourceBuffer&) = delete;
+        SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+
+        // the view is valid as long as the SourceBuffer exists
+        // the content isn't followed by a null character
+        std::string_view getView() const;
+
+        // whether the content is read from the file only when accessed
+        bool isMapped() const;
+
+    };
 
 };
 
@@ -39,7 +69,5 @@ namespace globals
 
     extern const char* INCLUDE_PATH;
 
-    extern bool doOptimize;
-
 };
 
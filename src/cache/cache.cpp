@@ -0,0 +1,243 @@
+#include "cache.hh"
+#include "errors.hh"
+
+#include <filesystem>
+#include <iomanip>
+#include <thread>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+using namespace cache;
+
+
+#define FNV_OFFSET_BASIS 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*) data;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+
+// a name for temporary files that no other thread or process uses
+static std::string temporarySuffix()
+{
+    std::ostringstream suffix;
+    suffix << ".tmp." << getpid() << '.' << std::this_thread::get_id();
+
+    return suffix.str();
+}
+
+
+// writes the content to a temporary file and renames it to the given path
+// returns false if anything fails
+static bool writeAtomically(const std::string& path, const std::string& content)
+{
+    const std::string temporary = path + temporarySuffix();
+
+    std::ofstream file(temporary);
+    file << content;
+    file.close();
+
+    std::error_code error;
+
+    if (file.fail())
+    {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    std::filesystem::rename(temporary, path, error);
+
+    return !error;
+}
+
+
+Cache::Cache(const std::string& directory)
+: directory(directory), usable(false), session(), sessionLock()
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    usable = !error && access(directory.c_str(), W_OK | X_OK) == 0;
+}
+
+
+bool Cache::isUsable() const
+{
+    return usable;
+}
+
+
+std::string Cache::defaultDirectory()
+{
+    const char* home = getenv("XDG_CACHE_HOME");
+
+    if (home != nullptr && *home != '\0')
+    {
+        return std::string(home) + "/pcc";
+    }
+
+    home = getenv("HOME");
+
+    if (home != nullptr && *home != '\0')
+    {
+        return std::string(home) + "/.cache/pcc";
+    }
+
+    return "/tmp/pcc-cache";
+}
+
+
+std::string Cache::entryPath(const Key& key, const char* extension) const
+{
+    std::ostringstream path;
+    path << directory << '/' << std::hex << std::setfill('0') << std::setw(16) << key.hash << '-' << key.size << extension;
+
+    return path.str();
+}
+
+
+Key Cache::keyOf(std::string_view script, bool optimize) const
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    // the compiler is identified by the size and modification time of its executable
+    struct stat compiler = {};
+    stat("/proc/self/exe", &compiler);
+
+    hash = hashBytes(hash, &compiler.st_size, sizeof(compiler.st_size));
+    hash = hashBytes(hash, &compiler.st_mtim, sizeof(compiler.st_mtim));
+
+    const uint32_t version = PFX_VERSION;
+    hash = hashBytes(hash, &version, sizeof(version));
+
+    hash = hashBytes(hash, &optimize, sizeof(optimize));
+
+    hash = hashBytes(hash, script.data(), script.size());
+
+    return Key { hash, script.size() };
+}
+
+
+bool Cache::fetch(const Key& key, const char* outputName)
+{
+    std::ifstream entry(entryPath(key, ".pfx"), std::ios::binary);
+
+    if (!entry.is_open())
+    {
+        const std::lock_guard<std::mutex> lock(sessionLock);
+        session.misses ++;
+
+        return false;
+    }
+
+    std::ofstream output(outputName, std::ios::binary);
+
+    if (!output.is_open())
+    {
+        errors::FileWriteError(outputName);
+    }
+
+    output << entry.rdbuf();
+    output.close();
+
+    if (output.fail())
+    {
+        errors::FileWriteError(outputName);
+    }
+
+    // an entry without its compilation time still counts as a hit
+    uint64_t compileMicros = 0;
+    std::ifstream(entryPath(key, ".time")) >> compileMicros;
+
+    const std::lock_guard<std::mutex> lock(sessionLock);
+    session.hits ++;
+    session.savedMicros += compileMicros;
+
+    return true;
+}
+
+
+void Cache::store(const Key& key, const pvm::ByteCode& byteCode, const pvm::ByteCode& lineTable, uint64_t compileMicros)
+{
+    // the time is written first, the executable completes the entry
+    if (!writeAtomically(entryPath(key, ".time"), std::to_string(compileMicros)))
+    {
+        return;
+    }
+
+    const std::string path = entryPath(key, ".pfx");
+    const std::string temporary = path + temporarySuffix();
+
+    errors::Capture capture;
+
+    try
+    {
+        pvm::generateExecutable(byteCode, lineTable, temporary.c_str());
+    }
+    catch (const errors::Error&)
+    {
+        std::error_code error;
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+}
+
+
+Statistics Cache::saveStatistics()
+{
+    const std::string path = directory + "/" CACHE_STATISTICS_FILE;
+
+    Statistics total;
+    std::ifstream(path) >> total.hits >> total.misses >> total.savedMicros;
+
+    const Statistics current = getSession();
+    total.hits += current.hits;
+    total.misses += current.misses;
+    total.savedMicros += current.savedMicros;
+
+    // concurrent processes may overwrite each other's counts, never the file's format
+    writeAtomically(path, std::to_string(total.hits) + " " + std::to_string(total.misses) + " " + std::to_string(total.savedMicros) + "\n");
+
+    return total;
+}
+
+
+Statistics Cache::getSession()
+{
+    const std::lock_guard<std::mutex> lock(sessionLock);
+
+    return session;
+}
+
+
+std::ostream& operator<<(std::ostream& stream, const cache::Statistics& statistics)
+{
+    const size_t lookups = statistics.hits + statistics.misses;
+    const double hitRate = lookups == 0 ? 0.0 : 100.0 * (double) statistics.hits / (double) lookups;
+
+    const std::ios_base::fmtflags flags = stream.flags();
+
+    stream << statistics.hits << " hits, " << statistics.misses << " misses, "
+        << std::fixed << std::setprecision(2) << hitRate << "% hit rate, "
+        << (double) statistics.savedMicros / 1000.0 << " ms of compilation saved";
+
+    stream.flags(flags);
+
+    return stream;
+}
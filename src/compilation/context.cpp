@@ -0,0 +1,40 @@
+#include "context.hh"
+#include "syntax_tree.hh"
+
+
+using namespace compilation;
+
+
+Context::Context(bool optimize)
+: arena(), interner(), symbolTable(interner), optimize(optimize), scanner(&scanner::best()), scopeTrees()
+{
+
+}
+
+
+// the SyntaxTree destructor is only visible here
+Context::~Context() = default;
+
+
+syntax_tree::SyntaxTree* Context::addScopeTree(std::unique_ptr<syntax_tree::SyntaxTree> tree)
+{
+    scopeTrees.push_back(std::move(tree));
+
+    return scopeTrees.back().get();
+}
+
+
+void Context::releaseScopeTree(syntax_tree::SyntaxTree* tree)
+{
+    // trees are used soon after they're made, so the search starts from the last one
+    for (size_t i = scopeTrees.size(); i != 0; i--)
+    {
+        if (scopeTrees[i - 1].get() == tree)
+        {
+            std::swap(scopeTrees[i - 1], scopeTrees.back());
+            scopeTrees.pop_back();
+            return;
+        }
+    }
+}
+
@@ -1,130 +1,310 @@
 #include "errors.hh"
 
 
-void errors::UnexpectedBehaviourError(const std::string& message)
+// whether errors of the current thread are captured instead of ending the process
+static thread_local bool capturing = false;
+
+
+errors::Capture::Capture()
+: previous(capturing)
+{
+    capturing = true;
+}
+
+
+errors::Capture::~Capture()
+{
+    capturing = previous;
+}
+
+
+// reports the error, either by throwing it or by printing it and exiting
+[[noreturn]] static void fail(const std::ostringstream& message)
 {
-    std::cerr << "[Unexpected Behaviour Error] " << message << std::endl;
+    if (capturing)
+    {
+        throw errors::Error(message.str());
+    }
+
+    std::cerr << message.str() << std::endl;
     exit(EXIT_FAILURE);
 }
 
 
+void errors::UnexpectedBehaviourError(const std::string& message)
+{
+    std::ostringstream error;
+    error << "[Unexpected Behaviour Error] " << message;
+    fail(error);
+}
+
+
 void errors::SyntaxError(const std::string& message)
 {
-    std::cerr << "[Syntax Error] " << message << std::endl;
-    exit(EXIT_FAILURE);
+    std::ostringstream error;
+    error << "[Syntax Error] " << message;
+    fail(error);
 }
 
 
 void errors::TypeError(const Tokens::Token& caller, Tokens::TokenType expected, const Tokens::Token& provided, const char* side)
 {
-    std::cerr << "[Type Error] Expected type "
+    std::ostringstream error;
+    error << "[Type Error] Expected type "
         << expected << " to the " << side << " of " << caller
-        << ", but " << provided << " was provided" << std::endl;
-    exit(EXIT_FAILURE);
+        << ", but " << provided << " was provided";
+    fail(error);
 }
 
 
 void errors::TypeError(const Tokens::Token& caller, OpCodes expected, const Tokens::Token& provided, const char* side)
 {
-    std::cerr << "[Type Error] Expected type "
+    std::ostringstream error;
+    error << "[Type Error] Expected type "
         << expected << " to the " << side << " of " << caller
-        << ", but " << provided << " was provided" << std::endl;
-    exit(EXIT_FAILURE);
+        << ", but " << provided << " was provided";
+    fail(error);
 }
 
 
 void errors::IncompatibleSizeError(const Tokens::Token& caller, Tokens::TokenType expected, Tokens::TokenType providedType, size_t providedSize)
 {
-    std::cerr << "[Incompatible Size Error] Token " << caller << " requires an operand of type "
+    std::ostringstream error;
+    error << "[Incompatible Size Error] Token " << caller << " requires an operand of type "
         << expected << ", but " << providedType << " with an incompatible size of " << providedSize
-        << " was provided" << std::endl;
-    exit(EXIT_FAILURE);
+        << " was provided";
+    fail(error);
 }
 
 
 void errors::SymbolRedeclarationError(const std::string& name, const symbol_table::Symbol& symbol)
 {
-    std::cerr << "[Symbol Redeclaration Error] Symbol \"" << name << "\" "
-         << symbol << " has been redeclared in local scope" << std::endl;
-    exit(EXIT_FAILURE);
+    std::ostringstream error;
+    error << "[Symbol Redeclaration Error] Symbol \"" << name << "\" "
+         << symbol << " has been redeclared in local scope";
+    fail(error);
 }
 
 
 void errors::UndefinedSymbolError(const std::string& name)
 {
-    std::cerr << "[Undefined Symbol Error] Symbol name " << name
-        << " hasn't been declared in any reachable scope" << std::endl;
-    exit(EXIT_FAILURE);
+    std::ostringstream error;
+    error << "[Undefined Symbol Error] Symbol name " << name
+        << " hasn't been declared in any reachable scope";
+    fail(error);
 }
 
 
 void errors::InvalidCharacterError(const std::string& line, char character)
 {
-    std::cerr << "[Invalid Character Error] Invalid character '" << character
-        << "' in line:\n" << line << std::endl;
-    exit(EXIT_FAILURE);
+    std::ostringstream error;
+    error << "[Invalid Character Error] Invalid character '" << character
+        << "' in line:\n" << line;
+    fail(error);
 }
 
 
 void errors::ExpectedTokenError(const Tokens::Token& caller, Tokens::TokenType expected, const char* side)
 {
-    std::cerr << "[Expected Token Error] Expected type " << expected
-        << " to the " << side << " of " << caller << std::endl;
-    exit(EXIT_FAILURE);
+    std::ostringstream error;
+    error << "[Expected Token Error] Expected type " << expected
+        << " to the " << side << " of " << caller;
+    fail(error);
 }
 
 
 void errors::ExpectedTokenError(const Tokens::Token& caller, OpCodes expected, const char* side)
 {
-    std::cerr << "[Expected Token Error] Expected type " << expected
-        << " to the " << side << " of " << caller << std::endl;
-    exit(EXIT_FAILURE);
+    std::ostringstream error;
+    error << "[Expected Token Error] Expected type " << expected
+        << " to the " << side << " of " << caller;
+    fail(error);
 }
 
 
 void errors::ZeroDivisionError(const Tokens::Token& caller, const Tokens::Token& op1, const Tokens::Token& op2)
 {
-    std::cerr << "[Zero Division Error] Zero division performed by operator "
-        << caller << " on operands: " << op1 << ", " << op2 << std::endl;
-    exit(EXIT_FAILURE);
+    std::ostringstream error;
+    error << "[Zero Division Error] Zero division performed by operator "
+        << caller << " on operands: " << op1 << ", " << op2;
+    fail(error);
+}
+
+
+void errors::ZeroDivisionError(long dividend)
+{
+    std::ostringstream error;
+    error << "[Zero Division Error] the program divided " << dividend << " by 0";
+    fail(error);
+}
+
+
+void errors::DivisionOverflowError()
+{
+    std::ostringstream error;
+    error << "[Division Overflow Error] the program divided the smallest long by -1, the quotient doesn't fit in a long";
+    fail(error);
 }
 
 
 void errors::InvalidPreprocessorError(const char* name)
 {
-    std::cerr << "[Invalid Preprocessor Error] \"" << name
-        << "\" is not a preprocessor " << std::endl;
-    exit(EXIT_FAILURE);
+    std::ostringstream error;
+    error << "[Invalid Preprocessor Error] \"" << name
+        << "\" is not a preprocessor ";
+    fail(error);
 }
 
 
 void errors::InvalidIncludeEnclosureError(char c)
 {
-    std::cerr << "[Invalid Include Enclosure Error] Character '" << c
-        << "' is not a valid file name enclosure. Please use either '</>' or '\"/\"'" << std::endl;
-    exit(EXIT_FAILURE);
+    std::ostringstream error;
+    error << "[Invalid Include Enclosure Error] Character '" << c
+        << "' is not a valid file name enclosure. Please use either '</>' or '\"/\"'";
+    fail(error);
+}
+
+
+void errors::RecursiveIncludeError(const char* file)
+{
+    std::ostringstream error;
+    error << "[Recursive Include Error] File \"" << file
+        << "\" includes itself, add #pragma once to include it only the first time";
+    fail(error);
+}
+
+
+void errors::InvalidMacroNameError(const char* name)
+{
+    std::ostringstream error;
+    error << "[Invalid Macro Name Error] \"" << name
+        << "\" is not a valid macro name, names are made of letters, digits and '_' and don't begin with a digit";
+    fail(error);
+}
+
+
+void errors::UnmatchedConditionalError(const char* directive)
+{
+    std::ostringstream error;
+    error << "[Unmatched Conditional Error] #" << directive
+        << " has no matching #ifdef or #ifndef";
+    fail(error);
+}
+
+
+void errors::UnterminatedConditionalError(const char* file, uint32_t line)
+{
+    std::ostringstream error;
+    error << "[Unterminated Conditional Error] The conditional at line " << line
+        << " of " << file << " is never closed by #endif";
+    fail(error);
 }
 
 
 void errors::FileReadError(const char* file)
 {
-    std::cerr << "[File Read Error] Could not read file \"" << file << '"' << std::endl;
-    exit(EXIT_FAILURE);
+    std::ostringstream error;
+    error << "[File Read Error] Could not read file \"" << file << '"';
+    fail(error);
 }
 
 
 void errors::FileWriteError(const char* file)
 {
-    std::cerr << "[File Write Error] Could not write to file \"" << file << '"' << std::endl;
-    exit(EXIT_FAILURE);
+    std::ostringstream error;
+    error << "[File Write Error] Could not write to file \"" << file << '"';
+    fail(error);
 }
 
 
 void errors::MissingClosingParenthesisError(const Tokens::Token& caller, const std::string& message)
 {
-    std::cerr << "[Missing Closing Parenthesis Error] Missing closing parenthesis required by "
-        << caller << '\n' << message << std::endl;
-    exit(EXIT_FAILURE);
+    std::ostringstream error;
+    error << "[Missing Closing Parenthesis Error] Missing closing parenthesis required by "
+        << caller << '\n' << message;
+    fail(error);
+}
+
+
+void errors::MissingClosingScopeError(const Tokens::Token& caller)
+{
+    std::ostringstream error;
+    error << "[Missing Closing Scope Error] The scope opened by " << caller
+        << " is never closed, the script ends before its closing '}'";
+    fail(error);
+}
+
+
+void errors::MissingStatementError(const Tokens::Token& caller, const char* message)
+{
+    std::ostringstream error;
+    error << "[Missing Statement Error] " << message << ' ' << caller;
+    fail(error);
+}
+
+
+void errors::NotImplementedError(const Tokens::Token& caller)
+{
+    std::ostringstream error;
+    error << "[Not Implemented Error] " << caller << " is not implemented";
+    fail(error);
+}
+
+
+void errors::UndefinedTokenError(const Tokens::Token& token)
+{
+    std::ostringstream error;
+    error << "[Undefined Token Error] <type=" << token.type << ", value=" << token.value
+        << ", opCode=" << token.opCode << ", priority=" << token.priority << '>';
+    fail(error);
 }
 
 
+void errors::InvalidByteCodeError(const std::string& message)
+{
+    std::ostringstream error;
+    error << "[Invalid Byte Code Error] " << message;
+    fail(error);
+}
+
+
+void errors::InvalidExecutableError(const char* file, const std::string& message)
+{
+    std::ostringstream error;
+    error << "[Invalid Executable Error] \"" << file << "\": " << message;
+    fail(error);
+}
+
+
+void errors::OutOfMemoryError(size_t size)
+{
+    std::ostringstream error;
+    error << "[Out Of Memory Error] could not reserve " << size << " bytes of PVM memory";
+    fail(error);
+}
+
+
+void errors::StackOverflowError()
+{
+    std::ostringstream error;
+    error << "[Stack Overflow Error] the program ran out of memory, use -m to give it more";
+    fail(error);
+}
+
+
+void errors::InsufficientMemoryError(size_t required, size_t available)
+{
+    std::ostringstream error;
+    error << "[Insufficient Memory Error] the program needs at least " << required
+        << " bytes of memory, but only " << available << " are available, use -m to give it more";
+    fail(error);
+}
+
+
+void errors::CCompilerError(const char* compiler)
+{
+    std::ostringstream error;
+    error << "[C Compiler Error] \"" << compiler << "\" could not build the C translation";
+    fail(error);
+}
+
@@ -0,0 +1,109 @@
+#include "libpcc.hh"
+#include "syntax_tree.hh"
+#include "context.hh"
+#include "preprocessor.hh"
+#include "errors.hh"
+
+
+using namespace pcc;
+
+
+pvm::ByteCode Compilation::getByteCode()
+{
+    return pvm::ByteCode(byteCode.data(), byteCode.size());
+}
+
+
+pvm::ByteCode Compilation::getLineTable()
+{
+    return pvm::ByteCode(lineTable.data(), lineTable.size());
+}
+
+
+// moves a ByteCode allocated by the compiler to a buffer
+static std::vector<pvm::Byte> toBuffer(pvm::ByteCode byteCode)
+{
+    std::vector<pvm::Byte> buffer(byteCode.byteCode, byteCode.byteCode + byteCode.size);
+
+    delete[] byteCode.byteCode;
+
+    return buffer;
+}
+
+
+// runs the compilation with errors captured, they're returned as Diagnostics
+template <typename Function>
+static Result<Compilation, Diagnostics> capture(Function function)
+{
+    errors::Capture capture;
+
+    try
+    {
+        return function();
+    }
+    catch (const errors::Error& error)
+    {
+        return Diagnostics { Diagnostic { error.what() } };
+    }
+    catch (const std::bad_alloc&)
+    {
+        // same message as libpvm's
+        return Diagnostics { Diagnostic { "[Out Of Memory Error] could not allocate memory" } };
+    }
+}
+
+
+// tokenizes and parses the preprocessed script
+static Compilation compileScript(std::string_view script, const preprocessor::Output& output, const Options& options)
+{
+    Compilation compilation;
+
+    // released along with everything it owns when the call returns
+    compilation::Context context(options.optimize);
+
+    Tokens::TokenList tokens = Tokens::TokenList(script, context, &output);
+
+    syntax_tree::SyntaxTree syntaxTree = syntax_tree::SyntaxTree(tokens);
+
+    compilation.byteCode = toBuffer(syntaxTree.parseToByteCode());
+    compilation.lineTable = toBuffer(syntaxTree.lineTableToByteCode());
+
+    return compilation;
+}
+
+
+Result<Compilation, Diagnostics> pcc::compile(std::string_view source, const Options& options)
+{
+    return capture([&]()
+    {
+        preprocessor::Preprocessor preprocessor;
+
+        for (const Macro& macro : options.macros)
+        {
+            preprocessor.define(macro.name, macro.value);
+        }
+
+        const preprocessor::Output output = preprocessor.process(source);
+
+        // a script without directives is tokenized where it is, not copied
+        std::string preprocessed;
+
+        if (preprocessor.changes(output))
+        {
+            preprocessed = output.toString();
+        }
+
+        const std::string_view script = preprocessor.changes(output) ? std::string_view(preprocessed) : source;
+
+        return compileScript(script, output, options);
+    });
+}
+
+
+Result<Compilation, Diagnostics> pcc::compile(std::string_view script, const preprocessor::Output& output, const Options& options)
+{
+    return capture([&]()
+    {
+        return compileScript(script, output, options);
+    });
+}
@@ -0,0 +1,137 @@
+#include "libpvm.h"
+#include "pvm.hh"
+#include "errors.hh"
+
+
+using namespace pvm;
+
+
+struct PvmProgram
+{
+    std::vector<Instruction> instructions;
+};
+
+
+struct PvmInstance
+{
+    Pvm pvm;
+
+    PvmInstance(size_t memorySize)
+    :   pvm(memorySize)
+    {
+
+    }
+};
+
+
+// description of the last error of each thread
+static thread_local std::string lastError;
+
+
+// runs the given function with errors captured
+// errors are stored for pvm_last_error() instead of ending the process
+template <typename Function>
+static PvmStatus capture(Function function)
+{
+    errors::Capture capture;
+
+    try
+    {
+        function();
+    }
+    catch (const errors::Error& error)
+    {
+        lastError = error.what();
+        return PVM_ERROR;
+    }
+    catch (const std::bad_alloc&)
+    {
+        lastError = "[Out Of Memory Error] could not allocate memory";
+        return PVM_ERROR;
+    }
+
+    return PVM_OK;
+}
+
+
+unsigned int pvm_api_version(void)
+{
+    return PVM_API_VERSION;
+}
+
+
+PvmStatus pvm_load_executable(const char* name, PvmProgram** program)
+{
+    return capture([&]() {
+        const Executable executable = Executable(name);
+
+        // the instructions are decoded, so the mapping isn't needed afterwards
+        *program = new PvmProgram { decode(executable.getByteCode()) };
+    });
+}
+
+
+PvmStatus pvm_load_byte_code(const uint8_t* byteCode, size_t size, PvmProgram** program)
+{
+    return capture([&]() {
+        // decoding only reads the byte code
+        *program = new PvmProgram { decode(ByteCode((Byte*) byteCode, size)) };
+    });
+}
+
+
+void pvm_free_program(PvmProgram* program)
+{
+    delete program;
+}
+
+
+PvmStatus pvm_create_instance(size_t memorySize, PvmInstance** instance)
+{
+    return capture([&]() {
+        *instance = new PvmInstance(memorySize == 0 ? PVM_DEFAULT_MEMORY_SIZE : memorySize);
+    });
+}
+
+
+void pvm_free_instance(PvmInstance* instance)
+{
+    delete instance;
+}
+
+
+PvmStatus pvm_run(PvmInstance* instance, const PvmProgram* program, uint8_t* exitCode)
+{
+    return capture([&]() {
+        instance->pvm.reset();
+
+        *exitCode = instance->pvm.execute(program->instructions);
+    });
+}
+
+
+long pvm_get_register(const PvmInstance* instance, unsigned int reg)
+{
+    if (reg >= REGISTER_COUNT)
+    {
+        return 0;
+    }
+
+    return instance->pvm.getRegisterValue((Registers) reg);
+}
+
+
+const uint8_t* pvm_get_memory(const PvmInstance* instance, size_t* size)
+{
+    const Memory& memory = instance->pvm.getMemory();
+
+    *size = memory.getSize();
+
+    return memory.getBase();
+}
+
+
+const char* pvm_last_error(void)
+{
+    return lastError.c_str();
+}
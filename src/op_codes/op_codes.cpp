@@ -83,6 +83,7 @@ OpType operatorType(OpCodes op)
     switch (op)
     {
     case OpCodes::LOGICAL_AND:
+    case OpCodes::LOGICAL_OR:
     case OpCodes::LOGICAL_NOT_EQ:
     case OpCodes::LOGICAL_EQ:
     case OpCodes::LOGICAL_GREATER:
@@ -1,19 +1,47 @@
 #include "token.hh"
 #include "syntax_tree.hh"
 #include "preprocessor.hh"
+#include "context.hh"
+#include "libpcc.hh"
+#include "cache.hh"
 #include "errors.hh"
+#include "jit.hh"
 
 #include "pch.hh"
 
 #include "argparser.hh"
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 
 typedef struct Options
 {
 	const char* fileName = nullptr;
 	const char* outputName = nullptr;
+	const char* engine = nullptr;
+	const char* memory = nullptr;
+	const char* target = nullptr;
+	const char* jobs = nullptr;
+	const char* cacheDirectory = nullptr;
+	// only listed by the help, every -D is taken out of argv before parsing
+	const char* macro = nullptr;
+	bool optimize;
 	bool execute;
 	bool verbose;
+	bool benchmark;
+	bool jit;
+	bool profile;
+	bool sample;
+	bool cache;
+	bool cacheStatistics;
+
+	// every source file, fileName included
+	std::vector<const char*> fileNames;
+
+	// every -D, in order
+	std::vector<pcc::Macro> macros;
 
 } Options;
 
@@ -21,13 +49,13 @@ typedef struct Options
 static void initParser(argparser::Parser* parser, Options& options)
 {
 	*parser = argparser::Parser(
-		5,
+		17,
 		"Permalang Compiler Collection\n"
 		"For anything email nchlsuba@gmail.com"
 	);
 
 	parser->addBoolImplicit(
-		"-O", &globals::doOptimize, false,
+		"-O", &options.optimize, false,
 		"apply optimizations to compiled byte code");
 
 	parser->addStringPositional(
@@ -44,8 +72,552 @@ static void initParser(argparser::Parser* parser, Options& options)
 
 	parser->addBoolImplicit(
 		"-v", &options.verbose, false,
-		"verbose compilation");
+		"verbose compilation, prints the registers and the memory left by executed programs");
+
+	parser->addString(
+		"-e", &options.engine, false,
+		"execution engine, either \"switch\" or \"threaded\" (default)");
+
+	parser->addBoolImplicit(
+		"-b", &options.benchmark, false,
+		"execute the specified file with every engine and report instructions per second");
+
+	parser->addString(
+		"-m", &options.memory, false,
+		"PVM memory size in bytes, accepts K, M and G suffixes (default 8M)");
+
+	parser->addBoolImplicit(
+		"--jit", &options.jit, false,
+		"translate the specified file to native code before executing it, falls back to the engine if unsupported");
+
+	parser->addString(
+		"-t", &options.target, false,
+		"compilation target, either \"pfx\" (default), \"c\" for a C translation or \"native\" for a native executable built by $CC");
+
+	parser->addBoolImplicit(
+		"--profile", &options.profile, false,
+		"execute the specified file while timing every instruction, then report the hottest ones and write them to <file>.profile");
+
+	parser->addBoolImplicit(
+		"--sample", &options.sample, false,
+		"execute the specified file while sampling it, then report the hottest source lines and write folded stacks to <file>.folded");
+
+	parser->addString(
+		"-j", &options.jobs, false,
+		"number of files compiled at the same time, any source file after the first one is compiled along with it (default 1)");
+
+	parser->addBoolImplicit(
+		"--cache", &options.cache, false,
+		"reuse the executables of scripts compiled before, the cache is keyed by the preprocessed script, -O and the compiler build");
+
+	parser->addString(
+		"--cache-dir", &options.cacheDirectory, false,
+		"directory of the compilation cache, implies --cache (default $XDG_CACHE_HOME/pcc or ~/.cache/pcc)");
+
+	parser->addBoolImplicit(
+		"--cache-stats", &options.cacheStatistics, false,
+		"report the hit rate of the compilation cache and the compilation time it saved");
+
+	parser->addString(
+		"-D", &options.macro, false,
+		"define a macro as NAME=VALUE before preprocessing, NAME alone defines it as 1, may be repeated");
+
+}
+
+
+// options that are followed by a value
+static const char* const valueOptions[] =
+{
+	"-o",
+	"-e",
+	"-m",
+	"-t",
+	"-j",
+	"--cache-dir",
+};
+
+
+static bool takesValue(const char* argument)
+{
+	for (const char* option : valueOptions)
+	{
+		if (strcmp(argument, option) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+// the parser keeps a single value per option, so every -D NAME=VALUE or
+// -DNAME=VALUE is removed from argv and added to the macros
+// returns the number of arguments left
+static int extractMacros(int argc, const char** argv, std::vector<pcc::Macro>& macros)
+{
+	int kept = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* argument = argv[i];
+
+		if (strncmp(argument, "-D", 2) != 0)
+		{
+			argv[kept++] = argument;
+			continue;
+		}
+
+		const char* definition = argument + 2;
+
+		if (*definition == '\0')
+		{
+			if (i + 1 == argc)
+			{
+				std::cerr << "Missing macro after -D" << std::endl;
+				exit(EXIT_FAILURE);
+			}
+
+			definition = argv[++i];
+		}
+
+		const char* const equals = strchr(definition, '=');
+
+		macros.push_back(equals == nullptr
+			? pcc::Macro { definition, "1" }
+			: pcc::Macro { std::string(definition, equals), equals + 1 });
+	}
+
+	return kept;
+}
+
+
+// the parser accepts a single source file, so the ones after it are
+// removed from argv and added to the extra files
+// returns the number of arguments left for the parser
+static int extractSourceFiles(int argc, const char** argv, std::vector<const char*>& extraFiles)
+{
+	int kept = 1;
+	bool foundFirst = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* argument = argv[i];
+
+		if (argument[0] == '-')
+		{
+			argv[kept++] = argument;
+
+			if (takesValue(argument) && i + 1 < argc)
+			{
+				argv[kept++] = argv[++i];
+			}
+		}
+		else if (!foundFirst)
+		{
+			foundFirst = true;
+			argv[kept++] = argument;
+		}
+		else
+		{
+			extraFiles.push_back(argument);
+		}
+	}
+
+	return kept;
+}
+
+
+static pvm::Engine parseEngine(const char* name)
+{
+	if (name == nullptr || strcmp(name, "threaded") == 0)
+	{
+		return pvm::Engine::THREADED;
+	}
+
+	if (strcmp(name, "switch") == 0)
+	{
+		return pvm::Engine::SWITCH;
+	}
+
+	std::cerr << "Unknown execution engine \"" << name << '"' << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+
+// kinds of compilation output
+typedef enum class Target
+{
+	// Pvm executable
+	PFX,
+	// C translation of the byte code
+	C,
+	// C translation built by the system C compiler
+	NATIVE,
+
+} Target;
+
+
+// default output file extension, indexed by Target
+static const char* const targetExtensions[] =
+{
+	".pfx",
+	".c",
+	".out",
+};
+
+
+static Target parseTarget(const char* name)
+{
+	if (name == nullptr || strcmp(name, "pfx") == 0)
+	{
+		return Target::PFX;
+	}
+
+	if (strcmp(name, "c") == 0)
+	{
+		return Target::C;
+	}
+
+	if (strcmp(name, "native") == 0)
+	{
+		return Target::NATIVE;
+	}
+
+	std::cerr << "Unknown compilation target \"" << name << '"' << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+
+static void generateOutput(const pvm::ByteCode& byteCode, const pvm::ByteCode& lineTable, const char* name, Target target, size_t memorySize)
+{
+	switch (target)
+	{
+	case Target::PFX:
+		pvm::generateExecutable(byteCode, lineTable, name);
+		break;
+
+	case Target::C:
+		pvm::generateCFile(byteCode, name, memorySize);
+		break;
+
+	case Target::NATIVE:
+		pvm::generateNativeExecutable(byteCode, name, memorySize);
+		break;
+	}
+}
+
+
+// the name of the output of a source file when none is given
+static std::string defaultOutputName(const char* fileName, Target target)
+{
+	return std::string(fileName) + targetExtensions[(unsigned char) target];
+}
+
+
+static size_t parseMemorySize(const char* size)
+{
+	if (size == nullptr)
+	{
+		return PVM_DEFAULT_MEMORY_SIZE;
+	}
+
+	char* suffix;
+	size_t bytes = strtoul(size, &suffix, 10);
+
+	switch (*suffix)
+	{
+	case 'G':
+	case 'g':
+		bytes *= 1024;
+		// fall through
+	case 'M':
+	case 'm':
+		bytes *= 1024;
+		// fall through
+	case 'K':
+	case 'k':
+		bytes *= 1024;
+		suffix ++;
+		break;
+	}
+
+	if (suffix == size || *suffix != '\0' || bytes == 0)
+	{
+		std::cerr << "Invalid memory size \"" << size << '"' << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	return bytes;
+}
+
+
+static size_t parseJobs(const char* jobs)
+{
+	if (jobs == nullptr)
+	{
+		return 1;
+	}
+
+	char* end;
+	const size_t count = strtoul(jobs, &end, 10);
+
+	if (end == jobs || *end != '\0' || count == 0)
+	{
+		std::cerr << "Invalid number of jobs \"" << jobs << '"' << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	return count;
+}
+
+
+static void defineMacros(preprocessor::Preprocessor& preprocessor, const std::vector<pcc::Macro>& macros)
+{
+	for (const pcc::Macro& macro : macros)
+	{
+		preprocessor.define(macro.name, macro.value);
+	}
+}
+
+
+// compiles a file to the default output name of the target
+// errors are reported with the file name instead of ending the process,
+// so that the other files are compiled anyway
+// the cache is only used for executables, nullptr disables it
+// returns whether the file was compiled
+static bool compileFile(const char* fileName, Target target, size_t memorySize, const pcc::Options& compileOptions, cache::Cache* compilationCache, std::mutex& reportLock)
+{
+	errors::Capture capture;
+
+	try
+	{
+		const file_utils::SourceBuffer file(fileName);
+
+		const std::string outputName = defaultOutputName(fileName, target);
+
+		// preprocessed once, for both the cache Key and the compiler
+		preprocessor::Preprocessor preprocessor;
+		defineMacros(preprocessor, compileOptions.macros);
+
+		const preprocessor::Output source = preprocessor.process(file.getView());
+
+		// a script without directives is compiled as it is
+		std::string preprocessed;
 
+		if (preprocessor.changes(source))
+		{
+			preprocessed = source.toString();
+		}
+
+		const std::string_view script = preprocessor.changes(source) ? std::string_view(preprocessed) : file.getView();
+
+		cache::Key key;
+
+		if (compilationCache != nullptr)
+		{
+			// the cache is keyed by the preprocessed script, so that changes
+			// to the included files and the macros are noticed
+			key = compilationCache->keyOf(script, compileOptions.optimize);
+
+			if (compilationCache->fetch(key, outputName.c_str()))
+			{
+				return true;
+			}
+		}
+
+		timerpp::Timer timer;
+		timer.start();
+
+		pcc::Result<pcc::Compilation, pcc::Diagnostics> result = pcc::compile(script, source, compileOptions);
+
+		if (!result.isOk())
+		{
+			const std::lock_guard<std::mutex> lock(reportLock);
+
+			for (const pcc::Diagnostic& diagnostic : result.getError())
+			{
+				std::cerr << fileName << ": " << diagnostic.message << std::endl;
+			}
+
+			return false;
+		}
+
+		pcc::Compilation& compilation = result.getValue();
+
+		generateOutput(compilation.getByteCode(), compilation.getLineTable(), outputName.c_str(), target, memorySize);
+
+		timer.stop();
+
+		if (compilationCache != nullptr)
+		{
+			compilationCache->store(key, compilation.getByteCode(), compilation.getLineTable(), (uint64_t) (timer.millis() * 1000.0));
+		}
+	}
+	catch (const errors::Error& error)
+	{
+		const std::lock_guard<std::mutex> lock(reportLock);
+
+		std::cerr << fileName << ": " << error.what() << std::endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+
+// compiles the files on a pool of threads, each one with its own compilation Context
+// the calling thread is part of the pool
+// returns whether every file was compiled
+static bool compileFiles(const std::vector<const char*>& fileNames, size_t jobs, Target target, size_t memorySize, const pcc::Options& compileOptions, cache::Cache* compilationCache)
+{
+	// index of the next file to compile
+	std::atomic<size_t> next = 0;
+	std::atomic<bool> succeeded = true;
+
+	// keeps the reports of different files from interleaving
+	std::mutex reportLock;
+
+	const auto compileNext = [&]()
+	{
+		for (size_t i = next++; i < fileNames.size(); i = next++)
+		{
+			if (!compileFile(fileNames[i], target, memorySize, compileOptions, compilationCache, reportLock))
+			{
+				succeeded = false;
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+
+	for (size_t i = 1; i < std::min(jobs, fileNames.size()); i++)
+	{
+		workers.emplace_back(compileNext);
+	}
+
+	compileNext();
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	return succeeded;
+}
+
+
+// saves the Statistics of the cache, then reports them if requested
+static void finishCache(cache::Cache* compilationCache, bool report)
+{
+	if (compilationCache == nullptr)
+	{
+		return;
+	}
+
+	const cache::Statistics total = compilationCache->saveStatistics();
+
+	if (report)
+	{
+		std::cout << "Cache, this run: " << compilationCache->getSession() << '\n'
+			<< "Cache, total: " << total << std::endl;
+	}
+}
+
+
+static void benchmarkEngines(const std::vector<pvm::Instruction>& program, size_t memorySize)
+{
+	const pvm::Engine engines[] = { pvm::Engine::SWITCH, pvm::Engine::THREADED };
+
+	// count the executed instructions in a separate run so that
+	// the timed runs aren't slowed down by the counter
+	pvm::Pvm counter = pvm::Pvm(memorySize);
+	counter.executeCounting(program, pvm::Engine::SWITCH);
+	const size_t instructions = counter.getInstructionCount();
+
+	double threadedMillis = 0;
+
+	for (pvm::Engine engine : engines)
+	{
+
+		pvm::Pvm pvm = pvm::Pvm(memorySize);
+
+		timerpp::Timer timer;
+		timer.start();
+
+		pvm::Byte exitCode = pvm.execute(program, engine);
+
+		timer.stop();
+
+		const double seconds = timer.millis() / 1000.0;
+
+		std::cout << pvm::engineName(engine) << ": " << timer.millis() << " ms, "
+			<< instructions << " instructions, "
+			<< (size_t) ((double) instructions / seconds) << " instructions/second"
+			<< " (exit code: " << (unsigned int) exitCode << ')' << std::endl;
+
+		threadedMillis = timer.millis();
+	}
+
+	if (!jit::NativeProgram(program).isSupported())
+	{
+		std::cout << "jit: unsupported program" << std::endl;
+		return;
+	}
+
+	pvm::Pvm pvm = pvm::Pvm(memorySize);
+
+	// translation time is included
+	timerpp::Timer timer;
+	timer.start();
+
+	pvm::Byte exitCode = pvm.executeNative(program);
+
+	timer.stop();
+
+	const double seconds = timer.millis() / 1000.0;
+
+	std::cout << "jit: " << timer.millis() << " ms, "
+		<< instructions << " instructions, "
+		<< (size_t) ((double) instructions / seconds) << " instructions/second, "
+		<< threadedMillis / timer.millis() << "x threaded"
+		<< " (exit code: " << (unsigned int) exitCode << ')' << std::endl;
+}
+
+
+static void profileProgram(const std::vector<pvm::Instruction>& program, size_t memorySize, const char* fileName, pvm::Engine engine)
+{
+	pvm::Pvm pvm = pvm::Pvm(memorySize);
+
+	// native code can't be instrumented, the profile always comes from an engine
+	pvm::Byte exitCode = pvm.executeProfiling(program, engine);
+
+	std::cout << "Exit code: " << (unsigned int) exitCode << std::endl;
+
+	pvm::printProfile(program, pvm.getProfile(), std::cout);
+
+	const std::string profileName = std::string(fileName) + ".profile";
+	pvm::writeProfile(program, pvm.getProfile(), profileName.c_str());
+
+	std::cout << "\nProfile written to " << profileName << std::endl;
+}
+
+
+static void sampleProgram(const std::vector<pvm::Instruction>& program, const pvm::LineTable& lineTable, size_t memorySize, const char* fileName, pvm::Engine engine)
+{
+	pvm::Pvm pvm = pvm::Pvm(memorySize);
+
+	pvm::Byte exitCode = pvm.executeSampling(program, engine, PVM_SAMPLING_INTERVAL);
+
+	std::cout << "Exit code: " << (unsigned int) exitCode << std::endl;
+
+	pvm::printSamples(program, pvm.getSamples(), lineTable, std::cout);
+
+	const std::string foldedName = std::string(fileName) + ".folded";
+	pvm::writeFoldedSamples(program, pvm.getSamples(), lineTable, fileName, foldedName.c_str());
+
+	std::cout << "\nFolded stacks written to " << foldedName << std::endl;
 }
 
 
@@ -57,16 +629,61 @@ int main(int argc, const char** argv)
 
 	initParser(&parser, options);
 
+	argc = extractMacros(argc, argv, options.macros);
+
+	std::vector<const char*> extraFiles;
+	argc = extractSourceFiles(argc, argv, extraFiles);
+
 	parser.parse(argc, argv);
+
+	options.fileNames.push_back(options.fileName);
+	options.fileNames.insert(options.fileNames.end(), extraFiles.begin(), extraFiles.end());
 	
 
 	if (options.execute)
 	{
 
-		pvm::ByteCode byteCode = pvm::loadByteCode(options.fileName);
+		if (options.fileNames.size() != 1)
+		{
+			std::cerr << "Only one file can be executed at a time" << std::endl;
+			exit(EXIT_FAILURE);
+		}
+
+		const pvm::Executable executable = pvm::Executable(options.fileName);
+
+		// decode once, before any engine runs the program
+		// the byte code is read straight from the mapped file
+		const std::vector<pvm::Instruction> program = pvm::decode(executable.getByteCode());
+
+		const size_t memorySize = parseMemorySize(options.memory);
+
+		if (options.benchmark)
+		{
+			benchmarkEngines(program, memorySize);
+			return 0;
+		}
+
+		if (options.profile)
+		{
+			profileProgram(program, memorySize, options.fileName, parseEngine(options.engine));
+			return 0;
+		}
+
+		if (options.sample)
+		{
+			sampleProgram(program, executable.getLineTable(), memorySize, options.fileName, parseEngine(options.engine));
+			return 0;
+		}
 		
-		pvm::Pvm pvm = pvm::Pvm(1024);
-		pvm::Byte exitCode = pvm.execute(byteCode.byteCode);
+		pvm::Pvm pvm = pvm::Pvm(memorySize);
+		pvm::Byte exitCode = options.jit
+			? pvm.executeNative(program)
+			: pvm.execute(program, parseEngine(options.engine));
+
+		if (options.verbose)
+		{
+			pvm.printState(std::cout);
+		}
 
 		std::cout << "Exit code: " << (unsigned int) exitCode << std::endl;
 		
@@ -74,20 +691,55 @@ int main(int argc, const char** argv)
 	else // compile
 	{
 
+		const Target target = parseTarget(options.target);
+		const size_t memorySize = parseMemorySize(options.memory);
+		const size_t jobs = parseJobs(options.jobs);
+
+		// the cache only holds executables
+		std::optional<cache::Cache> cacheStorage;
+		cache::Cache* compilationCache = nullptr;
+
+		if ((options.cache || options.cacheDirectory != nullptr || options.cacheStatistics) && target == Target::PFX)
+		{
+			const std::string cacheDirectory = options.cacheDirectory != nullptr ? options.cacheDirectory : cache::Cache::defaultDirectory();
+			cacheStorage.emplace(cacheDirectory);
+
+			if (cacheStorage->isUsable())
+			{
+				compilationCache = &*cacheStorage;
+			}
+			else
+			{
+				// the cache only saves time, it never fails the compilation
+				std::cerr << "[Cache Warning] Could not write to directory \"" << cacheDirectory
+					<< "\", compiling without the cache" << std::endl;
+			}
+		}
+
+		if (options.fileNames.size() != 1)
+		{
+			if (options.outputName != nullptr)
+			{
+				std::cerr << "An output name can't be given to more than one file" << std::endl;
+				exit(EXIT_FAILURE);
+			}
+
+			const bool succeeded = compileFiles(options.fileNames, jobs, target, memorySize, { options.optimize, options.macros }, compilationCache);
+
+			finishCache(compilationCache, options.cacheStatistics);
+
+			return succeeded ? 0 : EXIT_FAILURE;
+		}
+
 		timerpp::Timer timer;
 
 if (options.verbose)
 	timer = timerpp::Timer();
 
-		std::string file;
-
 if (options.verbose)
 	timer.start();
 
-		if (!file_utils::loadFile(options.fileName, file))
-		{
-			errors::FileReadError(options.fileName);
-		}
+		const file_utils::SourceBuffer file(options.fileName);
 
 if (options.verbose)
 {
@@ -98,18 +750,59 @@ if (options.verbose)
 
 	timer.start();
 }
-		preprocessor::process(file);
+		preprocessor::Preprocessor preprocessor;
+		defineMacros(preprocessor, options.macros);
+
+		const preprocessor::Output source = preprocessor.process(file.getView());
+
+		// a script without directives is tokenized as it is
+		std::string preprocessed;
+
+		if (preprocessor.changes(source))
+		{
+			preprocessed = source.toString();
+		}
+
+		const std::string_view script = preprocessor.changes(source) ? std::string_view(preprocessed) : file.getView();
 
 if (options.verbose)
 {
 	timer.stop();
 
-	std::cout << "Preprocessor took: " << timer.millis() << " ms\n" << std::endl ;
+	std::cout << "Preprocessor took: " << timer.millis() << " ms, "
+		<< source.getPieces().size() << " pieces\n" << std::endl;
+}
+		const std::string outputName = options.outputName != nullptr
+			? options.outputName
+			: defaultOutputName(options.fileName, target);
+
+		cache::Key key;
+
+		if (compilationCache != nullptr)
+		{
+			key = compilationCache->keyOf(script, options.optimize);
+
+			if (compilationCache->fetch(key, outputName.c_str()))
+			{
+				if (options.verbose)
+					std::cout << "Cache hit, nothing to compile" << std::endl;
 
+				finishCache(compilationCache, options.cacheStatistics);
+				return 0;
+			}
+		}
 
+		// the time later cache hits of this script will save
+		timerpp::Timer compileTimer;
+		compileTimer.start();
+
+if (options.verbose)
 	timer.start();
-}
-		Tokens::TokenList tokens = Tokens::TokenList(file);
+
+		// owns the front-end nodes and the symbols of the compilation
+		compilation::Context context(options.optimize);
+
+		Tokens::TokenList tokens = Tokens::TokenList(script, context, &source);
 
 if (options.verbose)
 {    
@@ -123,6 +816,7 @@ if (options.verbose)
 }
 		syntax_tree::SyntaxTree syntaxTree = syntax_tree::SyntaxTree(tokens);
 		const pvm::ByteCode byteCode = syntaxTree.parseToByteCode();
+		const pvm::ByteCode lineTable = syntaxTree.lineTableToByteCode();
 
 if (options.verbose)
 { 
@@ -133,25 +827,16 @@ if (options.verbose)
 	std::cout << byteCode << '\n' << std::endl;
 }
 		
-		if (options.outputName == nullptr)
-		{
-			// generate name for executable if not provided
-			const size_t nameLength = strlen(options.fileName);
-			char outputName[nameLength + 5];
-			strncpy(outputName, options.fileName, nameLength);
-			strcpy(outputName + nameLength, ".pfx");    
+		generateOutput(byteCode, lineTable, outputName.c_str(), target, memorySize);
 
-			// outputName is a local variable, not the outer one
-			// this prevents copying of the string outputName to extend
-			// its lifetime beyond this local scope
-			pvm::generateExecutable(byteCode, outputName);
-		}
-		else
+		compileTimer.stop();
+
+		if (compilationCache != nullptr)
 		{
-			// here outputName is the outer variable
-			pvm::generateExecutable(byteCode, options.outputName);
+			compilationCache->store(key, byteCode, lineTable, (uint64_t) (compileTimer.millis() * 1000.0));
 		}
-		
+
+		finishCache(compilationCache, options.cacheStatistics);
 		
 	} // do compile
 
@@ -1,13 +1,12 @@
 #include "preprocessor.hh"
 
-#include <string.h>
+#include <algorithm>
 #include <unordered_map>
 
 #include "errors.hh"
 
 
 using namespace preprocessor;
-using namespace string_utils;
 
 
 static const auto preprocessorMap = std::unordered_map<std::string_view, Preps>
@@ -15,135 +14,471 @@ static const auto preprocessorMap = std::unordered_map<std::string_view, Preps>
     {"define",  Preps::DEFINE},
     {"include", Preps::INCLUDE},
     {"ifdef",   Preps::IFDEF},
-    {"ifndef",  Preps::IFNDEF}
+    {"ifndef",  Preps::IFNDEF},
+    {"else",    Preps::ELSE},
+    {"endif",   Preps::ENDIF},
+    {"pragma",  Preps::PRAGMA}
 });
 
 
-static void preprocessorInclude(std::string& script, size_t& hashIndex)
+// the view without its leading and trailing blanks
+static std::string_view trim(std::string_view text)
 {
-    #define INCLUDE_LENGTH 8
-    
-    // search for the first character after spaces
-    const size_t enclosureIndex = indexOfNotChar(script, hashIndex + INCLUDE_LENGTH, ' ');
+    const size_t begin = text.find_first_not_of(" \t\r");
+
+    if (begin == std::string_view::npos)
+    {
+        return std::string_view();
+    }
+
+    return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+}
+
+
+// characters of macro names, digits can't begin one
+static bool isNameCharacter(char c)
+{
+    return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
 
-    // content of the file to include
-    std::string file;
 
-    if (script[enclosureIndex] == '<')
+static bool isName(std::string_view name)
+{
+    if (name.empty() || (name[0] >= '0' && name[0] <= '9'))
     {
-        // search in global include directory
+        return false;
+    }
 
-    // get file path
+    return std::all_of(name.begin(), name.end(), isNameCharacter);
+}
 
-        const size_t enclosureClose = indexOfChar(script, enclosureIndex + 1, '>');
 
-        // allocate a char array with the size of the file name
-        const size_t nameLength = enclosureClose - enclosureIndex - 1;
+Output::Output()
+: pieces(), offsets(), size(0)
+{
 
-        const size_t includePathLength = strlen(globals::INCLUDE_PATH);
+}
 
-        // + 2 to make space for the null termination character and the / in the path name
-        const size_t filePathLength = includePathLength + nameLength + 2;
-        char filePath[filePathLength];
 
-        strcpy(filePath, globals::INCLUDE_PATH);
-        filePath[includePathLength] = '/';
+void Output::add(const SourceFile* file, size_t offset, size_t length, uint32_t line)
+{
+    if (length == 0)
+    {
+        return;
+    }
 
-        // extract file name from enclosure
-        strncpy(filePath + includePathLength + 1, script.c_str() + enclosureIndex + 1, nameLength);
-        filePath[filePathLength - 1] = '\0';
+    pieces.push_back(Piece { file, offset, length, line });
+    offsets.push_back(size);
 
-    // read file
+    size += length;
+}
 
-        if (!file_utils::loadFile(filePath, file))
-        {
-            errors::FileReadError(filePath);
-        }
 
-    // remove the #include statement until the end of the line
+const std::vector<Piece>& Output::getPieces() const
+{
+    return pieces;
+}
 
-        const size_t lineEnd = indexOfChar(script, enclosureClose, '\n');
-        script.erase(hashIndex, lineEnd - hashIndex);
 
+const std::vector<size_t>& Output::getOffsets() const
+{
+    return offsets;
+}
+
+
+size_t Output::getSize() const
+{
+    return size;
+}
+
+
+Location Output::locate(size_t offset) const
+{
+    // the last Piece that begins at or before the offset
+    const size_t index = std::upper_bound(offsets.begin(), offsets.end(), offset) - offsets.begin() - 1;
+    const Piece& piece = pieces[index];
+
+    const char* const begin = piece.file->content.data() + piece.offset;
+    const uint32_t lines = (uint32_t) std::count(begin, begin + (offset - offsets[index]), '\n');
+
+    return Location { piece.file, piece.line + lines };
+}
+
+
+std::string Output::toString() const
+{
+    std::string string;
+    string.reserve(size);
+
+    for (const Piece& piece : pieces)
+    {
+        string.append(piece.file->content.substr(piece.offset, piece.length));
     }
-    else if (script[enclosureIndex] == '"')
+
+    return string;
+}
+
+
+Preprocessor::Preprocessor()
+: script(), files(), macroValues(), macros(), macroStarts()
+{
+
+}
+
+
+SourceFile* Preprocessor::load(const std::string& path)
+{
+    auto iterator = files.find(path);
+
+    if (iterator != files.end())
+    {
+        return iterator->second.get();
+    }
+
+    std::unique_ptr<SourceFile> file = std::make_unique<SourceFile>();
+    file->path = path;
+
+    file->buffer.emplace(path.c_str());
+    file->content = file->buffer->getView();
+
+    return files.emplace(path, std::move(file)).first->second.get();
+}
+
+
+void Preprocessor::include(std::string_view argument, Output& output)
+{
+    argument = trim(argument);
+
+    if (argument.empty() || (argument[0] != '<' && argument[0] != '"'))
+    {
+        errors::InvalidIncludeEnclosureError(argument.empty() ? '\n' : argument[0]);
+    }
+
+    const char closing = argument[0] == '<' ? '>' : '"';
+
+    const size_t enclosureClose = argument.find(closing, 1);
+
+    if (enclosureClose == std::string_view::npos)
+    {
+        errors::InvalidIncludeEnclosureError(argument[0]);
+    }
+
+    const std::string_view name = argument.substr(1, enclosureClose - 1);
+
+    // <file> is searched in the global include directory, "file" in the working directory
+    const std::string path = closing == '>'
+        ? std::string(globals::INCLUDE_PATH) + '/' + std::string(name)
+        : std::string(name);
+
+    SourceFile* const file = load(path);
+
+    if (file->once && file->included)
+    {
+        return;
+    }
+
+    if (file->scanning)
     {
-        // search in relative path
-    
-    // get file path
+        errors::RecursiveIncludeError(path.c_str());
+    }
+
+    file->included = true;
 
-        const size_t enclosureClose = indexOfChar(script, enclosureIndex, '"');
+    scan(file, output);
+}
+
+
+void Preprocessor::define(std::string_view name, std::string_view value)
+{
+    if (!isName(name))
+    {
+        errors::InvalidMacroNameError(std::string(name).c_str());
+    }
 
-        const size_t filePathLength = enclosureClose - enclosureIndex - 1;
-        char filePath[filePathLength + 1];
+    std::unique_ptr<SourceFile> macro = std::make_unique<SourceFile>();
+    macro->path = name;
+    macro->storage = value;
+    macro->content = macro->storage;
 
-        strncpy(filePath, script.c_str() + enclosureIndex + 1, filePathLength);
-        filePath[filePathLength] = '\0';
+    // the key views the name of the first definition, which is never released
+    auto iterator = macros.find(name);
 
-    // read file
+    if (iterator == macros.end())
+    {
+        macros.emplace(macro->path, macro.get());
+    }
+    else
+    {
+        iterator->second = macro.get();
+    }
+
+    macroStarts[(unsigned char) name[0]] = true;
+
+    macroValues.push_back(std::move(macro));
+}
+
+
+void Preprocessor::applyDirective(SourceFile* file, std::string_view directive, uint32_t line, std::vector<Conditional>& conditionals, Output& output)
+{
+    // the name ends at the first blank
+    const size_t nameEnd = std::min(directive.find_first_of(" \t\r"), directive.size());
+    const std::string_view name = directive.substr(0, nameEnd);
+    const std::string_view argument = directive.substr(nameEnd);
 
-        if (!file_utils::loadFile(filePath, file))
+    const bool active = conditionals.empty() || conditionals.back().active;
+
+    auto it = preprocessorMap.find(name);
+    if (it == preprocessorMap.end())
+    {
+        // excluded lines may be anything
+        if (!active)
         {
-            errors::FileReadError(filePath);
+            return;
         }
 
-    // remove the #include statement until the end of the line
+        errors::InvalidPreprocessorError(std::string(name).c_str());
+    }
+
+    switch (it->second)
+    {
+    case Preps::IFDEF:
+    case Preps::IFNDEF:
+    {
+        const bool defined = macros.find(trim(argument)) != macros.end();
+
+        conditionals.push_back(Conditional {
+            active && defined == (it->second == Preps::IFDEF),
+            active,
+            false,
+            line
+        });
+        return;
+    }
+
+    case Preps::ELSE:
+        if (conditionals.empty() || conditionals.back().hasElse)
+        {
+            errors::UnmatchedConditionalError("else");
+        }
 
-        // + 1 to remove the newline character
-        const size_t lineEnd = indexOfChar(script, enclosureClose, '\n') + 1;
-        script.erase(hashIndex, lineEnd - hashIndex);
+        conditionals.back().active = conditionals.back().enclosing && !conditionals.back().active;
+        conditionals.back().hasElse = true;
+        return;
 
+    case Preps::ENDIF:
+        if (conditionals.empty())
+        {
+            errors::UnmatchedConditionalError("endif");
+        }
+
+        conditionals.pop_back();
+        return;
+
+    default:
+        break;
+
+    } // switch(Preps)
+
+    // other directives of excluded lines are ignored
+    if (!active)
+    {
+        return;
     }
-    else
+
+    switch (it->second)
+    {
+    case Preps::INCLUDE:
+        include(argument, output);
+        break;
+
+    case Preps::DEFINE:
     {
-        errors::InvalidIncludeEnclosureError(script[enclosureIndex]);
+        const std::string_view definition = trim(argument);
+
+        // the value follows the name after a blank, it may be empty
+        const size_t macroEnd = std::min(definition.find_first_of(" \t"), definition.size());
+
+        define(definition.substr(0, macroEnd), trim(definition.substr(macroEnd)));
+        break;
     }
 
-    // include the loaded file
+    case Preps::PRAGMA:
+        if (trim(argument) != "once")
+        {
+            errors::InvalidPreprocessorError(std::string(directive).c_str());
+        }
+
+        file->once = true;
+        break;
 
-    script.insert(hashIndex, file);    
+    default:
+        break;
 
+    } // switch(Preps)
 }
 
 
-void preprocessor::process(std::string& script)
+void Preprocessor::expand(const SourceFile* file, size_t offset, size_t length, uint32_t line, Output& output)
 {
-    for (size_t i = 0; script[i] != '\0'; i++)
-    {   
-        // search for a '#' after a newline or at the beginning of the file
-        if (!(
-            script[i] == '#'
-            && (i == 0
-                || script[i - 1] == '\n'
-                )
-            ))
+    if (macros.empty())
+    {
+        output.add(file, offset, length, line);
+        return;
+    }
+
+    const std::string_view content = file->content;
+    const size_t end = offset + length;
+
+    // beginning of the range that hasn't been added to the output yet
+    size_t pieceStart = offset;
+    uint32_t pieceLine = line;
+
+    for (size_t i = offset; i < end;)
+    {
+        const char c = content[i];
+
+        if (c == '\n')
+        {
+            line ++;
+            i ++;
+            continue;
+        }
+
+        // string literals are left as they are, they may span lines
+        if (c == '"')
+        {
+            const size_t closing = content.find('"', i + 1);
+            const size_t literalEnd = closing >= end ? end : closing + 1;
+
+            line += (uint32_t) std::count(content.data() + i, content.data() + literalEnd, '\n');
+            i = literalEnd;
+            continue;
+        }
+
+        if (!isNameCharacter(c))
+        {
+            i ++;
+            continue;
+        }
+
+        const size_t nameStart = i;
+
+        while (i < end && isNameCharacter(content[i]))
+        {
+            i ++;
+        }
+
+        if (!macroStarts[(unsigned char) c])
+        {
+            continue;
+        }
+
+        auto macro = macros.find(content.substr(nameStart, i - nameStart));
+
+        if (macro == macros.end())
         {
             continue;
         }
 
-        // get the preprocessor name
+        // the value takes the line of the name it replaces
+        output.add(file, pieceStart, nameStart - pieceStart, pieceLine);
+        output.add(macro->second, 0, macro->second->content.size(), line);
+
+        pieceStart = i;
+        pieceLine = line;
+    }
+
+    output.add(file, pieceStart, end - pieceStart, pieceLine);
+}
+
+
+void Preprocessor::scan(SourceFile* file, Output& output)
+{
+    file->scanning = true;
+
+    const std::string_view content = file->content;
+
+    // the conditionals of a file have to be closed in the same file
+    std::vector<Conditional> conditionals;
+
+    // beginning of the range that hasn't been added to the output yet
+    size_t pieceStart = 0;
+    uint32_t pieceLine = 1;
+
+    uint32_t line = 1;
+
+    for (size_t lineStart = 0; lineStart < content.size(); line++)
+    {
+        const bool active = conditionals.empty() || conditionals.back().active;
+
+        // excluded lines are skipped up to the next directive without being split
+        if (!active && content[lineStart] != '#')
+        {
+            const size_t directive = content.find("\n#", lineStart);
+
+            if (directive == std::string_view::npos)
+            {
+                break;
+            }
 
-        const size_t pIndex = i+1;
-        const size_t spaceIndex = indexOfChar(script, pIndex, ' ');
-        const size_t length = spaceIndex - pIndex;
+            line += (uint32_t) std::count(content.data() + lineStart, content.data() + directive + 1, '\n');
+            lineStart = directive + 1;
+        }
 
-        const std::string_view pName(script.c_str() + pIndex, length);
+        size_t lineEnd = content.find('\n', lineStart);
 
-        auto it = preprocessorMap.find(pName);
-        if (it == preprocessorMap.end())
+        if (lineEnd == std::string_view::npos)
         {
-            errors::InvalidPreprocessorError(pName.data());
+            lineEnd = content.size();
         }
 
-        switch (it->second)
+        // directives begin with a '#' at the beginning of a line
+        if (content[lineStart] == '#')
         {
-        case Preps::INCLUDE:
-            preprocessorInclude(script, i);
-            break;
-        
-        } // switch(Preps)
+            // the range before the directive has to be added before the directive's output
+            if (active)
+            {
+                expand(file, pieceStart, lineStart - pieceStart, pieceLine, output);
+            }
+
+            const std::string_view directive(content.data() + lineStart + 1, lineEnd - lineStart - 1);
+
+            applyDirective(file, directive, line, conditionals, output);
+
+            // the directive is replaced by its output, the newline is kept
+            pieceStart = lineEnd;
+            pieceLine = line;
+        }
+
+        lineStart = lineEnd + 1;
+    }
+
+    if (!conditionals.empty())
+    {
+        errors::UnterminatedConditionalError(file->path.empty() ? "the script" : ('"' + file->path + '"').c_str(), conditionals.back().line);
+    }
 
-    } // for (char in script)
-    
+    expand(file, pieceStart, content.size() - pieceStart, pieceLine, output);
+
+    file->scanning = false;
 }
 
+
+Output Preprocessor::process(std::string_view script)
+{
+    this->script.content = script;
+
+    Output output;
+    scan(&this->script, output);
+
+    return output;
+}
+
+
+bool Preprocessor::changes(const Output& output) const
+{
+    const std::vector<Piece>& pieces = output.getPieces();
+
+    return !(pieces.empty() && script.content.empty())
+        && !(pieces.size() == 1 && pieces[0].file == &script && pieces[0].length == script.content.size());
+}
@@ -282,6 +282,109 @@ std::ostream& operator<<(std::ostream& stream, const ByteCode& byteCode)
             stream << ":\n";
             continue;
 
+        case OpCode::ADD_MEM_8:
+        case OpCode::ADD_MEM_4:
+        case OpCode::SUB_MEM_8:
+        case OpCode::SUB_MEM_4:
+        case OpCode::MUL_MEM_8:
+        case OpCode::MUL_MEM_4:
+            stream << '[' << getLong(bytes, i) << "], ["
+                << getLong(bytes, i) << "], ["
+                << getLong(bytes, i) << "]\n";
+            continue;
+
+        case OpCode::ADD_MEM_CONST_8:
+        case OpCode::SUB_MEM_CONST_8:
+        case OpCode::MUL_MEM_CONST_8:
+            stream << '[' << getLong(bytes, i) << "], ["
+                << getLong(bytes, i) << "], "
+                << getLong(bytes, i) << '\n';
+            continue;
+
+        case OpCode::ADD_MEM_CONST_4:
+        case OpCode::SUB_MEM_CONST_4:
+        case OpCode::MUL_MEM_CONST_4:
+            stream << '[' << getLong(bytes, i) << "], ["
+                << getLong(bytes, i) << "], "
+                << getInt(bytes, i) << '\n';
+            continue;
+
+        case OpCode::CMP_MEM_8:
+        case OpCode::CMP_MEM_4:
+        case OpCode::CMP_REVERSE_MEM_8:
+        case OpCode::CMP_REVERSE_MEM_4:
+            stream << '[' << getLong(bytes, i) << "], ["
+                << getLong(bytes, i) << "]\n";
+            continue;
+
+        case OpCode::CMP_MEM_CONST_8:
+        case OpCode::CMP_REVERSE_MEM_CONST_8:
+            stream << '[' << getLong(bytes, i) << "], "
+                << getLong(bytes, i) << '\n';
+            continue;
+
+        case OpCode::CMP_MEM_CONST_4:
+        case OpCode::CMP_REVERSE_MEM_CONST_4:
+            stream << '[' << getLong(bytes, i) << "], "
+                << getInt(bytes, i) << '\n';
+            continue;
+
+        case OpCode::IF_NOT_MEM_JUMP:
+            stream << '[' << getLong(bytes, i) << "], @["
+                << getLong(bytes, i) << "]\n";
+            continue;
+
+        case OpCode::LD_REG_8:
+        case OpCode::LD_REG_4:
+        case OpCode::LD_REG_1:
+        case OpCode::LD_REG_BIT:
+            stream << (Registers) getByte(bytes, i) << ", ["
+                << getLong(bytes, i) << "]\n";
+            continue;
+
+        case OpCode::LD_CONST_REG:
+        case OpCode::CMP_REG_CONST:
+        case OpCode::CMP_REVERSE_REG_CONST:
+            stream << (Registers) getByte(bytes, i) << ", "
+                << getLong(bytes, i) << '\n';
+            continue;
+
+        case OpCode::REG_TO_REG_4:
+        case OpCode::REG_TO_REG_1:
+        case OpCode::REG_TO_REG_BIT:
+        case OpCode::CMP_REG:
+        case OpCode::CMP_REVERSE_REG:
+            stream << (Registers) getByte(bytes, i) << ", "
+                << (Registers) getByte(bytes, i) << '\n';
+            continue;
+
+        case OpCode::ADD_REG_8:
+        case OpCode::ADD_REG_4:
+        case OpCode::SUB_REG_8:
+        case OpCode::SUB_REG_4:
+        case OpCode::MUL_REG_8:
+        case OpCode::MUL_REG_4:
+            stream << (Registers) getByte(bytes, i) << ", "
+                << (Registers) getByte(bytes, i) << ", "
+                << (Registers) getByte(bytes, i) << '\n';
+            continue;
+
+        case OpCode::ADD_REG_CONST_8:
+        case OpCode::ADD_REG_CONST_4:
+        case OpCode::SUB_REG_CONST_8:
+        case OpCode::SUB_REG_CONST_4:
+        case OpCode::MUL_REG_CONST_8:
+        case OpCode::MUL_REG_CONST_4:
+            stream << (Registers) getByte(bytes, i) << ", "
+                << (Registers) getByte(bytes, i) << ", "
+                << getLong(bytes, i) << '\n';
+            continue;
+
+        case OpCode::IF_NOT_REG_JUMP:
+            stream << (Registers) getByte(bytes, i) << ", @["
+                << getLong(bytes, i) << "]\n";
+            continue;
+
         } // switch ((OpCode) byteCode[i])
 
         // if flow reaches this line the while loop is terminated
@@ -362,10 +465,169 @@ static const char* opCodeNames[] =
     "pop",
     "call",
     "print",
+    "add mem 8",
+    "add mem 4",
+    "add mem const 8",
+    "add mem const 4",
+    "sub mem 8",
+    "sub mem 4",
+    "sub mem const 8",
+    "sub mem const 4",
+    "mul mem 8",
+    "mul mem 4",
+    "mul mem const 8",
+    "mul mem const 4",
+    "cmp mem 8",
+    "cmp mem 4",
+    "cmp mem const 8",
+    "cmp mem const 4",
+    "cmp reverse mem 8",
+    "cmp reverse mem 4",
+    "cmp reverse mem const 8",
+    "cmp reverse mem const 4",
+    "if not mem jump",
+    "ld reg 8",
+    "ld reg 4",
+    "ld reg 1",
+    "ld reg bit",
+    "ld const reg",
+    "reg to reg 4",
+    "reg to reg 1",
+    "reg to reg bit",
+    "add reg 8",
+    "add reg 4",
+    "add reg const 8",
+    "add reg const 4",
+    "sub reg 8",
+    "sub reg 4",
+    "sub reg const 8",
+    "sub reg const 4",
+    "mul reg 8",
+    "mul reg 4",
+    "mul reg const 8",
+    "mul reg const 4",
+    "cmp reg",
+    "cmp reg const",
+    "cmp reverse reg",
+    "cmp reverse reg const",
+    "if not reg jump",
     "no op"    
 };
 
 
+// lookup table for instruction sizes, OpCode byte included
+static const unsigned char opCodeSizes[] =
+{
+    2,  // exit
+    1,  // add
+    1,  // sub
+    1,  // mul
+    1,  // div
+    1,  // cmp
+    1,  // cmp reverse
+    9,  // ld const A 8
+    5,  // ld const A 4
+    2,  // ld const A 1
+    2,  // ld const A bit
+    9,  // ld const B 8
+    5,  // ld const B 4
+    2,  // ld const B 1
+    2,  // ld const B bit
+    9,  // ld const RESULT 8
+    5,  // ld const RESULT 4
+    2,  // ld const RESULT 1
+    2,  // ld const RESULT bit
+    9,  // ld A 8
+    9,  // ld A 4
+    9,  // ld A 1
+    9,  // ld A bit
+    9,  // ld B 8
+    9,  // ld B 4
+    9,  // ld B 1
+    9,  // ld B bit
+    9,  // ld RESULT 8
+    9,  // ld RESULT 4
+    9,  // ld RESULT 1
+    9,  // ld RESULT bit
+    9,  // ld ZERO FLAG
+    17, // mem mov 8
+    17, // mem mov 4
+    17, // mem mov 1
+    17, // mem mov bit
+    10, // reg mov 8
+    10, // reg mov 4
+    10, // reg mov 1
+    10, // reg mov bit
+    3,  // reg to reg
+    17, // mem set 8
+    13, // mem set 4
+    10, // mem set 1
+    10, // mem set bit
+    9,  // jmp
+    9,  // if jump
+    9,  // if not jump
+    9,  // push const
+    2,  // push reg
+    9,  // push bytes
+    9,  // pop
+    1,  // call
+    1,  // print
+    25, // add mem 8
+    25, // add mem 4
+    25, // add mem const 8
+    21, // add mem const 4
+    25, // sub mem 8
+    25, // sub mem 4
+    25, // sub mem const 8
+    21, // sub mem const 4
+    25, // mul mem 8
+    25, // mul mem 4
+    25, // mul mem const 8
+    21, // mul mem const 4
+    17, // cmp mem 8
+    17, // cmp mem 4
+    17, // cmp mem const 8
+    13, // cmp mem const 4
+    17, // cmp reverse mem 8
+    17, // cmp reverse mem 4
+    17, // cmp reverse mem const 8
+    13, // cmp reverse mem const 4
+    17, // if not mem jump
+    10, // ld reg 8
+    10, // ld reg 4
+    10, // ld reg 1
+    10, // ld reg bit
+    10, // ld const reg
+    3,  // reg to reg 4
+    3,  // reg to reg 1
+    3,  // reg to reg bit
+    4,  // add reg 8
+    4,  // add reg 4
+    11, // add reg const 8
+    11, // add reg const 4
+    4,  // sub reg 8
+    4,  // sub reg 4
+    11, // sub reg const 8
+    11, // sub reg const 4
+    4,  // mul reg 8
+    4,  // mul reg 4
+    11, // mul reg const 8
+    11, // mul reg const 4
+    3,  // cmp reg
+    10, // cmp reg const
+    3,  // cmp reverse reg
+    10, // cmp reverse reg const
+    10, // if not reg jump
+    1,  // no op
+};
+
+
+size_t pvm::instructionSize(OpCode opCode)
+{
+    return opCodeSizes[(unsigned char) opCode];
+}
+
+
 std::ostream& operator<<(std::ostream& stream, const OpCode opCode)
 {
     return stream << opCodeNames[(unsigned char) opCode];
@@ -5,63 +5,105 @@ using namespace pvm;
 
 
 ByteList::ByteList()
-: start(nullptr), end(nullptr), nodeCount(0), byteSize(0)
+: bytes(), jumpTargets(), lineTable()
 {
 
 }
 
 
-ByteList::~ByteList()
+void ByteList::add(OpCode opCode)
 {
-    for (ByteNode* node = start; node != nullptr; )
-    {
-        ByteNode* tmp = node;
-        node = node->next;
-        delete tmp;
-    }
+    bytes.push_back((Byte) opCode);
 }
 
 
-void ByteList::add(ByteNode* node)
+void ByteList::add(Registers reg)
 {
-    node->next = nullptr;
-    node->prev = end;
+    bytes.push_back((Byte) reg);
+}
 
-    if (start == nullptr)
-    {
-        start = node;
-    }
-    else
+
+void ByteList::add(Value data, InstructionSize dataSize)
+{
+    const size_t offset = bytes.size();
+    bytes.resize(offset + dataSize);
+
+    // copy the first "dataSize" bytes of the data
+    memcpy(bytes.data() + offset, &data, dataSize);
+}
+
+
+size_t ByteList::addJumpTarget(size_t target)
+{
+    const size_t operand = bytes.size();
+
+    add(target, sizeof(size_t));
+    jumpTargets.push_back(operand);
+
+    return operand;
+}
+
+
+void ByteList::setJumpTarget(size_t operand, size_t target)
+{
+    memcpy(bytes.data() + operand, &target, sizeof(size_t));
+}
+
+
+// byte code from the given offset onwards comes from the given source location
+// offsets must be added in increasing order
+static void addLocation(std::vector<LineEntry>& lineTable, size_t offset, uint32_t line, uint32_t column)
+{
+    if (!lineTable.empty())
     {
-        end->next = node;
+        LineEntry& last = lineTable.back();
+
+        if (last.line == line && last.column == column)
+        {
+            return;
+        }
+
+        // nothing was emitted since the last location, so it covers no byte code
+        if (last.offset == offset)
+        {
+            last.line = line;
+            last.column = column;
+            return;
+        }
     }
 
-    end = node;
+    lineTable.push_back({ offset, line, column });
+}
+
 
-    nodeCount ++;
-    byteSize += node->dataSize;
+void ByteList::setLocation(uint32_t line, uint32_t column)
+{
+    addLocation(lineTable, bytes.size(), line, column);
 }
 
 
 void ByteList::extend(ByteList& other)
 {
-    if (other.start != nullptr)
-    {
-        other.start->prev = end;
-    }
+    // the other list's jump targets are relative to its beginning,
+    // which is now at the end of this list
+    const size_t base = bytes.size();
 
-    if (end != nullptr)
+    for (size_t operand : other.jumpTargets)
     {
-        end->next = other.start;
+        size_t target;
+        memcpy(&target, other.bytes.data() + operand, sizeof(size_t));
+
+        other.setJumpTarget(operand, target + base);
+
+        jumpTargets.push_back(operand + base);
     }
 
-    if (other.end != nullptr)
+    for (const LineEntry& entry : other.lineTable)
     {
-        end = other.end;
+        addLocation(lineTable, entry.offset + base, entry.line, entry.column);
     }
 
-    nodeCount += other.nodeCount;
-    byteSize += other.byteSize;
+    bytes.insert(bytes.end(), other.bytes.begin(), other.bytes.end());
 
     other.clear();
 }
@@ -69,34 +111,170 @@ void ByteList::extend(ByteList& other)
 
 void ByteList::clear()
 {
-    start = nullptr;
-    end = nullptr;
-    byteSize = 0;
-    nodeCount = 0;
+    bytes.clear();
+    jumpTargets.clear();
+    lineTable.clear();
 }
 
 
 ByteCode ByteList::toByteCode() const
 {
+    Byte* byteCode = new Byte[bytes.size()];
 
-    Byte* bytes = new Byte[byteSize];
+    memcpy(byteCode, bytes.data(), bytes.size());
 
-    ByteCode byteCode = ByteCode(bytes, byteSize);
+    return ByteCode(byteCode, bytes.size());
+}
 
-    size_t i = 0;
-    for (ByteNode* node = start; node != nullptr; node = node->next)
-    {
-        // copy "dataSize" bytes to the array of bytes from the node's data
-        memcpy(bytes + i, &node->data, node->dataSize);
-        i += node->dataSize;
-    }
 
-    return byteCode;
+ByteCode ByteList::lineTableToByteCode() const
+{
+    const size_t size = lineTable.size() * sizeof(LineEntry);
+
+    Byte* byteCode = new Byte[size];
+
+    memcpy(byteCode, lineTable.data(), size);
+
+    return ByteCode(byteCode, size);
 }
 
 
 size_t ByteList::getCurrentSize() const
 {
-    return byteSize;
+    return bytes.size();
 }
 
+
+// marks offsets that are not the beginning of an instruction
+#define NOT_AN_INSTRUCTION ((size_t) -1)
+
+
+static inline size_t getOffset(const Byte* bytes)
+{
+    size_t offset;
+    memcpy(&offset, bytes, sizeof(size_t));
+    return offset;
+}
+
+
+bool ByteList::splitInstructions(std::vector<ListInstruction>& instructions) const
+{
+    // maps every offset to the index of the instruction beginning there
+    std::vector<size_t> indexOf(bytes.size() + 1, NOT_AN_INSTRUCTION);
+
+    for (size_t offset = 0; offset < bytes.size(); )
+    {
+        if (bytes[offset] >= OP_CODE_COUNT)
+        {
+            return false;
+        }
+
+        const size_t size = instructionSize((OpCode) bytes[offset]);
+
+        if (offset + size > bytes.size())
+        {
+            return false;
+        }
+
+        indexOf[offset] = instructions.size();
+        instructions.push_back({ offset, false, bytes.data() + offset });
+        offset += size;
+    }
+
+    for (size_t operand : jumpTargets)
+    {
+        const size_t target = getOffset(bytes.data() + operand);
+
+        // jumping right past the last instruction is allowed
+        if (target == bytes.size())
+        {
+            continue;
+        }
+
+        if (target > bytes.size() || indexOf[target] == NOT_AN_INSTRUCTION)
+        {
+            return false;
+        }
+
+        instructions[indexOf[target]].isJumpTarget = true;
+    }
+
+    return true;
+}
+
+
+void ByteList::rewrite(const std::vector<ListInstruction>& instructions, const Rewriter& rewriter)
+{
+    // maps old offsets to new ones
+    std::vector<size_t> newOffsetOf(bytes.size() + 1, NOT_AN_INSTRUCTION);
+
+    // jump target operands not yet relocated are copied along with their instruction
+    std::vector<bool> isJumpTarget(bytes.size(), false);
+    for (size_t operand : jumpTargets)
+    {
+        isJumpTarget[operand] = true;
+    }
+
+    ByteList output;
+    output.bytes.reserve(bytes.size());
+
+    for (size_t i = 0; i != instructions.size(); )
+    {
+        const ListInstruction& instruction = instructions[i];
+
+        newOffsetOf[instruction.offset] = output.getCurrentSize();
+
+        const size_t replaced = rewriter(instructions, i, output);
+
+        if (replaced != 0)
+        {
+            i += replaced;
+            continue;
+        }
+
+        // copy the instruction as it is, keeping track of its jump targets
+        const size_t size = instructionSize(instruction.opCode());
+
+        for (size_t b = 0; b != size; b++)
+        {
+            if (isJumpTarget[instruction.offset + b])
+            {
+                output.jumpTargets.push_back(output.getCurrentSize());
+            }
+
+            output.bytes.push_back(instruction.bytes[b]);
+        }
+
+        i ++;
+    }
+
+    newOffsetOf[bytes.size()] = output.getCurrentSize();
+
+    // relocate every jump target to the new offsets
+    for (size_t operand : output.jumpTargets)
+    {
+        output.setJumpTarget(operand, newOffsetOf[getOffset(output.bytes.data() + operand)]);
+    }
+
+    // rewritten instructions take the location of the first instruction they replace
+    std::vector<LineEntry>::const_iterator entry = lineTable.begin();
+
+    for (const ListInstruction& instruction : instructions)
+    {
+        while (entry != lineTable.end() && entry->offset <= instruction.offset)
+        {
+            entry ++;
+        }
+
+        if (entry == lineTable.begin() || newOffsetOf[instruction.offset] == NOT_AN_INSTRUCTION)
+        {
+            continue;
+        }
+
+        addLocation(output.lineTable, newOffsetOf[instruction.offset], (entry - 1)->line, (entry - 1)->column);
+    }
+
+    bytes = std::move(output.bytes);
+    jumpTargets = std::move(output.jumpTargets);
+    lineTable = std::move(output.lineTable);
+}
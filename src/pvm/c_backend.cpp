@@ -0,0 +1,656 @@
+#include "pvm.hh"
+#include "errors.hh"
+
+#include "pch.hh"
+
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <limits.h>
+
+
+using namespace pvm;
+
+
+extern char** environ;
+
+
+// C variables holding the Pvm registers, indexed by Registers
+static const char* const registerVariables[] =
+{
+    "a",
+    "b",
+    "remainder",
+    "result",
+    "zf",
+    "sf",
+    "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7",
+    "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15",
+};
+
+
+// functions shared by every generated program
+// memory accesses go through memcpy so that unaligned addresses are fine
+static const char* const prelude =
+R"(#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* the Pvm memory */
+static unsigned char memory[MEMORY_SIZE];
+
+static inline int64_t get8(uint64_t address) { int64_t value; memcpy(&value, memory + address, 8); return value; }
+static inline int64_t get4(uint64_t address) { int32_t value; memcpy(&value, memory + address, 4); return value; }
+static inline int64_t get1(uint64_t address) { return memory[address]; }
+
+static inline void set8(uint64_t address, int64_t value) { memcpy(memory + address, &value, 8); }
+static inline void set4(uint64_t address, int64_t value) { int32_t narrow = (int32_t) value; memcpy(memory + address, &narrow, 4); }
+static inline void set1(uint64_t address, int64_t value) { memory[address] = (unsigned char) value; }
+static inline void setBit(uint64_t address, int64_t value) { memory[address] = value != 0; }
+
+/* arithmetic wraps around like in the Pvm, instead of being undefined */
+#define ADD(x, y) ((int64_t) ((uint64_t) (x) + (uint64_t) (y)))
+#define SUB(x, y) ((int64_t) ((uint64_t) (x) - (uint64_t) (y)))
+#define MUL(x, y) ((int64_t) ((uint64_t) (x) * (uint64_t) (y)))
+
+static void stackOverflow(void)
+{
+    fflush(stdout);
+    fputs("[Stack Overflow Error] the program ran out of memory, use -m to give it more\n", stderr);
+    exit(EXIT_FAILURE);
+}
+
+/* the stack pointer is checked when whole frames are pushed or popped, like in the Pvm */
+#define CHECK_STACK() do { if ((uint64_t) sp > MEMORY_SIZE) stackOverflow(); } while (0)
+
+/* pushes are checked as well, there are no guard pages here */
+#define PUSH(value) do { if ((uint64_t) sp + 8 > MEMORY_SIZE) stackOverflow(); set8(sp, value); sp += 8; } while (0)
+
+static void divisionError(int64_t dividend, int64_t divisor)
+{
+    fflush(stdout);
+
+    if (divisor == 0)
+    {
+        fprintf(stderr, "[Zero Division Error] the program divided %" PRId64 " by 0\n", dividend);
+    }
+    else
+    {
+        fputs("[Division Overflow Error] the program divided the smallest long by -1, the quotient doesn't fit in a long\n", stderr);
+    }
+
+    exit(EXIT_FAILURE);
+}
+
+/* divisions that would raise SIGFPE are errors, like in the Pvm */
+#define CHECK_DIVISION() do { if (b == 0 || (a == INT64_MIN && b == -1)) divisionError(a, b); } while (0)
+
+)";
+
+
+// main() of every generated program, follows the register names
+// run with -v, the program prints its state at exit in the format of Pvm::printState()
+static const char* const mainPrelude =
+R"(
+static void printState(const int64_t* registers)
+{
+    size_t used = MEMORY_SIZE;
+    size_t i;
+
+    printf("Registers:\n");
+
+    for (i = 0; i != sizeof(registerNames) / sizeof(registerNames[0]); i++)
+    {
+        printf("%s: %" PRId64 "\n", registerNames[i], registers[i]);
+    }
+
+    /* trailing zeros are left out, so the output doesn't depend on the memory size */
+    while (used != 0 && memory[used - 1] == 0)
+    {
+        used --;
+    }
+
+    printf("Memory: %zu bytes", used);
+
+    for (i = 0; i != used; i++)
+    {
+        if (i % 16 == 0)
+        {
+            printf("\n%08zx:", i);
+        }
+
+        printf(" %02x", memory[i]);
+    }
+
+    printf("\n");
+}
+
+
+int main(int argc, char** argv)
+{
+    const int verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+    int64_t a = 0, b = 0, remainder = 0, result = 0, zf = 0, sf = 0;
+    int64_t r0 = 0, r1 = 0, r2 = 0, r3 = 0, r4 = 0, r5 = 0, r6 = 0, r7 = 0;
+    int64_t r8 = 0, r9 = 0, r10 = 0, r11 = 0, r12 = 0, r13 = 0, r14 = 0, r15 = 0;
+
+    /* stack pointer */
+    int64_t sp = 0;
+
+)";
+
+
+// writes a long constant as a C expression
+static std::ostream& constant(std::ostream& stream, long value)
+{
+    // the smallest long can't be written as a literal
+    if (value == LONG_MIN)
+    {
+        return stream << "INT64_MIN";
+    }
+
+    return stream << "INT64_C(" << value << ')';
+}
+
+
+// suffix of the memory access functions for the OpCode's operand size
+static const char* widthSuffix(OpCode opCode)
+{
+    switch (opCode)
+    {
+    case OpCode::LD_A_8:
+    case OpCode::LD_B_8:
+    case OpCode::LD_RESULT_8:
+    case OpCode::MEM_MOV_8:
+    case OpCode::REG_MOV_8:
+    case OpCode::MEM_SET_8:
+    case OpCode::ADD_MEM_8:
+    case OpCode::ADD_MEM_CONST_8:
+    case OpCode::SUB_MEM_8:
+    case OpCode::SUB_MEM_CONST_8:
+    case OpCode::MUL_MEM_8:
+    case OpCode::MUL_MEM_CONST_8:
+    case OpCode::CMP_MEM_8:
+    case OpCode::CMP_MEM_CONST_8:
+    case OpCode::CMP_REVERSE_MEM_8:
+    case OpCode::CMP_REVERSE_MEM_CONST_8:
+    case OpCode::LD_REG_8:
+        return "8";
+
+    case OpCode::LD_A_4:
+    case OpCode::LD_B_4:
+    case OpCode::LD_RESULT_4:
+    case OpCode::MEM_MOV_4:
+    case OpCode::REG_MOV_4:
+    case OpCode::MEM_SET_4:
+    case OpCode::ADD_MEM_4:
+    case OpCode::ADD_MEM_CONST_4:
+    case OpCode::SUB_MEM_4:
+    case OpCode::SUB_MEM_CONST_4:
+    case OpCode::MUL_MEM_4:
+    case OpCode::MUL_MEM_CONST_4:
+    case OpCode::CMP_MEM_4:
+    case OpCode::CMP_MEM_CONST_4:
+    case OpCode::CMP_REVERSE_MEM_4:
+    case OpCode::CMP_REVERSE_MEM_CONST_4:
+    case OpCode::LD_REG_4:
+        return "4";
+
+    default:
+        return "1";
+    }
+}
+
+
+// writes the C statements of a single instruction
+// offsets maps instruction indices to byte code offsets, for jump labels
+static void translate(std::ostream& out, const Instruction& instruction, const std::vector<size_t>& offsets)
+{
+    const OpCode opCode = instruction.opCode;
+    const char* const width = widthSuffix(opCode);
+
+    switch (opCode)
+    {
+    case OpCode::EXIT:
+        out << "if (verbose) { printState((const int64_t[]) { ";
+
+        for (unsigned int reg = 0; reg != REGISTER_COUNT; reg++)
+        {
+            out << (reg == 0 ? "" : ", ") << registerVariables[reg];
+        }
+
+        out << " }); } fflush(stdout); return " << (unsigned int) (Byte) instruction.first << ';';
+        break;
+
+    case OpCode::ADD:
+        out << "result = ADD(a, b); sf = result < 0; zf = result == 0;";
+        break;
+    case OpCode::SUB:
+        out << "result = SUB(a, b); sf = result < 0; zf = result == 0;";
+        break;
+    case OpCode::MUL:
+        out << "result = MUL(a, b); sf = result < 0; zf = result == 0;";
+        break;
+    case OpCode::DIV:
+        // the remainder is computed from the result, like the Pvm does
+        out << "CHECK_DIVISION(); result = a / b; remainder = result % b; zf = result == 0;";
+        break;
+
+    case OpCode::CMP:
+        out << "zf = a == b;";
+        break;
+    case OpCode::CMP_REVERSE:
+        out << "zf = a != b;";
+        break;
+
+    case OpCode::LD_CONST_A_8:
+    case OpCode::LD_CONST_A_4:
+    case OpCode::LD_CONST_A_1:
+    case OpCode::LD_CONST_A_BIT:
+        constant(out << "a = ", instruction.first) << ';';
+        break;
+    case OpCode::LD_CONST_B_8:
+    case OpCode::LD_CONST_B_4:
+    case OpCode::LD_CONST_B_1:
+    case OpCode::LD_CONST_B_BIT:
+        constant(out << "b = ", instruction.first) << ';';
+        break;
+    case OpCode::LD_CONST_RESULT_8:
+    case OpCode::LD_CONST_RESULT_4:
+    case OpCode::LD_CONST_RESULT_1:
+    case OpCode::LD_CONST_RESULT_BIT:
+        constant(out << "result = ", instruction.first) << ';';
+        break;
+
+    case OpCode::LD_A_8:
+    case OpCode::LD_A_4:
+    case OpCode::LD_A_1:
+    case OpCode::LD_A_BIT:
+        out << "a = get" << width << '(' << instruction.first << ");";
+        break;
+    case OpCode::LD_B_8:
+    case OpCode::LD_B_4:
+    case OpCode::LD_B_1:
+    case OpCode::LD_B_BIT:
+        out << "b = get" << width << '(' << instruction.first << ");";
+        break;
+    case OpCode::LD_RESULT_8:
+    case OpCode::LD_RESULT_4:
+    case OpCode::LD_RESULT_1:
+    case OpCode::LD_RESULT_BIT:
+        out << "result = get" << width << '(' << instruction.first << ");";
+        break;
+    case OpCode::LD_ZERO_FLAG:
+        out << "zf = get1(" << instruction.first << ");";
+        break;
+
+    case OpCode::MEM_MOV_8:
+    case OpCode::MEM_MOV_4:
+    case OpCode::MEM_MOV_1:
+    case OpCode::MEM_MOV_BIT:
+        out << "set" << width << '(' << instruction.first << ", get" << width << '(' << instruction.second << "));";
+        break;
+
+    case OpCode::REG_MOV_8:
+    case OpCode::REG_MOV_4:
+    case OpCode::REG_MOV_1:
+        out << "set" << width << '(' << instruction.first << ", " << registerVariables[instruction.reg] << ");";
+        break;
+    case OpCode::REG_MOV_BIT:
+        out << "setBit(" << instruction.first << ", " << registerVariables[instruction.reg] << ");";
+        break;
+
+    case OpCode::REG_TO_REG:
+        out << registerVariables[instruction.reg] << " = " << registerVariables[instruction.reg2] << ';';
+        break;
+
+    case OpCode::MEM_SET_8:
+    case OpCode::MEM_SET_4:
+    case OpCode::MEM_SET_1:
+        constant(out << "set" << width << '(' << instruction.first << ", ", instruction.second) << ");";
+        break;
+    case OpCode::MEM_SET_BIT:
+        constant(out << "setBit(" << instruction.first << ", ", instruction.second) << ");";
+        break;
+
+    case OpCode::JMP:
+        out << "goto L_" << offsets[instruction.first] << ';';
+        break;
+    case OpCode::IF_JUMP:
+        out << "if (zf) goto L_" << offsets[instruction.first] << ';';
+        break;
+    case OpCode::IF_NOT_JUMP:
+        out << "if (!zf) goto L_" << offsets[instruction.first] << ';';
+        break;
+
+    case OpCode::PUSH_CONST:
+        constant(out << "PUSH(", instruction.first) << ");";
+        break;
+    case OpCode::PUSH_REG:
+        out << "PUSH(" << registerVariables[instruction.reg] << ");";
+        break;
+    case OpCode::PUSH_BYTES:
+        constant(out << "sp = ADD(sp, ", instruction.first) << "); CHECK_STACK();";
+        break;
+    case OpCode::POP:
+        constant(out << "sp = SUB(sp, ", instruction.first) << "); CHECK_STACK();";
+        break;
+
+    case OpCode::PRINT:
+        out << "printf(\"%\" PRId64, a);";
+        break;
+
+    // fused instructions leave the registers as the sequences they replace
+    case OpCode::ADD_MEM_8:
+    case OpCode::ADD_MEM_4:
+    case OpCode::SUB_MEM_8:
+    case OpCode::SUB_MEM_4:
+    case OpCode::MUL_MEM_8:
+    case OpCode::MUL_MEM_4:
+    case OpCode::ADD_MEM_CONST_8:
+    case OpCode::ADD_MEM_CONST_4:
+    case OpCode::SUB_MEM_CONST_8:
+    case OpCode::SUB_MEM_CONST_4:
+    case OpCode::MUL_MEM_CONST_8:
+    case OpCode::MUL_MEM_CONST_4:
+    {
+        const char* operation;
+        bool isConstant = false;
+
+        switch (opCode)
+        {
+        case OpCode::ADD_MEM_CONST_8:
+        case OpCode::ADD_MEM_CONST_4:
+            isConstant = true;
+            // fall through
+        case OpCode::ADD_MEM_8:
+        case OpCode::ADD_MEM_4:
+            operation = "ADD";
+            break;
+        case OpCode::SUB_MEM_CONST_8:
+        case OpCode::SUB_MEM_CONST_4:
+            isConstant = true;
+            // fall through
+        case OpCode::SUB_MEM_8:
+        case OpCode::SUB_MEM_4:
+            operation = "SUB";
+            break;
+        case OpCode::MUL_MEM_CONST_8:
+        case OpCode::MUL_MEM_CONST_4:
+            isConstant = true;
+            // fall through
+        default:
+            operation = "MUL";
+            break;
+        }
+
+        out << "a = get" << width << '(' << instruction.second << "); ";
+
+        if (isConstant)
+        {
+            constant(out << "b = ", instruction.third) << "; ";
+        }
+        else
+        {
+            out << "b = get" << width << '(' << instruction.third << "); ";
+        }
+
+        out << "result = " << operation << "(a, b); sf = result < 0; zf = result == 0; "
+            << "set" << width << '(' << instruction.first << ", result);";
+        break;
+    }
+
+    case OpCode::CMP_MEM_8:
+    case OpCode::CMP_MEM_4:
+        out << "a = get" << width << '(' << instruction.first << "); b = get" << width << '(' << instruction.second << "); zf = a == b;";
+        break;
+    case OpCode::CMP_REVERSE_MEM_8:
+    case OpCode::CMP_REVERSE_MEM_4:
+        out << "a = get" << width << '(' << instruction.first << "); b = get" << width << '(' << instruction.second << "); zf = a != b;";
+        break;
+    case OpCode::CMP_MEM_CONST_8:
+    case OpCode::CMP_MEM_CONST_4:
+        constant(out << "a = get" << width << '(' << instruction.first << "); b = ", instruction.second) << "; zf = a == b;";
+        break;
+    case OpCode::CMP_REVERSE_MEM_CONST_8:
+    case OpCode::CMP_REVERSE_MEM_CONST_4:
+        constant(out << "a = get" << width << '(' << instruction.first << "); b = ", instruction.second) << "; zf = a != b;";
+        break;
+
+    case OpCode::IF_NOT_MEM_JUMP:
+        out << "a = get1(" << instruction.second << "); b = 0; zf = !a; if (zf) goto L_" << offsets[instruction.first] << ';';
+        break;
+
+    case OpCode::LD_REG_8:
+    case OpCode::LD_REG_4:
+    case OpCode::LD_REG_1:
+    case OpCode::LD_REG_BIT:
+        out << registerVariables[instruction.reg] << " = get" << width << '(' << instruction.first << ')';
+        out << (opCode == OpCode::LD_REG_BIT ? " != 0;" : ";");
+        break;
+
+    case OpCode::LD_CONST_REG:
+        constant(out << registerVariables[instruction.reg] << " = ", instruction.first) << ';';
+        break;
+
+    case OpCode::REG_TO_REG_4:
+        out << registerVariables[instruction.reg] << " = (int32_t) " << registerVariables[instruction.reg2] << ';';
+        break;
+    case OpCode::REG_TO_REG_1:
+        out << registerVariables[instruction.reg] << " = (unsigned char) " << registerVariables[instruction.reg2] << ';';
+        break;
+    case OpCode::REG_TO_REG_BIT:
+        out << registerVariables[instruction.reg] << " = " << registerVariables[instruction.reg2] << " != 0;";
+        break;
+
+    // fused register instructions leave the registers as the sequences they replace
+    case OpCode::ADD_REG_8:
+    case OpCode::ADD_REG_4:
+    case OpCode::SUB_REG_8:
+    case OpCode::SUB_REG_4:
+    case OpCode::MUL_REG_8:
+    case OpCode::MUL_REG_4:
+    case OpCode::ADD_REG_CONST_8:
+    case OpCode::ADD_REG_CONST_4:
+    case OpCode::SUB_REG_CONST_8:
+    case OpCode::SUB_REG_CONST_4:
+    case OpCode::MUL_REG_CONST_8:
+    case OpCode::MUL_REG_CONST_4:
+    {
+        const char* operation;
+        bool isConstant = false;
+        bool isInt = false;
+
+        switch (opCode)
+        {
+        case OpCode::ADD_REG_CONST_4:
+            isInt = true;
+            // fall through
+        case OpCode::ADD_REG_CONST_8:
+            isConstant = true;
+            operation = "ADD";
+            break;
+        case OpCode::ADD_REG_4:
+            isInt = true;
+            // fall through
+        case OpCode::ADD_REG_8:
+            operation = "ADD";
+            break;
+        case OpCode::SUB_REG_CONST_4:
+            isInt = true;
+            // fall through
+        case OpCode::SUB_REG_CONST_8:
+            isConstant = true;
+            operation = "SUB";
+            break;
+        case OpCode::SUB_REG_4:
+            isInt = true;
+            // fall through
+        case OpCode::SUB_REG_8:
+            operation = "SUB";
+            break;
+        case OpCode::MUL_REG_CONST_4:
+            isInt = true;
+            // fall through
+        case OpCode::MUL_REG_CONST_8:
+            isConstant = true;
+            operation = "MUL";
+            break;
+        case OpCode::MUL_REG_4:
+            isInt = true;
+            // fall through
+        default:
+            operation = "MUL";
+            break;
+        }
+
+        out << "a = " << registerVariables[instruction.reg2] << "; ";
+
+        if (isConstant)
+        {
+            constant(out << "b = ", instruction.first) << "; ";
+        }
+        else
+        {
+            out << "b = " << registerVariables[instruction.reg3] << "; ";
+        }
+
+        out << "result = " << operation << "(a, b); sf = result < 0; zf = result == 0; "
+            << registerVariables[instruction.reg] << (isInt ? " = (int32_t) result;" : " = result;");
+        break;
+    }
+
+    case OpCode::CMP_REG:
+        out << "a = " << registerVariables[instruction.reg] << "; b = " << registerVariables[instruction.reg2] << "; zf = a == b;";
+        break;
+    case OpCode::CMP_REVERSE_REG:
+        out << "a = " << registerVariables[instruction.reg] << "; b = " << registerVariables[instruction.reg2] << "; zf = a != b;";
+        break;
+    case OpCode::CMP_REG_CONST:
+        constant(out << "a = " << registerVariables[instruction.reg] << "; b = ", instruction.first) << "; zf = a == b;";
+        break;
+    case OpCode::CMP_REVERSE_REG_CONST:
+        constant(out << "a = " << registerVariables[instruction.reg] << "; b = ", instruction.first) << "; zf = a != b;";
+        break;
+
+    case OpCode::IF_NOT_REG_JUMP:
+        out << "a = " << registerVariables[instruction.reg] << "; b = 0; zf = !a; if (zf) goto L_" << offsets[instruction.first] << ';';
+        break;
+
+    case OpCode::CALL:
+    case OpCode::NO_OP:
+        out << ';';
+        break;
+    }
+}
+
+
+void pvm::generateC(const ByteCode& byteCode, std::ostream& out, size_t memorySize)
+{
+    // decoding validates the byte code and resolves jump targets
+    const std::vector<Instruction> program = decode(byteCode);
+
+    // static addresses are checked once, here, like the Pvm does before running
+    const size_t required = requiredMemory(program);
+
+    if (required > memorySize)
+    {
+        errors::InsufficientMemoryError(required, memorySize);
+    }
+
+    // byte code offset of every instruction, plus the end of the byte code
+    std::vector<size_t> offsets(program.size() + 1);
+
+    for (size_t i = 0; i < program.size(); i++)
+    {
+        offsets[i + 1] = offsets[i] + instructionSize(program[i].opCode);
+    }
+
+    out << "/* generated by pcc, do not edit */\n\n"
+        << "#define MEMORY_SIZE " << memorySize << "u\n\n"
+        << prelude;
+
+    // names printed by printState(), the same as the Pvm's
+    out << "static const char* const registerNames[] = { ";
+
+    for (unsigned int reg = 0; reg != REGISTER_COUNT; reg++)
+    {
+        out << (reg == 0 ? "\"" : ", \"") << registerName((Registers) reg) << '"';
+    }
+
+    out << " };\n" << mainPrelude;
+
+    // one label per byte code offset
+    for (size_t i = 0; i < program.size(); i++)
+    {
+        out << "L_" << offsets[i] << ": /* " << program[i].opCode << " */\n    ";
+        translate(out, program[i], offsets);
+        out << '\n';
+    }
+
+    // unreachable, decode() rejects programs that can run past their last instruction
+    out << "L_" << offsets[program.size()] << ":\n    abort();\n}\n";
+}
+
+
+void pvm::generateCFile(const ByteCode& byteCode, const char* name, size_t memorySize)
+{
+    std::ofstream file(name);
+
+    if (!file.is_open())
+    {
+        errors::FileWriteError(name);
+    }
+
+    generateC(byteCode, file, memorySize);
+
+    file.close();
+
+    if (file.fail())
+    {
+        errors::FileWriteError(name);
+    }
+}
+
+
+void pvm::generateNativeExecutable(const ByteCode& byteCode, const char* name, size_t memorySize)
+{
+    // the translation is only needed while the C compiler runs
+    char source[] = "/tmp/pccXXXXXX.c";
+    const int descriptor = mkstemps(source, 2);
+
+    if (descriptor == -1)
+    {
+        errors::FileWriteError(source);
+    }
+
+    close(descriptor);
+
+    generateCFile(byteCode, source, memorySize);
+
+    // the system C compiler can be overridden like in make
+    const char* compiler = getenv("CC");
+
+    if (compiler == nullptr || *compiler == '\0')
+    {
+        compiler = "cc";
+    }
+
+    const char* const arguments[] = { compiler, "-O2", "-o", name, source, nullptr };
+
+    pid_t process;
+    int status = 0;
+
+    const bool spawned = posix_spawnp(&process, compiler, nullptr, nullptr, (char* const*) arguments, environ) == 0
+        && waitpid(process, &status, 0) == process;
+
+    unlink(source);
+
+    if (!spawned || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        errors::CCompilerError(compiler);
+    }
+}
+
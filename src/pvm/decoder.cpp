@@ -0,0 +1,414 @@
+#include "pvm.hh"
+#include "errors.hh"
+
+
+using namespace pvm;
+
+
+static inline long getLong(const Byte* bytes, size_t i)
+{
+    return *((long*) (bytes + i));
+}
+
+
+static inline int getInt(const Byte* bytes, size_t i)
+{
+    return *((int*) (bytes + i));
+}
+
+
+// marks byte code offsets that are not the beginning of an instruction
+#define NOT_AN_INSTRUCTION ((size_t) -1)
+
+
+std::vector<Instruction> pvm::decode(const ByteCode& byteCode)
+{
+    const Byte* const bytes = byteCode.byteCode;
+
+    std::vector<Instruction> program;
+
+    // maps every byte code offset to the index of the instruction beginning there
+    std::vector<size_t> indexOf(byteCode.size, NOT_AN_INSTRUCTION);
+
+    for (size_t offset = 0; offset < byteCode.size; )
+    {
+        if (bytes[offset] >= OP_CODE_COUNT)
+        {
+            errors::InvalidByteCodeError(
+                "invalid OpCode " + std::to_string(bytes[offset]) + " at offset " + std::to_string(offset));
+        }
+
+        const OpCode opCode = (OpCode) bytes[offset];
+        const size_t size = instructionSize(opCode);
+
+        if (offset + size > byteCode.size)
+        {
+            errors::InvalidByteCodeError(
+                "truncated instruction at offset " + std::to_string(offset));
+        }
+
+        indexOf[offset] = program.size();
+
+        // operands begin right after the OpCode byte
+        const size_t op = offset + 1;
+
+        Instruction instruction = { opCode, 0, 0, 0, 0, 0, 0 };
+
+        switch (opCode)
+        {
+        case OpCode::EXIT:
+            instruction.first = bytes[op];
+            break;
+
+        case OpCode::LD_CONST_A_8:
+        case OpCode::LD_CONST_B_8:
+        case OpCode::LD_CONST_RESULT_8:
+            instruction.first = getLong(bytes, op);
+            break;
+
+        case OpCode::LD_CONST_A_4:
+        case OpCode::LD_CONST_B_4:
+        case OpCode::LD_CONST_RESULT_4:
+            instruction.first = getInt(bytes, op);
+            break;
+
+        case OpCode::LD_CONST_A_1:
+        case OpCode::LD_CONST_B_1:
+        case OpCode::LD_CONST_RESULT_1:
+            instruction.first = bytes[op];
+            break;
+
+        case OpCode::LD_CONST_A_BIT:
+        case OpCode::LD_CONST_B_BIT:
+        case OpCode::LD_CONST_RESULT_BIT:
+            instruction.first = (bool) bytes[op];
+            break;
+
+        // single address or single long operand
+        case OpCode::LD_A_8:
+        case OpCode::LD_A_4:
+        case OpCode::LD_A_1:
+        case OpCode::LD_A_BIT:
+        case OpCode::LD_B_8:
+        case OpCode::LD_B_4:
+        case OpCode::LD_B_1:
+        case OpCode::LD_B_BIT:
+        case OpCode::LD_RESULT_8:
+        case OpCode::LD_RESULT_4:
+        case OpCode::LD_RESULT_1:
+        case OpCode::LD_RESULT_BIT:
+        case OpCode::LD_ZERO_FLAG:
+        case OpCode::PUSH_CONST:
+        case OpCode::PUSH_BYTES:
+        case OpCode::POP:
+        // jump targets are resolved once every instruction is decoded
+        case OpCode::JMP:
+        case OpCode::IF_JUMP:
+        case OpCode::IF_NOT_JUMP:
+            instruction.first = getLong(bytes, op);
+            break;
+
+        case OpCode::MEM_MOV_8:
+        case OpCode::MEM_MOV_4:
+        case OpCode::MEM_MOV_1:
+        case OpCode::MEM_MOV_BIT:
+        case OpCode::MEM_SET_8:
+            instruction.first = getLong(bytes, op);
+            instruction.second = getLong(bytes, op + sizeof(long));
+            break;
+
+        case OpCode::MEM_SET_4:
+            instruction.first = getLong(bytes, op);
+            instruction.second = getInt(bytes, op + sizeof(long));
+            break;
+
+        case OpCode::MEM_SET_1:
+            instruction.first = getLong(bytes, op);
+            instruction.second = bytes[op + sizeof(long)];
+            break;
+
+        case OpCode::MEM_SET_BIT:
+            instruction.first = getLong(bytes, op);
+            instruction.second = (bool) bytes[op + sizeof(long)];
+            break;
+
+        case OpCode::REG_MOV_8:
+        case OpCode::REG_MOV_4:
+        case OpCode::REG_MOV_1:
+        case OpCode::REG_MOV_BIT:
+            instruction.first = getLong(bytes, op);
+            instruction.reg = bytes[op + sizeof(long)];
+            break;
+
+        case OpCode::REG_TO_REG:
+            instruction.reg = bytes[op];
+            instruction.reg2 = bytes[op + 1];
+            break;
+
+        case OpCode::PUSH_REG:
+            instruction.reg = bytes[op];
+            break;
+
+        case OpCode::ADD_MEM_8:
+        case OpCode::ADD_MEM_4:
+        case OpCode::SUB_MEM_8:
+        case OpCode::SUB_MEM_4:
+        case OpCode::MUL_MEM_8:
+        case OpCode::MUL_MEM_4:
+        case OpCode::ADD_MEM_CONST_8:
+        case OpCode::SUB_MEM_CONST_8:
+        case OpCode::MUL_MEM_CONST_8:
+            instruction.first = getLong(bytes, op);
+            instruction.second = getLong(bytes, op + sizeof(long));
+            instruction.third = getLong(bytes, op + 2 * sizeof(long));
+            break;
+
+        case OpCode::ADD_MEM_CONST_4:
+        case OpCode::SUB_MEM_CONST_4:
+        case OpCode::MUL_MEM_CONST_4:
+            instruction.first = getLong(bytes, op);
+            instruction.second = getLong(bytes, op + sizeof(long));
+            instruction.third = getInt(bytes, op + 2 * sizeof(long));
+            break;
+
+        case OpCode::CMP_MEM_8:
+        case OpCode::CMP_MEM_4:
+        case OpCode::CMP_REVERSE_MEM_8:
+        case OpCode::CMP_REVERSE_MEM_4:
+        case OpCode::CMP_MEM_CONST_8:
+        case OpCode::CMP_REVERSE_MEM_CONST_8:
+            instruction.first = getLong(bytes, op);
+            instruction.second = getLong(bytes, op + sizeof(long));
+            break;
+
+        case OpCode::CMP_MEM_CONST_4:
+        case OpCode::CMP_REVERSE_MEM_CONST_4:
+            instruction.first = getLong(bytes, op);
+            instruction.second = getInt(bytes, op + sizeof(long));
+            break;
+
+        case OpCode::IF_NOT_MEM_JUMP:
+            // the jump target goes first, like for every other jump
+            instruction.first = getLong(bytes, op + sizeof(long));
+            instruction.second = getLong(bytes, op);
+            break;
+
+        case OpCode::LD_REG_8:
+        case OpCode::LD_REG_4:
+        case OpCode::LD_REG_1:
+        case OpCode::LD_REG_BIT:
+        case OpCode::LD_CONST_REG:
+        case OpCode::CMP_REG_CONST:
+        case OpCode::CMP_REVERSE_REG_CONST:
+            instruction.reg = bytes[op];
+            instruction.first = getLong(bytes, op + 1);
+            break;
+
+        case OpCode::REG_TO_REG_4:
+        case OpCode::REG_TO_REG_1:
+        case OpCode::REG_TO_REG_BIT:
+        case OpCode::CMP_REG:
+        case OpCode::CMP_REVERSE_REG:
+            instruction.reg = bytes[op];
+            instruction.reg2 = bytes[op + 1];
+            break;
+
+        case OpCode::ADD_REG_8:
+        case OpCode::ADD_REG_4:
+        case OpCode::SUB_REG_8:
+        case OpCode::SUB_REG_4:
+        case OpCode::MUL_REG_8:
+        case OpCode::MUL_REG_4:
+            instruction.reg = bytes[op];
+            instruction.reg2 = bytes[op + 1];
+            instruction.reg3 = bytes[op + 2];
+            break;
+
+        case OpCode::ADD_REG_CONST_8:
+        case OpCode::ADD_REG_CONST_4:
+        case OpCode::SUB_REG_CONST_8:
+        case OpCode::SUB_REG_CONST_4:
+        case OpCode::MUL_REG_CONST_8:
+        case OpCode::MUL_REG_CONST_4:
+            instruction.reg = bytes[op];
+            instruction.reg2 = bytes[op + 1];
+            instruction.first = getLong(bytes, op + 2);
+            break;
+
+        case OpCode::IF_NOT_REG_JUMP:
+            // the jump target goes first, like for every other jump
+            instruction.first = getLong(bytes, op + 1);
+            instruction.reg = bytes[op];
+            break;
+
+        } // switch (opCode)
+
+        if (instruction.reg >= REGISTER_COUNT || instruction.reg2 >= REGISTER_COUNT
+            || instruction.reg3 >= REGISTER_COUNT)
+        {
+            errors::InvalidByteCodeError(
+                "invalid register operand at offset " + std::to_string(offset));
+        }
+
+        program.push_back(instruction);
+
+        offset += size;
+    }
+
+    // the engines have nothing to dispatch past the last instruction, so it
+    // has to leave the program or jump back into it
+    if (program.empty())
+    {
+        errors::InvalidByteCodeError("empty program");
+    }
+
+    const OpCode lastOpCode = program.back().opCode;
+
+    if (lastOpCode != OpCode::EXIT && lastOpCode != OpCode::JMP)
+    {
+        errors::InvalidByteCodeError(
+            "the program can run past its last instruction, which isn't EXIT or JMP");
+    }
+
+    // resolve jump targets from byte code offsets to instruction indices
+    for (Instruction& instruction : program)
+    {
+        if (!isJump(instruction.opCode))
+        {
+            continue;
+        }
+
+        const size_t target = (size_t) instruction.first;
+
+        if (target >= byteCode.size || indexOf[target] == NOT_AN_INSTRUCTION)
+        {
+            errors::InvalidByteCodeError(
+                "jump to offset " + std::to_string(target) + ", which is not the beginning of an instruction");
+        }
+
+        instruction.first = (long) indexOf[target];
+    }
+
+    return program;
+}
+
+
+// returns the end of the memory range accessed at the given address
+// addresses are unsigned, so negative ones end up past any memory
+static inline size_t rangeEnd(long address, size_t width)
+{
+    const size_t end = (size_t) address + width;
+
+    // ranges that wrap around can't fit in any memory
+    return end < width ? (size_t) -1 : end;
+}
+
+
+size_t pvm::requiredMemory(const std::vector<Instruction>& program)
+{
+    size_t required = 0;
+
+    for (const Instruction& instruction : program)
+    {
+        size_t end = 0;
+
+        switch (instruction.opCode)
+        {
+        case OpCode::LD_A_8:
+        case OpCode::LD_B_8:
+        case OpCode::LD_RESULT_8:
+        case OpCode::REG_MOV_8:
+        case OpCode::MEM_SET_8:
+        case OpCode::CMP_MEM_CONST_8:
+        case OpCode::CMP_REVERSE_MEM_CONST_8:
+        case OpCode::LD_REG_8:
+            end = rangeEnd(instruction.first, sizeof(long));
+            break;
+
+        case OpCode::LD_A_4:
+        case OpCode::LD_B_4:
+        case OpCode::LD_RESULT_4:
+        case OpCode::REG_MOV_4:
+        case OpCode::MEM_SET_4:
+        case OpCode::CMP_MEM_CONST_4:
+        case OpCode::CMP_REVERSE_MEM_CONST_4:
+        case OpCode::LD_REG_4:
+            end = rangeEnd(instruction.first, sizeof(int));
+            break;
+
+        case OpCode::LD_A_1:
+        case OpCode::LD_A_BIT:
+        case OpCode::LD_B_1:
+        case OpCode::LD_B_BIT:
+        case OpCode::LD_RESULT_1:
+        case OpCode::LD_RESULT_BIT:
+        case OpCode::LD_ZERO_FLAG:
+        case OpCode::REG_MOV_1:
+        case OpCode::REG_MOV_BIT:
+        case OpCode::MEM_SET_1:
+        case OpCode::MEM_SET_BIT:
+        case OpCode::LD_REG_1:
+        case OpCode::LD_REG_BIT:
+            end = rangeEnd(instruction.first, sizeof(Byte));
+            break;
+
+        case OpCode::MEM_MOV_8:
+        case OpCode::CMP_MEM_8:
+        case OpCode::CMP_REVERSE_MEM_8:
+        case OpCode::ADD_MEM_CONST_8:
+        case OpCode::SUB_MEM_CONST_8:
+        case OpCode::MUL_MEM_CONST_8:
+            end = std::max(
+                rangeEnd(instruction.first, sizeof(long)),
+                rangeEnd(instruction.second, sizeof(long)));
+            break;
+
+        case OpCode::MEM_MOV_4:
+        case OpCode::CMP_MEM_4:
+        case OpCode::CMP_REVERSE_MEM_4:
+        case OpCode::ADD_MEM_CONST_4:
+        case OpCode::SUB_MEM_CONST_4:
+        case OpCode::MUL_MEM_CONST_4:
+            end = std::max(
+                rangeEnd(instruction.first, sizeof(int)),
+                rangeEnd(instruction.second, sizeof(int)));
+            break;
+
+        case OpCode::MEM_MOV_1:
+        case OpCode::MEM_MOV_BIT:
+            end = std::max(
+                rangeEnd(instruction.first, sizeof(Byte)),
+                rangeEnd(instruction.second, sizeof(Byte)));
+            break;
+
+        case OpCode::ADD_MEM_8:
+        case OpCode::SUB_MEM_8:
+        case OpCode::MUL_MEM_8:
+            end = std::max({
+                rangeEnd(instruction.first, sizeof(long)),
+                rangeEnd(instruction.second, sizeof(long)),
+                rangeEnd(instruction.third, sizeof(long)) });
+            break;
+
+        case OpCode::ADD_MEM_4:
+        case OpCode::SUB_MEM_4:
+        case OpCode::MUL_MEM_4:
+            end = std::max({
+                rangeEnd(instruction.first, sizeof(int)),
+                rangeEnd(instruction.second, sizeof(int)),
+                rangeEnd(instruction.third, sizeof(int)) });
+            break;
+
+        case OpCode::IF_NOT_MEM_JUMP:
+            end = rangeEnd(instruction.second, sizeof(Byte));
+            break;
+
+        } // switch (instruction.opCode)
+
+        required = std::max(required, end);
+    }
+
+    return required;
+}
+
+
@@ -3,11 +3,41 @@
 
 #include "pch.hh"
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 
 using namespace pvm;
 
 
-void pvm::generateExecutable(ByteCode byteCode, const char* name)
+// 32 bit FNV-1a hash of the header, with the checksum field taken as 0
+static uint32_t headerChecksum(ExecutableHeader header)
+{
+    header.checksum = 0;
+
+    const Byte* bytes = (const Byte*) &header;
+
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < sizeof(ExecutableHeader); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+
+static inline uint64_t alignSection(uint64_t offset)
+{
+    return (offset + PFX_SECTION_ALIGNMENT - 1) / PFX_SECTION_ALIGNMENT * PFX_SECTION_ALIGNMENT;
+}
+
+
+void pvm::generateExecutable(ByteCode byteCode, ByteCode lineTable, const char* name)
 {
     std::ofstream file(name, std::ios::binary);
 
@@ -16,31 +46,164 @@ void pvm::generateExecutable(ByteCode byteCode, const char* name)
         errors::FileWriteError(name);
     }
 
-    // first 8 bytes are the executable size
-    file.write((const char*) &byteCode.size, sizeof(size_t));
+    ExecutableHeader header = {};
+    memcpy(header.magic, PFX_MAGIC, PFX_MAGIC_SIZE);
+    header.version = PFX_VERSION;
+    header.sectionCount = SECTION_COUNT;
+
+    // the compiler doesn't emit constants yet, so that section is empty
+    const ByteCode sections[SECTION_COUNT] = { byteCode, ByteCode(), lineTable };
+
+    // sections are laid out one after the other, each one aligned
+    uint64_t offset = alignSection(sizeof(ExecutableHeader));
+
+    for (unsigned int i = 0; i < SECTION_COUNT; i++)
+    {
+        header.sections[i] = { offset, sections[i].size };
+
+        offset = alignSection(offset + sections[i].size);
+    }
 
-    file.write((const char*) byteCode.byteCode, byteCode.size);
+    header.checksum = headerChecksum(header);
+
+    // padding after the header and after every section
+    // the file always ends at an aligned offset, so even empty sections lie within it
+    const char padding[PFX_SECTION_ALIGNMENT] = {};
+
+    file.write((const char*) &header, sizeof(ExecutableHeader));
+    offset = sizeof(ExecutableHeader);
+
+    for (unsigned int i = 0; i < SECTION_COUNT; i++)
+    {
+        file.write(padding, (std::streamsize) (header.sections[i].offset - offset));
+        file.write((const char*) sections[i].byteCode, (std::streamsize) sections[i].size);
+
+        offset = header.sections[i].offset + sections[i].size;
+    }
+
+    file.write(padding, (std::streamsize) (alignSection(offset) - offset));
 
     file.close();
+
+    if (file.fail())
+    {
+        errors::FileWriteError(name);
+    }
 }
 
 
-ByteCode pvm::loadByteCode(const char* executable)
+Executable::Executable(const char* name)
+: mapping(nullptr), mappingSize(0), header(nullptr)
 {
-    std::ifstream file(executable, std::ios::binary);
+    const int descriptor = open(name, O_RDONLY);
 
-    if (!file.is_open())
+    if (descriptor == -1)
+    {
+        errors::FileReadError(name);
+    }
+
+    struct stat status;
+
+    if (fstat(descriptor, &status) != 0)
+    {
+        close(descriptor);
+        errors::FileReadError(name);
+    }
+
+    mappingSize = (size_t) status.st_size;
+
+    if (mappingSize < sizeof(ExecutableHeader))
     {
-        errors::FileReadError(executable);
+        close(descriptor);
+        errors::InvalidExecutableError(name, "file is too small to hold the header");
     }
 
-    // read the first 8 bytes of the file to get the size
-    size_t size;
-    file.read((char*) &size, sizeof(size_t));
+    // pages are read from the file only when they are first accessed
+    mapping = (Byte*) mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
 
-    Byte* bytes = new Byte[size];
-    file.read((char*) bytes, size);
+    // the mapping keeps the file open by itself
+    close(descriptor);
+
+    if (mapping == MAP_FAILED)
+    {
+        errors::FileReadError(name);
+    }
+
+    header = (const ExecutableHeader*) mapping;
+
+    // the destructor doesn't run when the constructor fails, so the mapping
+    // is released before the error is reported, in case it doesn't end the process
+    const auto reject = [this, name](const std::string& message) {
+        munmap(mapping, mappingSize);
+        errors::InvalidExecutableError(name, message);
+    };
+
+    if (memcmp(header->magic, PFX_MAGIC, PFX_MAGIC_SIZE) != 0)
+    {
+        reject("not a Permalang executable");
+    }
+
+    if (header->version != PFX_VERSION)
+    {
+        reject("unsupported version " + std::to_string(header->version) + ", expected " + std::to_string(PFX_VERSION));
+    }
+
+    if (header->checksum != headerChecksum(*header))
+    {
+        reject("corrupted header");
+    }
+
+    if (header->sectionCount != SECTION_COUNT)
+    {
+        reject("unexpected number of sections");
+    }
+
+    for (const SectionEntry& section : header->sections)
+    {
+        if (section.offset % PFX_SECTION_ALIGNMENT != 0)
+        {
+            reject("misaligned section");
+        }
+
+        // written so that huge sizes can't overflow
+        if (section.offset > mappingSize || section.size > mappingSize - section.offset)
+        {
+            reject("truncated file");
+        }
+    }
+
+    if (header->sections[(unsigned char) Section::DEBUG].size % sizeof(LineEntry) != 0)
+    {
+        reject("malformed line table");
+    }
+}
+
+
+Executable::~Executable()
+{
+    munmap(mapping, mappingSize);
+}
+
+
+ByteCode Executable::getSection(Section section) const
+{
+    const SectionEntry& entry = header->sections[(unsigned char) section];
+
+    return ByteCode(mapping + entry.offset, entry.size);
+}
+
+
+ByteCode Executable::getByteCode() const
+{
+    return getSection(Section::CODE);
+}
+
+
+LineTable Executable::getLineTable() const
+{
+    const ByteCode section = getSection(Section::DEBUG);
 
-    return ByteCode(bytes, size);
+    // sections are aligned, so the entries can be read in place
+    return LineTable((const LineEntry*) section.byteCode, section.size / sizeof(LineEntry));
 }
 
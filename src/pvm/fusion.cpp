@@ -0,0 +1,415 @@
+#include "pvm.hh"
+
+
+using namespace pvm;
+
+
+static inline long getLong(const Byte* bytes)
+{
+    return *((long*) bytes);
+}
+
+
+static inline int getInt(const Byte* bytes)
+{
+    return *((int*) bytes);
+}
+
+
+// data size of LD_A_* instructions, 0 if not fusable
+static size_t loadASize(OpCode opCode)
+{
+    switch (opCode)
+    {
+    case OpCode::LD_A_8:
+        return 8;
+    case OpCode::LD_A_4:
+        return 4;
+    }
+
+    return 0;
+}
+
+
+// data size of LD_B_* instructions, 0 if not fusable
+static size_t loadBSize(OpCode opCode)
+{
+    switch (opCode)
+    {
+    case OpCode::LD_B_8:
+        return 8;
+    case OpCode::LD_B_4:
+        return 4;
+    }
+
+    return 0;
+}
+
+
+// data size of REG_MOV_* instructions, 0 if not fusable
+static size_t regMovSize(OpCode opCode)
+{
+    switch (opCode)
+    {
+    case OpCode::REG_MOV_8:
+        return 8;
+    case OpCode::REG_MOV_4:
+        return 4;
+    }
+
+    return 0;
+}
+
+
+// loads the constant of a LD_CONST_B_* instruction the way the Pvm would
+// returns false if the instruction isn't a constant load into B
+static bool constantOfLoadB(const ListInstruction& instruction, long& constant)
+{
+    const Byte* operands = instruction.operands();
+
+    switch (instruction.opCode())
+    {
+    case OpCode::LD_CONST_B_8:
+        constant = getLong(operands);
+        return true;
+
+    case OpCode::LD_CONST_B_4:
+        constant = getInt(operands);
+        return true;
+
+    case OpCode::LD_CONST_B_1:
+        constant = operands[0];
+        return true;
+
+    case OpCode::LD_CONST_B_BIT:
+        constant = (bool) operands[0];
+        return true;
+    }
+
+    return false;
+}
+
+
+// lookup tables for fused OpCodes, indexed by [data size is 8][constant operand]
+
+static const OpCode fusedAdd[2][2] =
+{
+    { OpCode::ADD_MEM_4, OpCode::ADD_MEM_CONST_4 },
+    { OpCode::ADD_MEM_8, OpCode::ADD_MEM_CONST_8 },
+};
+
+static const OpCode fusedSub[2][2] =
+{
+    { OpCode::SUB_MEM_4, OpCode::SUB_MEM_CONST_4 },
+    { OpCode::SUB_MEM_8, OpCode::SUB_MEM_CONST_8 },
+};
+
+static const OpCode fusedMul[2][2] =
+{
+    { OpCode::MUL_MEM_4, OpCode::MUL_MEM_CONST_4 },
+    { OpCode::MUL_MEM_8, OpCode::MUL_MEM_CONST_8 },
+};
+
+static const OpCode fusedCmp[2][2] =
+{
+    { OpCode::CMP_MEM_4, OpCode::CMP_MEM_CONST_4 },
+    { OpCode::CMP_MEM_8, OpCode::CMP_MEM_CONST_8 },
+};
+
+static const OpCode fusedCmpReverse[2][2] =
+{
+    { OpCode::CMP_REVERSE_MEM_4, OpCode::CMP_REVERSE_MEM_CONST_4 },
+    { OpCode::CMP_REVERSE_MEM_8, OpCode::CMP_REVERSE_MEM_CONST_8 },
+};
+
+
+// returns the fused lookup table of an operation, nullptr if it can't be fused
+static const OpCode (*fusedTableOf(OpCode opCode))[2]
+{
+    switch (opCode)
+    {
+    case OpCode::ADD:
+        return fusedAdd;
+    case OpCode::SUB:
+        return fusedSub;
+    case OpCode::MUL:
+        return fusedMul;
+    case OpCode::CMP:
+        return fusedCmp;
+    case OpCode::CMP_REVERSE:
+        return fusedCmpReverse;
+    }
+
+    return nullptr;
+}
+
+
+// data size of the register to register copies a fused result can be stored with
+// 0 if not fusable
+static size_t regToRegSize(OpCode opCode)
+{
+    switch (opCode)
+    {
+    case OpCode::REG_TO_REG:
+        return 8;
+    case OpCode::REG_TO_REG_4:
+        return 4;
+    }
+
+    return 0;
+}
+
+
+// whether the instruction is a register to register copy into the given register
+static inline bool isCopyInto(const ListInstruction& instruction, Registers reg)
+{
+    return instruction.opCode() == OpCode::REG_TO_REG && (Registers) instruction.operands()[0] == reg;
+}
+
+
+// lookup tables for fused register OpCodes, indexed by [data size is 8][constant operand]
+
+static const OpCode fusedAddReg[2][2] =
+{
+    { OpCode::ADD_REG_4, OpCode::ADD_REG_CONST_4 },
+    { OpCode::ADD_REG_8, OpCode::ADD_REG_CONST_8 },
+};
+
+static const OpCode fusedSubReg[2][2] =
+{
+    { OpCode::SUB_REG_4, OpCode::SUB_REG_CONST_4 },
+    { OpCode::SUB_REG_8, OpCode::SUB_REG_CONST_8 },
+};
+
+static const OpCode fusedMulReg[2][2] =
+{
+    { OpCode::MUL_REG_4, OpCode::MUL_REG_CONST_4 },
+    { OpCode::MUL_REG_8, OpCode::MUL_REG_CONST_8 },
+};
+
+
+// fused register comparisons, indexed by [constant operand]
+static const OpCode fusedCmpReg[2] = { OpCode::CMP_REG, OpCode::CMP_REG_CONST };
+static const OpCode fusedCmpReverseReg[2] = { OpCode::CMP_REVERSE_REG, OpCode::CMP_REVERSE_REG_CONST };
+
+
+/*
+    tries to fuse register instructions, like fuse() does for memory ones
+    first is a copy into A, the window has at least 3 instructions
+
+    fused patterns:
+    - REG_TO_REG A x, REG_TO_REG B y | LD_CONST_B c, ADD | SUB | MUL, REG_TO_REG_n dst RESULT
+    - REG_TO_REG A x, REG_TO_REG B y | LD_CONST_B c, CMP | CMP_REVERSE
+    - REG_TO_REG A x, LD_CONST_B_BIT 0, CMP, IF_JUMP target
+*/
+static size_t fuseRegisters(const std::vector<ListInstruction>& instructions, size_t i, size_t window, ByteList& output)
+{
+    const ListInstruction& first = instructions[i];
+    const ListInstruction& second = instructions[i + 1];
+    const ListInstruction& third = instructions[i + 2];
+
+    const Registers x = (Registers) first.operands()[1];
+
+    // branch on a bit in a register
+    if (window == 4
+        && second.opCode() == OpCode::LD_CONST_B_BIT && second.operands()[0] == 0
+        && third.opCode() == OpCode::CMP
+        && instructions[i + 3].opCode() == OpCode::IF_JUMP)
+    {
+        output.add(OpCode::IF_NOT_REG_JUMP);
+        output.add(x);
+        output.addJumpTarget(getLong(instructions[i + 3].operands()));
+        return 4;
+    }
+
+    long constant = 0;
+    const bool isConstant = constantOfLoadB(second, constant);
+
+    if (!isConstant && !isCopyInto(second, Registers::GENERAL_B))
+    {
+        return 0;
+    }
+
+    const OpCode* comparison = nullptr;
+    const OpCode (*table)[2] = nullptr;
+
+    switch (third.opCode())
+    {
+    case OpCode::CMP:
+        comparison = fusedCmpReg;
+        break;
+    case OpCode::CMP_REVERSE:
+        comparison = fusedCmpReverseReg;
+        break;
+    case OpCode::ADD:
+        table = fusedAddReg;
+        break;
+    case OpCode::SUB:
+        table = fusedSubReg;
+        break;
+    case OpCode::MUL:
+        table = fusedMulReg;
+        break;
+    default:
+        return 0;
+    }
+
+    if (comparison != nullptr)
+    {
+        output.add(comparison[isConstant]);
+        output.add(x);
+    }
+    else
+    {
+        const ListInstruction* store = window == 4 ? &instructions[i + 3] : nullptr;
+        const size_t size = store == nullptr ? 0 : regToRegSize(store->opCode());
+
+        if (size == 0 || (Registers) store->operands()[1] != Registers::RESULT)
+        {
+            return 0;
+        }
+
+        output.add(table[size == 8][isConstant]);
+        output.add((Registers) store->operands()[0]);
+        output.add(x);
+    }
+
+    // register constants are always 8 bytes, the value is already converted
+    if (isConstant)
+    {
+        output.add((Value) constant, sizeof(long));
+    }
+    else
+    {
+        output.add((Registers) second.operands()[1]);
+    }
+
+    return comparison != nullptr ? 3 : 4;
+}
+
+
+/*
+    tries to fuse the instructions beginning at index i
+    on success the fused instruction is emitted to output and the number of
+    replaced instructions is returned, otherwise 0 is returned
+
+    fused patterns:
+    - LD_A_n a, LD_B_n b | LD_CONST_B c, ADD | SUB | MUL, REG_MOV_n dst RESULT
+    - LD_A_n a, LD_B_n b | LD_CONST_B c, CMP | CMP_REVERSE
+    - LD_A_BIT a, LD_CONST_B_BIT 0, CMP, IF_JUMP target
+    - the same patterns on registers, see fuseRegisters()
+*/
+static size_t fuse(const std::vector<ListInstruction>& instructions, size_t i, ByteList& output)
+{
+    // instructions after the first one can't be jumped to, or the jump would
+    // land in the middle of the fused instruction
+    const size_t available = instructions.size() - i;
+    size_t window = 1;
+    while (window < 4 && window < available && !instructions[i + window].isJumpTarget)
+    {
+        window ++;
+    }
+
+    if (window < 3)
+    {
+        return 0;
+    }
+
+    const ListInstruction& first = instructions[i];
+    const ListInstruction& second = instructions[i + 1];
+    const ListInstruction& third = instructions[i + 2];
+
+    if (isCopyInto(first, Registers::GENERAL_A))
+    {
+        return fuseRegisters(instructions, i, window, output);
+    }
+
+    // branch on a bit in memory
+    if (window == 4
+        && first.opCode() == OpCode::LD_A_BIT
+        && second.opCode() == OpCode::LD_CONST_B_BIT && second.operands()[0] == 0
+        && third.opCode() == OpCode::CMP
+        && instructions[i + 3].opCode() == OpCode::IF_JUMP)
+    {
+        output.add(OpCode::IF_NOT_MEM_JUMP);
+        output.add(getLong(first.operands()), 8);
+        output.addJumpTarget(getLong(instructions[i + 3].operands()));
+        return 4;
+    }
+
+    // arithmetic and comparisons on memory operands
+    const size_t size = loadASize(first.opCode());
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    long constant = 0;
+    const bool isConstant = constantOfLoadB(second, constant);
+
+    if (!isConstant && loadBSize(second.opCode()) != size)
+    {
+        return 0;
+    }
+
+    // 4 bytes instructions store their constant in 4 bytes
+    if (isConstant && size == 4 && constant != (int) constant)
+    {
+        return 0;
+    }
+
+    const OpCode (*table)[2] = fusedTableOf(third.opCode());
+    if (table == nullptr)
+    {
+        return 0;
+    }
+
+    const OpCode opCode = table[size == 8][isConstant];
+
+    const bool isComparison = third.opCode() == OpCode::CMP || third.opCode() == OpCode::CMP_REVERSE;
+
+    if (isComparison)
+    {
+        output.add(opCode);
+        output.add(getLong(first.operands()), 8);
+    }
+    else
+    {
+        const ListInstruction* store = window == 4 ? &instructions[i + 3] : nullptr;
+
+        if (store == nullptr
+            || regMovSize(store->opCode()) != size
+            || (Registers) store->operands()[sizeof(long)] != Registers::RESULT)
+        {
+            return 0;
+        }
+
+        output.add(opCode);
+        output.add(getLong(store->operands()), 8);
+        output.add(getLong(first.operands()), 8);
+    }
+
+    if (isConstant)
+    {
+        output.add((Value) constant, (InstructionSize) size);
+    }
+    else
+    {
+        output.add(getLong(second.operands()), 8);
+    }
+
+    return isComparison ? 3 : 4;
+}
+
+
+void ByteList::fuseInstructions()
+{
+    std::vector<ListInstruction> instructions;
+
+    if (!splitInstructions(instructions))
+    {
+        return;
+    }
+
+    rewrite(instructions, fuse);
+}
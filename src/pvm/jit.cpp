@@ -0,0 +1,1082 @@
+#include "jit.hh"
+#include "errors.hh"
+
+#include <sys/mman.h>
+#include <stddef.h>
+#include <limits.h>
+
+
+using namespace jit;
+using pvm::Byte;
+using pvm::Instruction;
+using pvm::OpCode;
+
+
+#if PVM_JIT
+
+
+// x86-64 general purpose registers, in encoding order
+typedef enum Host
+{
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15,
+
+    // not a register, marks Pvm registers that live in the stack frame
+    IN_FRAME,
+
+} Host;
+
+
+// x86-64 condition codes, as encoded in Jcc and SETcc
+typedef enum Condition
+{
+    EQUAL = 0x4,
+    NOT_EQUAL = 0x5,
+    ABOVE = 0x7,
+    SIGN = 0x8,
+
+} Condition;
+
+
+// register holding the address of the Pvm memory
+#define MEMORY_BASE R15
+
+// host registers the Pvm registers are pinned to, indexed by pvm::Registers
+// they are all callee saved, so they survive calls to C++ helpers
+static const Host pinned[REGISTER_COUNT] =
+{
+    RBX,        // GENERAL_A
+    R12,        // GENERAL_B
+    IN_FRAME,   // DIVISION_REMAINDER, rarely used
+    R13,        // RESULT
+    R14,        // ZERO_FLAG
+    RBP,        // SIGN_FLAG
+    // R0 to R15, there are no host registers left for them
+    IN_FRAME, IN_FRAME, IN_FRAME, IN_FRAME, IN_FRAME, IN_FRAME, IN_FRAME, IN_FRAME,
+    IN_FRAME, IN_FRAME, IN_FRAME, IN_FRAME, IN_FRAME, IN_FRAME, IN_FRAME, IN_FRAME,
+};
+
+#define A_REGISTER pinned[(unsigned char) pvm::Registers::GENERAL_A]
+#define B_REGISTER pinned[(unsigned char) pvm::Registers::GENERAL_B]
+#define RESULT_REGISTER pinned[(unsigned char) pvm::Registers::RESULT]
+#define ZERO_FLAG_REGISTER pinned[(unsigned char) pvm::Registers::ZERO_FLAG]
+#define SIGN_FLAG_REGISTER pinned[(unsigned char) pvm::Registers::SIGN_FLAG]
+
+/*
+    Stack frame of the native code, after the callee saved registers:
+    [rsp + 0]   the Context pointer
+    [rsp + 8]   the DIVISION_REMAINDER register
+    [rsp + 16]  the general purpose registers R0 to R15
+    [rsp + 144] padding, keeps rsp 16 bytes aligned for calls
+*/
+#define FRAME_SIZE 152
+#define CONTEXT_SLOT 0
+#define REMAINDER_SLOT 8
+#define GENERAL_SLOT(reg) (16 + ((reg) - (int) pvm::Registers::R0) * 8)
+
+// callee saved registers, pushed in this order by the prologue
+static const Host calleeSaved[] = { RBX, RBP, R12, R13, R14, R15 };
+
+
+// called by PRINT, same output as the interpreter
+static void printLong(long value)
+{
+    std::cout << value;
+}
+
+
+// emits x86-64 machine code into a byte buffer
+// every memory operand is encoded with a 32 bit displacement
+class Assembler
+{
+private:
+
+    std::vector<Byte> code;
+
+    void rex(bool wide, int reg, int base)
+    {
+        code.push_back((Byte) (0x40 | wide << 3 | (reg >> 3) << 2 | (base >> 3)));
+    }
+
+    void modRegister(int reg, int rm)
+    {
+        code.push_back((Byte) (0xC0 | (reg & 7) << 3 | (rm & 7)));
+    }
+
+    void modMemory(int reg, Host base, int displacement)
+    {
+        code.push_back((Byte) (0x80 | (reg & 7) << 3 | (base & 7)));
+
+        // rsp and r12 as a base need a SIB byte
+        if ((base & 7) == RSP)
+        {
+            code.push_back(0x24);
+        }
+
+        add32(displacement);
+    }
+
+public:
+
+    size_t size() const
+    {
+        return code.size();
+    }
+
+    const std::vector<Byte>& bytes() const
+    {
+        return code;
+    }
+
+    void add8(Byte value)
+    {
+        code.push_back(value);
+    }
+
+    void add32(int value)
+    {
+        const Byte* bytes = (const Byte*) &value;
+        code.insert(code.end(), bytes, bytes + sizeof(int));
+    }
+
+    void add64(long value)
+    {
+        const Byte* bytes = (const Byte*) &value;
+        code.insert(code.end(), bytes, bytes + sizeof(long));
+    }
+
+    // overwrites a previously emitted 32 bit value
+    void patch32(size_t offset, int value)
+    {
+        memcpy(code.data() + offset, &value, sizeof(int));
+    }
+
+
+    void push(Host reg)
+    {
+        rex(false, 0, reg);
+        add8((Byte) (0x50 + (reg & 7)));
+    }
+
+    void pop(Host reg)
+    {
+        rex(false, 0, reg);
+        add8((Byte) (0x58 + (reg & 7)));
+    }
+
+    // mov dst, src
+    void mov(Host dst, Host src)
+    {
+        rex(true, src, dst);
+        add8(0x89);
+        modRegister(src, dst);
+    }
+
+    // mov dst, value
+    void movConstant(Host dst, long value)
+    {
+        if (value >= INT_MIN && value <= INT_MAX)
+        {
+            // sign extended 32 bit immediate
+            rex(true, 0, dst);
+            add8(0xC7);
+            modRegister(0, dst);
+            add32((int) value);
+        }
+        else
+        {
+            rex(true, 0, dst);
+            add8((Byte) (0xB8 + (dst & 7)));
+            add64(value);
+        }
+    }
+
+    // loads 8 bytes, 4 sign extended bytes or 1 zero extended byte
+    void load(Host dst, Host base, int displacement, size_t width)
+    {
+        rex(true, dst, base);
+
+        switch (width)
+        {
+        case sizeof(long):
+            add8(0x8B);
+            break;
+        case sizeof(int):
+            add8(0x63);
+            break;
+        default:
+            add8(0x0F);
+            add8(0xB6);
+            break;
+        }
+
+        modMemory(dst, base, displacement);
+    }
+
+    // stores the lowest width bytes of src
+    void store(Host src, Host base, int displacement, size_t width)
+    {
+        rex(width == sizeof(long), src, base);
+        add8(width == 1 ? 0x88 : 0x89);
+        modMemory(src, base, displacement);
+    }
+
+    // add, sub, cmp, test and xor, with dst as the r/m operand
+    void arithmetic(Byte opCode, Host dst, Host src)
+    {
+        rex(true, src, dst);
+        add8(opCode);
+        modRegister(src, dst);
+    }
+
+    void add(Host dst, Host src) { arithmetic(0x01, dst, src); }
+    void sub(Host dst, Host src) { arithmetic(0x29, dst, src); }
+    void cmp(Host dst, Host src) { arithmetic(0x39, dst, src); }
+    void test(Host dst, Host src) { arithmetic(0x85, dst, src); }
+    void xorSelf(Host reg) { arithmetic(0x31, reg, reg); }
+
+    // imul dst, src
+    void imul(Host dst, Host src)
+    {
+        rex(true, dst, src);
+        add8(0x0F);
+        add8(0xAF);
+        modRegister(dst, src);
+    }
+
+    // rdx:rax = sign extended rax
+    void cqo()
+    {
+        add8(0x48);
+        add8(0x99);
+    }
+
+    // rax = rdx:rax / divisor, rdx = rdx:rax % divisor
+    void idiv(Host divisor)
+    {
+        rex(true, 0, divisor);
+        add8(0xF7);
+        modRegister(7, divisor);
+    }
+
+    // cmp dst, [base + displacement]
+    void cmpMemory(Host dst, Host base, int displacement)
+    {
+        rex(true, dst, base);
+        add8(0x3B);
+        modMemory(dst, base, displacement);
+    }
+
+    // dst = condition ? 1 : 0, flags are left untouched
+    void setFlag(Condition condition, Host dst)
+    {
+        // setcc al
+        rex(false, 0, RAX);
+        add8(0x0F);
+        add8((Byte) (0x90 + condition));
+        modRegister(0, RAX);
+
+        // movzx dst, al
+        rex(true, dst, RAX);
+        add8(0x0F);
+        add8(0xB6);
+        modRegister(dst, RAX);
+    }
+
+    // movsxd dst, src
+    void signExtendInt(Host dst, Host src)
+    {
+        rex(true, dst, src);
+        add8(0x63);
+        modRegister(dst, src);
+    }
+
+    // movzx dst, src8
+    void zeroExtendByte(Host dst, Host src)
+    {
+        rex(true, dst, src);
+        add8(0x0F);
+        add8(0xB6);
+        modRegister(dst, src);
+    }
+
+    // sub rsp, value or add rsp, value
+    void adjustStack(int value)
+    {
+        rex(true, 0, RSP);
+        add8(0x81);
+        modRegister(value < 0 ? 5 : 0, RSP);
+        add32(value < 0 ? -value : value);
+    }
+
+    // emits a jump with a placeholder target
+    // returns the offset of the 32 bit relative target to patch
+    size_t jump()
+    {
+        add8(0xE9);
+        add32(0);
+        return size() - sizeof(int);
+    }
+
+    size_t jumpIf(Condition condition)
+    {
+        add8(0x0F);
+        add8((Byte) (0x80 + condition));
+        add32(0);
+        return size() - sizeof(int);
+    }
+
+    // calls the function at the given address, clobbers rax
+    void call(const void* function)
+    {
+        movConstant(RAX, (long) function);
+        // call rax
+        add8(0xFF);
+        add8(0xD0);
+    }
+
+    void ret()
+    {
+        add8(0xC3);
+    }
+
+    void ud2()
+    {
+        add8(0x0F);
+        add8(0x0B);
+    }
+
+};
+
+
+// a relative jump target waiting for its destination to be emitted
+typedef struct Fixup
+{
+    // offset of the 32 bit target in the code
+    size_t operand;
+    // instruction index, or a stub if it's past the program
+    size_t target;
+
+} Fixup;
+
+
+#define CONTEXT_OFFSET(field) ((int) offsetof(Context, field))
+#define REGISTER_OFFSET(reg) ((int) (offsetof(Context, registers) + (reg) * sizeof(long)))
+
+
+// stack frame slot of a Pvm register that isn't pinned
+static inline int frameSlot(unsigned char reg)
+{
+    return reg == (unsigned char) pvm::Registers::DIVISION_REMAINDER ? REMAINDER_SLOT : GENERAL_SLOT(reg);
+}
+
+
+// copies a Pvm register into a host register
+static void loadRegister(Assembler& as, Host dst, unsigned char reg)
+{
+    if (pinned[reg] == IN_FRAME)
+    {
+        as.load(dst, RSP, frameSlot(reg), sizeof(long));
+    }
+    else
+    {
+        as.mov(dst, pinned[reg]);
+    }
+}
+
+
+// copies a host register into a Pvm register
+static void storeRegister(Assembler& as, unsigned char reg, Host src)
+{
+    if (pinned[reg] == IN_FRAME)
+    {
+        as.store(src, RSP, frameSlot(reg), sizeof(long));
+    }
+    else
+    {
+        as.mov(pinned[reg], src);
+    }
+}
+
+
+// sets the error the run ends with, clobbers rax and rcx
+static void setError(Assembler& as, Error error)
+{
+    as.load(RCX, RSP, CONTEXT_SLOT, sizeof(long));
+    as.movConstant(RAX, (long) error);
+    as.store(RAX, RCX, CONTEXT_OFFSET(error), sizeof(long));
+}
+
+
+// sets the sign and zero flags from the RESULT register, like the interpreter
+static void setResultFlags(Assembler& as)
+{
+    as.test(RESULT_REGISTER, RESULT_REGISTER);
+    as.setFlag(SIGN, SIGN_FLAG_REGISTER);
+    as.setFlag(EQUAL, ZERO_FLAG_REGISTER);
+}
+
+
+// moves the stack pointer by the given amount and checks it's within the memory
+static void moveStackPointer(Assembler& as, long amount, std::vector<Fixup>& fixups, size_t overflowStub)
+{
+    as.load(RCX, RSP, CONTEXT_SLOT, sizeof(long));
+    as.load(RAX, RCX, CONTEXT_OFFSET(stackPointer), sizeof(long));
+    as.movConstant(RDX, amount);
+    as.add(RAX, RDX);
+    as.store(RAX, RCX, CONTEXT_OFFSET(stackPointer), sizeof(long));
+
+    // a negative stack pointer is above any memory size as well
+    as.cmpMemory(RAX, RCX, CONTEXT_OFFSET(memorySize));
+    fixups.push_back({ as.jumpIf(ABOVE), overflowStub });
+}
+
+
+// pushes the value of a host register on the Pvm stack, clobbers rax and rcx
+static void pushValue(Assembler& as, Host value)
+{
+    as.load(RCX, RSP, CONTEXT_SLOT, sizeof(long));
+    as.load(RAX, RCX, CONTEXT_OFFSET(stackPointer), sizeof(long));
+    as.add(RAX, MEMORY_BASE);
+    // single pushes are caught by the guard pages, like in the interpreter
+    as.store(value, RAX, 0, sizeof(long));
+
+    as.movConstant(RAX, sizeof(long));
+    as.load(RDX, RCX, CONTEXT_OFFSET(stackPointer), sizeof(long));
+    as.add(RDX, RAX);
+    as.store(RDX, RCX, CONTEXT_OFFSET(stackPointer), sizeof(long));
+}
+
+
+// size in bytes of the memory operands of a sized OpCode
+static size_t operandWidth(OpCode opCode)
+{
+    switch (opCode)
+    {
+    case OpCode::LD_A_8:
+    case OpCode::LD_B_8:
+    case OpCode::LD_RESULT_8:
+    case OpCode::MEM_MOV_8:
+    case OpCode::REG_MOV_8:
+    case OpCode::MEM_SET_8:
+    case OpCode::ADD_MEM_8:
+    case OpCode::ADD_MEM_CONST_8:
+    case OpCode::SUB_MEM_8:
+    case OpCode::SUB_MEM_CONST_8:
+    case OpCode::MUL_MEM_8:
+    case OpCode::MUL_MEM_CONST_8:
+    case OpCode::CMP_MEM_8:
+    case OpCode::CMP_MEM_CONST_8:
+    case OpCode::CMP_REVERSE_MEM_8:
+    case OpCode::CMP_REVERSE_MEM_CONST_8:
+    case OpCode::LD_REG_8:
+        return sizeof(long);
+
+    case OpCode::LD_A_4:
+    case OpCode::LD_B_4:
+    case OpCode::LD_RESULT_4:
+    case OpCode::MEM_MOV_4:
+    case OpCode::REG_MOV_4:
+    case OpCode::MEM_SET_4:
+    case OpCode::ADD_MEM_4:
+    case OpCode::ADD_MEM_CONST_4:
+    case OpCode::SUB_MEM_4:
+    case OpCode::SUB_MEM_CONST_4:
+    case OpCode::MUL_MEM_4:
+    case OpCode::MUL_MEM_CONST_4:
+    case OpCode::CMP_MEM_4:
+    case OpCode::CMP_MEM_CONST_4:
+    case OpCode::CMP_REVERSE_MEM_4:
+    case OpCode::CMP_REVERSE_MEM_CONST_4:
+    case OpCode::LD_REG_4:
+        return sizeof(int);
+
+    default:
+        return sizeof(Byte);
+    }
+}
+
+
+// whether a memory address fits in a 32 bit displacement
+static inline bool isDisplacement(long address)
+{
+    return address >= 0 && address <= INT_MAX;
+}
+
+
+// emits the template of a single instruction
+// returns false if the instruction can't be translated
+static bool translate(Assembler& as, const Instruction& instruction, std::vector<Fixup>& fixups,
+    size_t epilogue, size_t overflowStub, size_t zeroDivisionStub, size_t divisionOverflowStub)
+{
+    const OpCode opCode = instruction.opCode;
+    const size_t width = operandWidth(opCode);
+
+    // memory operands are only ever read from these fields
+    const int first = (int) instruction.first;
+    const int second = (int) instruction.second;
+    const int third = (int) instruction.third;
+
+    switch (opCode)
+    {
+    case OpCode::EXIT:
+        as.movConstant(RAX, (Byte) instruction.first);
+        fixups.push_back({ as.jump(), epilogue });
+        return true;
+
+    case OpCode::ADD:
+    case OpCode::SUB:
+    case OpCode::MUL:
+        as.mov(RESULT_REGISTER, A_REGISTER);
+        if (opCode == OpCode::ADD) as.add(RESULT_REGISTER, B_REGISTER);
+        else if (opCode == OpCode::SUB) as.sub(RESULT_REGISTER, B_REGISTER);
+        else as.imul(RESULT_REGISTER, B_REGISTER);
+        setResultFlags(as);
+        return true;
+
+    case OpCode::DIV:
+    {
+        // both would raise SIGFPE, they end the run with an error instead
+        as.test(B_REGISTER, B_REGISTER);
+        fixups.push_back({ as.jumpIf(EQUAL), zeroDivisionStub });
+
+        as.movConstant(RAX, -1);
+        as.cmp(B_REGISTER, RAX);
+        const size_t isDivisible = as.jumpIf(NOT_EQUAL);
+        as.movConstant(RAX, LONG_MIN);
+        as.cmp(A_REGISTER, RAX);
+        fixups.push_back({ as.jumpIf(EQUAL), divisionOverflowStub });
+        as.patch32(isDivisible, (int) (as.size() - (isDivisible + sizeof(int))));
+
+        as.mov(RAX, A_REGISTER);
+        as.cqo();
+        as.idiv(B_REGISTER);
+        as.mov(RESULT_REGISTER, RAX);
+        // the remainder is computed from the result, like the interpreter does
+        as.cqo();
+        as.idiv(B_REGISTER);
+        as.store(RDX, RSP, REMAINDER_SLOT, sizeof(long));
+        as.test(RESULT_REGISTER, RESULT_REGISTER);
+        as.setFlag(EQUAL, ZERO_FLAG_REGISTER);
+        return true;
+    }
+
+    case OpCode::CMP:
+    case OpCode::CMP_REVERSE:
+        as.cmp(A_REGISTER, B_REGISTER);
+        as.setFlag(opCode == OpCode::CMP ? EQUAL : NOT_EQUAL, ZERO_FLAG_REGISTER);
+        return true;
+
+    case OpCode::LD_CONST_A_8:
+    case OpCode::LD_CONST_A_4:
+    case OpCode::LD_CONST_A_1:
+    case OpCode::LD_CONST_A_BIT:
+        as.movConstant(A_REGISTER, instruction.first);
+        return true;
+
+    case OpCode::LD_CONST_B_8:
+    case OpCode::LD_CONST_B_4:
+    case OpCode::LD_CONST_B_1:
+    case OpCode::LD_CONST_B_BIT:
+        as.movConstant(B_REGISTER, instruction.first);
+        return true;
+
+    case OpCode::LD_CONST_RESULT_8:
+    case OpCode::LD_CONST_RESULT_4:
+    case OpCode::LD_CONST_RESULT_1:
+    case OpCode::LD_CONST_RESULT_BIT:
+        as.movConstant(RESULT_REGISTER, instruction.first);
+        return true;
+
+    case OpCode::LD_A_8:
+    case OpCode::LD_A_4:
+    case OpCode::LD_A_1:
+    case OpCode::LD_A_BIT:
+        if (!isDisplacement(instruction.first)) return false;
+        as.load(A_REGISTER, MEMORY_BASE, first, width);
+        return true;
+
+    case OpCode::LD_B_8:
+    case OpCode::LD_B_4:
+    case OpCode::LD_B_1:
+    case OpCode::LD_B_BIT:
+        if (!isDisplacement(instruction.first)) return false;
+        as.load(B_REGISTER, MEMORY_BASE, first, width);
+        return true;
+
+    case OpCode::LD_RESULT_8:
+    case OpCode::LD_RESULT_4:
+    case OpCode::LD_RESULT_1:
+    case OpCode::LD_RESULT_BIT:
+        if (!isDisplacement(instruction.first)) return false;
+        as.load(RESULT_REGISTER, MEMORY_BASE, first, width);
+        return true;
+
+    case OpCode::LD_ZERO_FLAG:
+        if (!isDisplacement(instruction.first)) return false;
+        as.load(ZERO_FLAG_REGISTER, MEMORY_BASE, first, width);
+        return true;
+
+    case OpCode::MEM_MOV_8:
+    case OpCode::MEM_MOV_4:
+    case OpCode::MEM_MOV_1:
+    case OpCode::MEM_MOV_BIT:
+        if (!isDisplacement(instruction.first) || !isDisplacement(instruction.second)) return false;
+        as.load(RAX, MEMORY_BASE, second, width);
+        as.store(RAX, MEMORY_BASE, first, width);
+        return true;
+
+    case OpCode::REG_MOV_8:
+    case OpCode::REG_MOV_4:
+    case OpCode::REG_MOV_1:
+        if (!isDisplacement(instruction.first)) return false;
+        loadRegister(as, RAX, instruction.reg);
+        as.store(RAX, MEMORY_BASE, first, width);
+        return true;
+
+    case OpCode::REG_MOV_BIT:
+        if (!isDisplacement(instruction.first)) return false;
+        loadRegister(as, RDX, instruction.reg);
+        as.test(RDX, RDX);
+        as.setFlag(NOT_EQUAL, RAX);
+        as.store(RAX, MEMORY_BASE, first, width);
+        return true;
+
+    case OpCode::REG_TO_REG:
+        loadRegister(as, RAX, instruction.reg2);
+        storeRegister(as, instruction.reg, RAX);
+        return true;
+
+    case OpCode::MEM_SET_8:
+    case OpCode::MEM_SET_4:
+    case OpCode::MEM_SET_1:
+    case OpCode::MEM_SET_BIT:
+        if (!isDisplacement(instruction.first)) return false;
+        as.movConstant(RAX, instruction.second);
+        as.store(RAX, MEMORY_BASE, first, width);
+        return true;
+
+    case OpCode::JMP:
+        fixups.push_back({ as.jump(), (size_t) instruction.first });
+        return true;
+
+    case OpCode::IF_JUMP:
+    case OpCode::IF_NOT_JUMP:
+        as.test(ZERO_FLAG_REGISTER, ZERO_FLAG_REGISTER);
+        fixups.push_back({ as.jumpIf(opCode == OpCode::IF_JUMP ? NOT_EQUAL : EQUAL), (size_t) instruction.first });
+        return true;
+
+    case OpCode::PUSH_CONST:
+        as.movConstant(RDX, instruction.first);
+        pushValue(as, RDX);
+        return true;
+
+    case OpCode::PUSH_REG:
+        loadRegister(as, RDX, instruction.reg);
+        pushValue(as, RDX);
+        return true;
+
+    case OpCode::PUSH_BYTES:
+        moveStackPointer(as, instruction.first, fixups, overflowStub);
+        return true;
+
+    case OpCode::POP:
+        moveStackPointer(as, -instruction.first, fixups, overflowStub);
+        return true;
+
+    case OpCode::PRINT:
+        as.mov(RDI, A_REGISTER);
+        as.call((const void*) printLong);
+        return true;
+
+    case OpCode::ADD_MEM_8:
+    case OpCode::ADD_MEM_4:
+    case OpCode::SUB_MEM_8:
+    case OpCode::SUB_MEM_4:
+    case OpCode::MUL_MEM_8:
+    case OpCode::MUL_MEM_4:
+    case OpCode::ADD_MEM_CONST_8:
+    case OpCode::ADD_MEM_CONST_4:
+    case OpCode::SUB_MEM_CONST_8:
+    case OpCode::SUB_MEM_CONST_4:
+    case OpCode::MUL_MEM_CONST_8:
+    case OpCode::MUL_MEM_CONST_4:
+    {
+        const bool constant =
+            opCode == OpCode::ADD_MEM_CONST_8 || opCode == OpCode::ADD_MEM_CONST_4
+            || opCode == OpCode::SUB_MEM_CONST_8 || opCode == OpCode::SUB_MEM_CONST_4
+            || opCode == OpCode::MUL_MEM_CONST_8 || opCode == OpCode::MUL_MEM_CONST_4;
+
+        if (!isDisplacement(instruction.first) || !isDisplacement(instruction.second)
+            || (!constant && !isDisplacement(instruction.third)))
+        {
+            return false;
+        }
+
+        // registers are left as by the replaced sequence, see the interpreter
+        as.load(A_REGISTER, MEMORY_BASE, second, width);
+
+        if (constant) as.movConstant(B_REGISTER, instruction.third);
+        else as.load(B_REGISTER, MEMORY_BASE, third, width);
+
+        as.mov(RESULT_REGISTER, A_REGISTER);
+
+        switch (opCode)
+        {
+        case OpCode::ADD_MEM_8:
+        case OpCode::ADD_MEM_4:
+        case OpCode::ADD_MEM_CONST_8:
+        case OpCode::ADD_MEM_CONST_4:
+            as.add(RESULT_REGISTER, B_REGISTER);
+            break;
+        case OpCode::SUB_MEM_8:
+        case OpCode::SUB_MEM_4:
+        case OpCode::SUB_MEM_CONST_8:
+        case OpCode::SUB_MEM_CONST_4:
+            as.sub(RESULT_REGISTER, B_REGISTER);
+            break;
+        default:
+            as.imul(RESULT_REGISTER, B_REGISTER);
+            break;
+        }
+
+        setResultFlags(as);
+        as.store(RESULT_REGISTER, MEMORY_BASE, first, width);
+        return true;
+    }
+
+    case OpCode::CMP_MEM_8:
+    case OpCode::CMP_MEM_4:
+    case OpCode::CMP_REVERSE_MEM_8:
+    case OpCode::CMP_REVERSE_MEM_4:
+        if (!isDisplacement(instruction.first) || !isDisplacement(instruction.second)) return false;
+        as.load(A_REGISTER, MEMORY_BASE, first, width);
+        as.load(B_REGISTER, MEMORY_BASE, second, width);
+        as.cmp(A_REGISTER, B_REGISTER);
+        as.setFlag(opCode == OpCode::CMP_MEM_8 || opCode == OpCode::CMP_MEM_4 ? EQUAL : NOT_EQUAL,
+            ZERO_FLAG_REGISTER);
+        return true;
+
+    case OpCode::CMP_MEM_CONST_8:
+    case OpCode::CMP_MEM_CONST_4:
+    case OpCode::CMP_REVERSE_MEM_CONST_8:
+    case OpCode::CMP_REVERSE_MEM_CONST_4:
+        if (!isDisplacement(instruction.first)) return false;
+        as.load(A_REGISTER, MEMORY_BASE, first, width);
+        as.movConstant(B_REGISTER, instruction.second);
+        as.cmp(A_REGISTER, B_REGISTER);
+        as.setFlag(opCode == OpCode::CMP_MEM_CONST_8 || opCode == OpCode::CMP_MEM_CONST_4 ? EQUAL : NOT_EQUAL,
+            ZERO_FLAG_REGISTER);
+        return true;
+
+    case OpCode::IF_NOT_MEM_JUMP:
+        if (!isDisplacement(instruction.second)) return false;
+        as.xorSelf(B_REGISTER);
+        as.load(A_REGISTER, MEMORY_BASE, second, sizeof(Byte));
+        as.test(A_REGISTER, A_REGISTER);
+        as.setFlag(EQUAL, ZERO_FLAG_REGISTER);
+        fixups.push_back({ as.jumpIf(EQUAL), (size_t) instruction.first });
+        return true;
+
+    case OpCode::LD_REG_8:
+    case OpCode::LD_REG_4:
+    case OpCode::LD_REG_1:
+    case OpCode::LD_REG_BIT:
+        if (!isDisplacement(instruction.first)) return false;
+        as.load(RAX, MEMORY_BASE, first, width);
+        storeRegister(as, instruction.reg, RAX);
+        return true;
+
+    case OpCode::LD_CONST_REG:
+        as.movConstant(RAX, instruction.first);
+        storeRegister(as, instruction.reg, RAX);
+        return true;
+
+    case OpCode::REG_TO_REG_4:
+        loadRegister(as, RAX, instruction.reg2);
+        as.signExtendInt(RAX, RAX);
+        storeRegister(as, instruction.reg, RAX);
+        return true;
+
+    case OpCode::REG_TO_REG_1:
+        loadRegister(as, RAX, instruction.reg2);
+        as.zeroExtendByte(RAX, RAX);
+        storeRegister(as, instruction.reg, RAX);
+        return true;
+
+    case OpCode::REG_TO_REG_BIT:
+        loadRegister(as, RDX, instruction.reg2);
+        as.test(RDX, RDX);
+        as.setFlag(NOT_EQUAL, RAX);
+        storeRegister(as, instruction.reg, RAX);
+        return true;
+
+    case OpCode::ADD_REG_8:
+    case OpCode::ADD_REG_4:
+    case OpCode::SUB_REG_8:
+    case OpCode::SUB_REG_4:
+    case OpCode::MUL_REG_8:
+    case OpCode::MUL_REG_4:
+    case OpCode::ADD_REG_CONST_8:
+    case OpCode::ADD_REG_CONST_4:
+    case OpCode::SUB_REG_CONST_8:
+    case OpCode::SUB_REG_CONST_4:
+    case OpCode::MUL_REG_CONST_8:
+    case OpCode::MUL_REG_CONST_4:
+    {
+        const bool constant =
+            opCode == OpCode::ADD_REG_CONST_8 || opCode == OpCode::ADD_REG_CONST_4
+            || opCode == OpCode::SUB_REG_CONST_8 || opCode == OpCode::SUB_REG_CONST_4
+            || opCode == OpCode::MUL_REG_CONST_8 || opCode == OpCode::MUL_REG_CONST_4;
+
+        const bool isInt =
+            opCode == OpCode::ADD_REG_4 || opCode == OpCode::ADD_REG_CONST_4
+            || opCode == OpCode::SUB_REG_4 || opCode == OpCode::SUB_REG_CONST_4
+            || opCode == OpCode::MUL_REG_4 || opCode == OpCode::MUL_REG_CONST_4;
+
+        // registers are left as by the replaced sequence, see the interpreter
+        loadRegister(as, A_REGISTER, instruction.reg2);
+
+        if (constant) as.movConstant(B_REGISTER, instruction.first);
+        else loadRegister(as, B_REGISTER, instruction.reg3);
+
+        as.mov(RESULT_REGISTER, A_REGISTER);
+
+        switch (opCode)
+        {
+        case OpCode::ADD_REG_8:
+        case OpCode::ADD_REG_4:
+        case OpCode::ADD_REG_CONST_8:
+        case OpCode::ADD_REG_CONST_4:
+            as.add(RESULT_REGISTER, B_REGISTER);
+            break;
+        case OpCode::SUB_REG_8:
+        case OpCode::SUB_REG_4:
+        case OpCode::SUB_REG_CONST_8:
+        case OpCode::SUB_REG_CONST_4:
+            as.sub(RESULT_REGISTER, B_REGISTER);
+            break;
+        default:
+            as.imul(RESULT_REGISTER, B_REGISTER);
+            break;
+        }
+
+        setResultFlags(as);
+
+        if (isInt)
+        {
+            as.signExtendInt(RAX, RESULT_REGISTER);
+            storeRegister(as, instruction.reg, RAX);
+        }
+        else
+        {
+            storeRegister(as, instruction.reg, RESULT_REGISTER);
+        }
+        return true;
+    }
+
+    case OpCode::CMP_REG:
+    case OpCode::CMP_REVERSE_REG:
+        loadRegister(as, A_REGISTER, instruction.reg);
+        loadRegister(as, B_REGISTER, instruction.reg2);
+        as.cmp(A_REGISTER, B_REGISTER);
+        as.setFlag(opCode == OpCode::CMP_REG ? EQUAL : NOT_EQUAL, ZERO_FLAG_REGISTER);
+        return true;
+
+    case OpCode::CMP_REG_CONST:
+    case OpCode::CMP_REVERSE_REG_CONST:
+        loadRegister(as, A_REGISTER, instruction.reg);
+        as.movConstant(B_REGISTER, instruction.first);
+        as.cmp(A_REGISTER, B_REGISTER);
+        as.setFlag(opCode == OpCode::CMP_REG_CONST ? EQUAL : NOT_EQUAL, ZERO_FLAG_REGISTER);
+        return true;
+
+    case OpCode::IF_NOT_REG_JUMP:
+        loadRegister(as, A_REGISTER, instruction.reg);
+        as.xorSelf(B_REGISTER);
+        as.test(A_REGISTER, A_REGISTER);
+        as.setFlag(EQUAL, ZERO_FLAG_REGISTER);
+        fixups.push_back({ as.jumpIf(EQUAL), (size_t) instruction.first });
+        return true;
+
+    case OpCode::CALL:
+    case OpCode::NO_OP:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
+// translates the program to machine code
+// returns false if any instruction can't be translated
+static bool assemble(const std::vector<Instruction>& program, Assembler& as)
+{
+    // code offset of every instruction, the extra slots are the shared stubs
+    std::vector<size_t> labels(program.size() + 5);
+
+    const size_t end = program.size();
+    const size_t epilogue = end + 1;
+    const size_t overflowStub = end + 2;
+    const size_t zeroDivisionStub = end + 3;
+    const size_t divisionOverflowStub = end + 4;
+
+    std::vector<Fixup> fixups;
+
+    // prologue, the Context pointer comes in rdi
+    for (Host reg : calleeSaved)
+    {
+        as.push(reg);
+    }
+    as.adjustStack(-FRAME_SIZE);
+
+    as.store(RDI, RSP, CONTEXT_SLOT, sizeof(long));
+    as.load(MEMORY_BASE, RDI, CONTEXT_OFFSET(memory), sizeof(long));
+
+    for (unsigned char reg = 0; reg < REGISTER_COUNT; reg++)
+    {
+        as.load(RAX, RDI, REGISTER_OFFSET(reg), sizeof(long));
+        storeRegister(as, reg, RAX);
+    }
+
+    for (size_t i = 0; i < program.size(); i++)
+    {
+        labels[i] = as.size();
+
+        if (!translate(as, program[i], fixups, epilogue, overflowStub, zeroDivisionStub, divisionOverflowStub))
+        {
+            return false;
+        }
+    }
+
+    // unreachable, decode() rejects programs that can run past their last instruction
+    labels[end] = as.size();
+    as.ud2();
+
+    // epilogue, the exit code is in rax
+    labels[epilogue] = as.size();
+
+    as.load(RCX, RSP, CONTEXT_SLOT, sizeof(long));
+
+    for (unsigned char reg = 0; reg < REGISTER_COUNT; reg++)
+    {
+        loadRegister(as, RDX, reg);
+        as.store(RDX, RCX, REGISTER_OFFSET(reg), sizeof(long));
+    }
+
+    as.adjustStack(FRAME_SIZE);
+    for (size_t i = sizeof(calleeSaved) / sizeof(Host); i > 0; i--)
+    {
+        as.pop(calleeSaved[i - 1]);
+    }
+    as.ret();
+
+    // the error stubs set the error of the run and leave through the epilogue
+    // reached when a frame push or pop moves the stack pointer out of the memory
+    labels[overflowStub] = as.size();
+    setError(as, Error::STACK_OVERFLOW);
+    fixups.push_back({ as.jump(), epilogue });
+
+    // reached by divisions that would raise SIGFPE
+    labels[zeroDivisionStub] = as.size();
+    setError(as, Error::ZERO_DIVISION);
+    fixups.push_back({ as.jump(), epilogue });
+
+    labels[divisionOverflowStub] = as.size();
+    setError(as, Error::DIVISION_OVERFLOW);
+    fixups.push_back({ as.jump(), epilogue });
+
+    for (const Fixup& fixup : fixups)
+    {
+        as.patch32(fixup.operand, (int) (labels[fixup.target] - (fixup.operand + sizeof(int))));
+    }
+
+    return true;
+}
+
+
+NativeProgram::NativeProgram(const std::vector<Instruction>& program)
+: code(nullptr), size(0)
+{
+    Assembler as;
+
+    if (!assemble(program, as))
+    {
+        return;
+    }
+
+    // the code is written first and only then made executable, never both at once
+    void* mapping = mmap(nullptr, as.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (mapping == MAP_FAILED)
+    {
+        return;
+    }
+
+    memcpy(mapping, as.bytes().data(), as.size());
+
+    if (mprotect(mapping, as.size(), PROT_READ | PROT_EXEC) != 0)
+    {
+        munmap(mapping, as.size());
+        return;
+    }
+
+    code = mapping;
+    size = as.size();
+}
+
+
+#else // PVM_JIT
+
+
+NativeProgram::NativeProgram(const std::vector<Instruction>& program)
+: code(nullptr), size(0)
+{
+
+}
+
+
+#endif // PVM_JIT
+
+
+NativeProgram::~NativeProgram()
+{
+    if (code != nullptr)
+    {
+        munmap(code, size);
+    }
+}
+
+
+bool NativeProgram::isSupported() const
+{
+    return code != nullptr;
+}
+
+
+Byte NativeProgram::run(Context& context) const
+{
+    const Byte exitCode = ((NativeFunction) code)(&context);
+
+    switch (context.error)
+    {
+    case Error::NONE:
+        break;
+
+    case Error::STACK_OVERFLOW:
+        errors::StackOverflowError();
+        break;
+
+    case Error::ZERO_DIVISION:
+        errors::ZeroDivisionError(context.registers[(unsigned char) Registers::GENERAL_A]);
+        break;
+
+    case Error::DIVISION_OVERFLOW:
+        errors::DivisionOverflowError();
+        break;
+    }
+
+    return exitCode;
+}
+
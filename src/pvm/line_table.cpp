@@ -0,0 +1,43 @@
+#include "pvm.hh"
+
+#include <algorithm>
+
+
+using namespace pvm;
+
+
+LineTable::LineTable(const LineEntry* entries, size_t count)
+: entries(entries), count(count)
+{
+
+}
+
+
+LineTable::LineTable()
+: entries(nullptr), count(0)
+{
+
+}
+
+
+const LineEntry* LineTable::find(size_t offset) const
+{
+    // first entry past the offset, the one before it covers the offset
+    const LineEntry* const next = std::upper_bound(
+        entries, entries + count, offset,
+        [](size_t offset, const LineEntry& entry) { return offset < entry.offset; }
+    );
+
+    if (next == entries || (next - 1)->line == 0)
+    {
+        return nullptr;
+    }
+
+    return next - 1;
+}
+
+
+bool LineTable::isEmpty() const
+{
+    return count == 0;
+}
@@ -1,19 +1,155 @@
 #include "pvm.hh"
+#include "errors.hh"
+
+#include <atomic>
+#include <mutex>
+
+#include <sys/mman.h>
+#include <unistd.h>
 
 
 using namespace pvm;
 
 
+// innermost Trap armed by the calling thread
+// the initial-exec model keeps it async-signal-safe when built in a shared library
+static thread_local Memory::Trap* armedTrap __attribute__((tls_model("initial-exec"))) = nullptr;
+
+// the SIGSEGV action replaced by onSegmentationFault(), faults that aren't
+// stack overflows are passed on to it
+static struct sigaction previousAction;
+
+static std::once_flag handlerInstalled;
+
+
+// rounds the given size up to a multiple of the page size
+static size_t toPages(size_t size, size_t pageSize)
+{
+    return (size + pageSize - 1) / pageSize * pageSize;
+}
+
+
+bool Memory::isGuardPage(const void* address) const
+{
+    const Byte* const byte = (const Byte*) address;
+
+    return (byte >= stack - guardSize && byte < stack)
+        || (byte >= stack + size && byte < stack + size + guardSize);
+}
+
+
+void Memory::onSegmentationFault(int signal, siginfo_t* info, void* context)
+{
+    // only the Traps of the faulting thread are looked at, the fault happened
+    // in one of its runs or not in a run at all
+    for (Trap* trap = armedTrap; trap != nullptr; trap = trap->previous)
+    {
+        if (trap->memory->isGuardPage(info->si_addr))
+        {
+            // SIGSEGV isn't blocked while the handler runs, so the signal mask
+            // doesn't need restoring
+            siglongjmp(trap->context, 1);
+        }
+    }
+
+    if (previousAction.sa_flags & SA_SIGINFO)
+    {
+        previousAction.sa_sigaction(signal, info, context);
+        return;
+    }
+
+    if (previousAction.sa_handler != SIG_DFL && previousAction.sa_handler != SIG_IGN)
+    {
+        previousAction.sa_handler(signal);
+        return;
+    }
+
+    // let the fault crash the process as usual
+    // once the handler returns, the faulting instruction is executed again
+    ::signal(signal, SIG_DFL);
+}
+
+
 Memory::Memory(size_t size)
-: size(size)
 {
-    stack = new Byte[size];
+    guardSize = (size_t) sysconf(_SC_PAGESIZE);
+    this->size = toPages(size, guardSize);
+
+    // reserve the whole range without committing it, then open up the usable part
+    // the guard pages are left inaccessible
+    Byte* mapping = (Byte*) mmap(
+        nullptr, this->size + 2 * guardSize, PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (mapping == MAP_FAILED)
+    {
+        errors::OutOfMemoryError(this->size);
+    }
+
+    stack = mapping + guardSize;
+
+    if (mprotect(stack, this->size, PROT_READ | PROT_WRITE) != 0)
+    {
+        munmap(mapping, this->size + 2 * guardSize);
+        errors::OutOfMemoryError(this->size);
+    }
+
+    std::call_once(handlerInstalled, []()
+    {
+        struct sigaction action = {};
+        action.sa_sigaction = onSegmentationFault;
+        // SA_NODEFER lets the handler jump out without leaving SIGSEGV blocked
+        action.sa_flags = SA_SIGINFO | SA_NODEFER | SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+
+        sigaction(SIGSEGV, &action, &previousAction);
+    });
 }
 
 
 Memory::~Memory()
 {
-    delete[] stack;
+    munmap(stack - guardSize, size + 2 * guardSize);
+}
+
+
+size_t Memory::getSize() const
+{
+    return size;
+}
+
+
+Byte* Memory::getBase() const
+{
+    return stack;
+}
+
+
+void Memory::clear()
+{
+    // anonymous pages read as zeros once they are dropped
+    if (madvise(stack, size, MADV_DONTNEED) != 0)
+    {
+        memset(stack, 0, size);
+    }
+}
+
+
+void Memory::arm(Trap& trap) const
+{
+    trap.memory = this;
+    trap.previous = armedTrap;
+
+    // the handler may run on this thread at any point, it has to see a complete Trap
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+
+    armedTrap = &trap;
+}
+
+
+void Memory::disarm(const Trap& trap)
+{
+    armedTrap = trap.previous;
 }
 
 
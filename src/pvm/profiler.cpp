@@ -0,0 +1,298 @@
+#include "pvm.hh"
+#include "errors.hh"
+
+#include "pch.hh"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+
+
+using namespace pvm;
+
+
+// number of byte code offsets listed by the profile report
+#define PROFILE_REPORT_OFFSETS 20
+
+// number of source lines listed by the samples report
+#define SAMPLES_REPORT_LINES 20
+
+
+// statistics of all the instructions sharing an OpCode
+typedef struct OpCodeProfile
+{
+    OpCode opCode;
+    InstructionProfile total;
+
+} OpCodeProfile;
+
+
+// byte code offset of every instruction, computed from the instruction sizes
+static std::vector<size_t> instructionOffsets(const std::vector<Instruction>& program)
+{
+    std::vector<size_t> offsets;
+    offsets.reserve(program.size());
+
+    size_t offset = 0;
+
+    for (const Instruction& instruction : program)
+    {
+        offsets.push_back(offset);
+        offset += instructionSize(instruction.opCode);
+    }
+
+    return offsets;
+}
+
+
+// sums the statistics of the instructions by OpCode, most expensive first
+// OpCodes that were never executed are left out
+static std::vector<OpCodeProfile> profileByOpCode(const std::vector<Instruction>& program, const std::vector<InstructionProfile>& profile)
+{
+    std::vector<OpCodeProfile> opCodes(OP_CODE_COUNT);
+
+    for (size_t i = 0; i != OP_CODE_COUNT; i++)
+    {
+        opCodes[i] = OpCodeProfile { (OpCode) i, { 0, 0 } };
+    }
+
+    for (size_t i = 0; i != program.size(); i++)
+    {
+        InstructionProfile& total = opCodes[(unsigned char) program[i].opCode].total;
+        total.count += profile[i].count;
+        total.cycles += profile[i].cycles;
+    }
+
+    opCodes.erase(
+        std::remove_if(opCodes.begin(), opCodes.end(), [](const OpCodeProfile& entry) { return entry.total.count == 0; }),
+        opCodes.end()
+    );
+
+    std::stable_sort(opCodes.begin(), opCodes.end(), [](const OpCodeProfile& a, const OpCodeProfile& b) {
+        return a.total.cycles > b.total.cycles;
+    });
+
+    return opCodes;
+}
+
+
+// percentage of the total cycles, 0 if nothing was measured
+static double share(uint64_t cycles, uint64_t total)
+{
+    return total == 0 ? 0.0 : 100.0 * (double) cycles / (double) total;
+}
+
+
+void pvm::printProfile(const std::vector<Instruction>& program, const std::vector<InstructionProfile>& profile, std::ostream& stream)
+{
+    const std::vector<size_t> offsets = instructionOffsets(program);
+
+    uint64_t totalCycles = 0;
+    size_t totalCount = 0;
+
+    for (const InstructionProfile& entry : profile)
+    {
+        totalCycles += entry.cycles;
+        totalCount += entry.count;
+    }
+
+    stream << "\nExecuted " << totalCount << " instructions in " << totalCycles << " cycles\n";
+
+    const std::ios_base::fmtflags flags = stream.flags();
+    stream << std::fixed << std::setprecision(2);
+
+    // per OpCode table
+    stream << "\n" << std::left << std::setw(24) << "OpCode" << std::right
+        << std::setw(14) << "Count" << std::setw(16) << "Cycles" << std::setw(9) << "%" << std::setw(14) << "Cycles/exec" << "\n";
+
+    for (const OpCodeProfile& entry : profileByOpCode(program, profile))
+    {
+        stream << std::left << std::setw(24) << entry.opCode << std::right
+            << std::setw(14) << entry.total.count
+            << std::setw(16) << entry.total.cycles
+            << std::setw(9) << share(entry.total.cycles, totalCycles)
+            << std::setw(14) << (double) entry.total.cycles / (double) entry.total.count << "\n";
+    }
+
+    // hottest byte code offsets
+    std::vector<size_t> hottest;
+
+    for (size_t i = 0; i != program.size(); i++)
+    {
+        if (profile[i].count != 0)
+        {
+            hottest.push_back(i);
+        }
+    }
+
+    std::stable_sort(hottest.begin(), hottest.end(), [&profile](size_t a, size_t b) {
+        return profile[a].cycles > profile[b].cycles;
+    });
+
+    if (hottest.size() > PROFILE_REPORT_OFFSETS)
+    {
+        hottest.resize(PROFILE_REPORT_OFFSETS);
+    }
+
+    stream << "\n" << std::right << std::setw(8) << "Offset" << "  " << std::left << std::setw(24) << "OpCode" << std::right
+        << std::setw(14) << "Count" << std::setw(16) << "Cycles" << std::setw(9) << "%" << "\n";
+
+    for (const size_t i : hottest)
+    {
+        stream << std::right << std::setw(8) << offsets[i] << "  " << std::left << std::setw(24) << program[i].opCode << std::right
+            << std::setw(14) << profile[i].count
+            << std::setw(16) << profile[i].cycles
+            << std::setw(9) << share(profile[i].cycles, totalCycles) << "\n";
+    }
+
+    stream.flags(flags);
+}
+
+
+void pvm::writeProfile(const std::vector<Instruction>& program, const std::vector<InstructionProfile>& profile, const char* name)
+{
+    std::ofstream file(name);
+
+    if (!file.is_open())
+    {
+        errors::FileWriteError(name);
+    }
+
+    const std::vector<size_t> offsets = instructionOffsets(program);
+
+    file << "kind\toffset\topcode\tcount\tcycles\n";
+
+    for (const OpCodeProfile& entry : profileByOpCode(program, profile))
+    {
+        file << "opcode\t-\t" << entry.opCode << "\t" << entry.total.count << "\t" << entry.total.cycles << "\n";
+    }
+
+    // offsets are listed in program order, including the ones that never ran
+    for (size_t i = 0; i != program.size(); i++)
+    {
+        file << "offset\t" << offsets[i] << "\t" << program[i].opCode << "\t" << profile[i].count << "\t" << profile[i].cycles << "\n";
+    }
+
+    file.close();
+
+    if (file.fail())
+    {
+        errors::FileWriteError(name);
+    }
+}
+
+
+// where the samples were taken, "line <n>" or "offset <n>" without a line table
+// sorted by number of samples, most sampled first
+static std::vector<std::pair<std::string, size_t>> samplesByLocation(const std::vector<Instruction>& program, const std::vector<size_t>& samples, const LineTable& lineTable)
+{
+    const std::vector<size_t> offsets = instructionOffsets(program);
+
+    // keyed by line, or by offset without a line table
+    // line 0 gathers the samples of unknown locations
+    std::map<size_t, size_t> counts;
+
+    for (size_t i = 0; i != program.size(); i++)
+    {
+        if (samples[i] == 0)
+        {
+            continue;
+        }
+
+        if (lineTable.isEmpty())
+        {
+            counts[offsets[i]] += samples[i];
+            continue;
+        }
+
+        const LineEntry* const entry = lineTable.find(offsets[i]);
+        counts[entry == nullptr ? 0 : entry->line] += samples[i];
+    }
+
+    std::vector<std::pair<std::string, size_t>> locations;
+
+    for (const std::pair<const size_t, size_t>& count : counts)
+    {
+        if (lineTable.isEmpty())
+        {
+            locations.emplace_back("offset " + std::to_string(count.first), count.second);
+        }
+        else if (count.first == 0)
+        {
+            locations.emplace_back("unknown", count.second);
+        }
+        else
+        {
+            locations.emplace_back("line " + std::to_string(count.first), count.second);
+        }
+    }
+
+    std::stable_sort(locations.begin(), locations.end(), [](const std::pair<std::string, size_t>& a, const std::pair<std::string, size_t>& b) {
+        return a.second > b.second;
+    });
+
+    return locations;
+}
+
+
+void pvm::printSamples(const std::vector<Instruction>& program, const std::vector<size_t>& samples, const LineTable& lineTable, std::ostream& stream)
+{
+    size_t total = 0;
+
+    for (const size_t count : samples)
+    {
+        total += count;
+    }
+
+    stream << "\nCollected " << total << " samples\n";
+
+    if (lineTable.isEmpty())
+    {
+        stream << "The executable has no line table, samples are listed by byte code offset\n";
+    }
+
+    std::vector<std::pair<std::string, size_t>> locations = samplesByLocation(program, samples, lineTable);
+
+    if (locations.size() > SAMPLES_REPORT_LINES)
+    {
+        locations.resize(SAMPLES_REPORT_LINES);
+    }
+
+    const std::ios_base::fmtflags flags = stream.flags();
+    stream << std::fixed << std::setprecision(2);
+
+    stream << "\n" << std::left << std::setw(20) << "Location" << std::right << std::setw(12) << "Samples" << std::setw(9) << "%" << "\n";
+
+    for (const std::pair<std::string, size_t>& location : locations)
+    {
+        stream << std::left << std::setw(20) << location.first << std::right
+            << std::setw(12) << location.second
+            << std::setw(9) << share(location.second, total) << "\n";
+    }
+
+    stream.flags(flags);
+}
+
+
+void pvm::writeFoldedSamples(const std::vector<Instruction>& program, const std::vector<size_t>& samples, const LineTable& lineTable, const char* root, const char* name)
+{
+    std::ofstream file(name);
+
+    if (!file.is_open())
+    {
+        errors::FileWriteError(name);
+    }
+
+    // the Pvm has no call frames, so every stack is one level deep
+    for (const std::pair<std::string, size_t>& location : samplesByLocation(program, samples, lineTable))
+    {
+        file << root << ';' << location.first << ' ' << location.second << "\n";
+    }
+
+    file.close();
+
+    if (file.fail())
+    {
+        errors::FileWriteError(name);
+    }
+}
@@ -1,77 +1,476 @@
 #include "pvm.hh"
+#include "jit.hh"
+#include "errors.hh"
+
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+
+#include <sys/syscall.h>
+#include <signal.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+    #include <x86intrin.h>
+#endif
 
 
 using namespace pvm;
 
 
+// memory bytes per line printed by Pvm::printState()
+#define STATE_BYTES_PER_LINE 16
+
+
 Pvm::Pvm(size_t memSize)
-:   memory(memSize), rGeneralA(0), rGeneralB(0),
-    rResult(0), rDivisionRemainder(0), rZeroFlag(0),
-    rSignFlag(0), rStackPointer(0)
+:   memory(memSize), registers(), rStackPointer(0), instructionCount(0), dispatchTable()
 {
 
 }
 
 
-static inline long getLongValue(const Byte* byteCode, size_t& offset)
+void Pvm::reset()
 {
-    const long value = *((long*) (byteCode + offset));
-    offset += sizeof(long);
-    return value;
+    memset(registers, 0, sizeof(registers));
+    rStackPointer = 0;
+    instructionCount = 0;
+
+    memory.clear();
 }
 
-static inline int getIntValue(const Byte* byteCode, size_t& offset)
+
+const Memory& Pvm::getMemory() const
 {
-    const int value = *((int*) (byteCode + offset));
-    offset += sizeof(int);
-    return value;
+    return memory;
 }
 
 
-static inline Byte getByteValue(const Byte* byteCode, size_t& offset)
+void Pvm::printState(std::ostream& stream) const
 {
-    const Byte value = byteCode[offset];
-    offset ++;
-    return value;
+    stream << "Registers:\n";
+
+    for (unsigned int reg = 0; reg != REGISTER_COUNT; reg++)
+    {
+        stream << registerName((Registers) reg) << ": " << registers[reg] << '\n';
+    }
+
+    // trailing zeros are left out, so the output doesn't depend on the memory size
+    const Byte* const bytes = memory.getBase();
+    size_t used = memory.getSize();
+
+    while (used != 0 && bytes[used - 1] == 0)
+    {
+        used --;
+    }
+
+    stream << "Memory: " << used << " bytes" << std::hex << std::setfill('0');
+
+    for (size_t i = 0; i != used; i++)
+    {
+        if (i % STATE_BYTES_PER_LINE == 0)
+        {
+            stream << '\n' << std::setw(8) << i << ':';
+        }
+
+        stream << ' ' << std::setw(2) << (unsigned int) bytes[i];
+    }
+
+    stream << std::dec << std::setfill(' ') << std::endl;
 }
 
 
-Byte Pvm::execute(const Byte* byteCode)
+/*
+    Every instruction handler is both a switch case and, when computed goto is
+    available, a label whose address is stored in the dispatch table.
+    The switch engine goes back to the switch after every handler, whereas the
+    threaded engine jumps straight to the handler of the next instruction.
+*/
+
+#if PVM_COMPUTED_GOTO
+
+    #define HANDLER(opCode) case OpCode::opCode: op_##opCode:
+
+    #define NEXT() \
+        if constexpr (threaded) \
+        { \
+            INSTRUMENT(); \
+            instruction = instructions + pc; \
+            goto *dispatch[pc ++]; \
+        } \
+        break
+
+#else
+
+    #define HANDLER(opCode) case OpCode::opCode:
+
+    #define NEXT() break
+
+#endif
+
+
+/*
+    Instrumented instantiations do their bookkeeping right before dispatching
+    every instruction, the uninstrumented ones compile it away.
+    Timing reads the cycle counter, charges the elapsed cycles to the
+    instruction that just ran and counts the one about to run.
+    Sampling publishes the instruction about to run to the SIGPROF handler.
+*/
+
+#define INSTRUMENT() \
+    if constexpr (instrumentation == Instrumentation::COUNTING) \
+    { \
+        instructionCount ++; \
+    } \
+    else if constexpr (instrumentation == Instrumentation::TIMING) \
+    { \
+        const uint64_t now = readCycleCounter(); \
+        stats[current].cycles += now - last; \
+        last = now; \
+        current = pc; \
+        stats[pc].count ++; \
+    } \
+    else if constexpr (instrumentation == Instrumentation::SAMPLING) \
+    { \
+        sampledInstruction = pc; \
+    }
+
+
+// cheapest available monotonic clock
+// timestamp counter cycles on x86-64, nanoseconds elsewhere
+static inline uint64_t readCycleCounter()
 {
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+#endif
+}
+
+
+/*
+    Every sampled run has its own timer, which measures the cpu time of its
+    thread and sends SIGPROF to that thread only. The state of the run is
+    kept per thread, so the handler finds the run its signal belongs to and
+    separate threads can sample their runs at the same time.
+    The initial-exec model keeps the thread locals async-signal-safe when
+    built in a shared library.
+*/
+
+// instruction about to be executed by the sampled run of the thread
+static thread_local volatile size_t sampledInstruction __attribute__((tls_model("initial-exec"))) = 0;
+
+// samples taken during the sampled run of the thread, indexed like the program
+static thread_local size_t* sampleCounts __attribute__((tls_model("initial-exec"))) = nullptr;
 
-    // index of execution (offset from byteCode pointer)
-    size_t offset = 0;
+// the SIGPROF action replaced by onProfilingTimer(), signals that don't
+// come from a sampling timer are passed on to it
+static struct sigaction previousProfilingAction;
 
-    // exit code that will be set by the EXIT instruction and finally returned
-    Byte exitCode;
+static std::once_flag profilingHandlerInstalled;
 
-    bool executing = true;
-    while (executing)
+// the value of the sampling timers' signals, tells them apart from other SIGPROF sources
+static char samplingTimerTag;
+
+
+#ifndef sigev_notify_thread_id
+    #define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+
+static void onProfilingTimer(int signal, siginfo_t* info, void* context)
+{
+    if (info->si_code == SI_TIMER && info->si_value.sival_ptr == &samplingTimerTag)
     {
-        switch ((OpCode) byteCode[offset ++])
+        // a signal may still be pending when the run ends
+        if (sampleCounts != nullptr)
         {
+            sampleCounts[sampledInstruction] ++;
+        }
+
+        return;
+    }
+
+    if (previousProfilingAction.sa_flags & SA_SIGINFO)
+    {
+        previousProfilingAction.sa_sigaction(signal, info, context);
+    }
+    else if (previousProfilingAction.sa_handler == SIG_DFL)
+    {
+        // the default action ends the process, as it would have without this handler
+        sigaction(signal, &previousProfilingAction, nullptr);
+        raise(signal);
+    }
+    else if (previousProfilingAction.sa_handler != SIG_IGN)
+    {
+        previousProfilingAction.sa_handler(signal);
+    }
+}
+
+
+// samples the running instruction of the calling thread while it exists
+class SamplingTimer
+{
+private:
+
+    timer_t timer;
+
+public:
+
+    SamplingTimer(size_t* samples, unsigned int interval)
+    {
+        std::call_once(profilingHandlerInstalled, []()
+        {
+            struct sigaction action = {};
+            action.sa_sigaction = onProfilingTimer;
+            action.sa_flags = SA_SIGINFO | SA_RESTART;
+            sigemptyset(&action.sa_mask);
+
+            sigaction(SIGPROF, &action, &previousProfilingAction);
+        });
+
+        sampledInstruction = 0;
+        sampleCounts = samples;
+
+        struct sigevent event = {};
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = SIGPROF;
+        event.sigev_value.sival_ptr = &samplingTimerTag;
+        event.sigev_notify_thread_id = (pid_t) syscall(SYS_gettid);
+
+        if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer) != 0)
+        {
+            sampleCounts = nullptr;
+            errors::UnexpectedBehaviourError("could not create the sampling timer");
+        }
+
+        // the timer only ticks while the thread is running, so samples are spread over its cpu time
+        struct itimerspec period = {};
+        period.it_interval.tv_sec = interval / 1000000;
+        period.it_interval.tv_nsec = (long) (interval % 1000000) * 1000;
+        period.it_value = period.it_interval;
+
+        timer_settime(timer, 0, &period, nullptr);
+    }
+
+    ~SamplingTimer()
+    {
+        timer_delete(timer);
+
+        sampleCounts = nullptr;
+    }
+
+    SamplingTimer(const SamplingTimer&) = delete;
+    SamplingTimer& operator=(const SamplingTimer&) = delete;
+
+};
+
+
+template <bool threaded, Pvm::Instrumentation instrumentation>
+Byte Pvm::run(const std::vector<Instruction>& program)
+{
+    const Instruction* const instructions = program.data();
+
+    // index of the next instruction to execute
+    size_t pc = 0;
 
-        case OpCode::EXIT:
+    // instruction being executed
+    const Instruction* instruction;
 
-            exitCode = byteCode[offset];
-            
-            executing = false;
-            break;
-        
+    // local copy of the register file, written back when the program exits
+    // being local, the compiler knows memory writes can't alias it
+    long regs[REGISTER_COUNT];
+    memcpy(regs, registers, sizeof(registers));
 
-        case OpCode::CMP:
+    long& rGeneralA = regs[(unsigned char) Registers::GENERAL_A];
+    long& rGeneralB = regs[(unsigned char) Registers::GENERAL_B];
+    long& rResult = regs[(unsigned char) Registers::RESULT];
+    long& rDivisionRemainder = regs[(unsigned char) Registers::DIVISION_REMAINDER];
+    long& rZeroFlag = regs[(unsigned char) Registers::ZERO_FLAG];
+    long& rSignFlag = regs[(unsigned char) Registers::SIGN_FLAG];
+
+    // the stack pointer is only checked against the memory size when whole
+    // frames are pushed or popped
+    const size_t memorySize = memory.getSize();
+
+    if constexpr (instrumentation == Instrumentation::COUNTING)
+    {
+        instructionCount = 0;
+    }
+
+    // timing state, optimized away by the other instantiations
+    [[maybe_unused]] InstructionProfile* const stats = profile.data();
+    [[maybe_unused]] size_t current = 0;
+    [[maybe_unused]] uint64_t last = 0;
+
+    if constexpr (instrumentation == Instrumentation::TIMING)
+    {
+        last = readCycleCounter();
+    }
+
+#if PVM_COMPUTED_GOTO
+
+    // handler addresses, indexed by OpCode
+    static const void* const handlers[OP_CODE_COUNT] =
+    {
+        &&op_EXIT,
+        &&op_ADD,
+        &&op_SUB,
+        &&op_MUL,
+        &&op_DIV,
+        &&op_CMP,
+        &&op_CMP_REVERSE,
+        &&op_LD_CONST_A_8,
+        &&op_LD_CONST_A_4,
+        &&op_LD_CONST_A_1,
+        &&op_LD_CONST_A_BIT,
+        &&op_LD_CONST_B_8,
+        &&op_LD_CONST_B_4,
+        &&op_LD_CONST_B_1,
+        &&op_LD_CONST_B_BIT,
+        &&op_LD_CONST_RESULT_8,
+        &&op_LD_CONST_RESULT_4,
+        &&op_LD_CONST_RESULT_1,
+        &&op_LD_CONST_RESULT_BIT,
+        &&op_LD_A_8,
+        &&op_LD_A_4,
+        &&op_LD_A_1,
+        &&op_LD_A_BIT,
+        &&op_LD_B_8,
+        &&op_LD_B_4,
+        &&op_LD_B_1,
+        &&op_LD_B_BIT,
+        &&op_LD_RESULT_8,
+        &&op_LD_RESULT_4,
+        &&op_LD_RESULT_1,
+        &&op_LD_RESULT_BIT,
+        &&op_LD_ZERO_FLAG,
+        &&op_MEM_MOV_8,
+        &&op_MEM_MOV_4,
+        &&op_MEM_MOV_1,
+        &&op_MEM_MOV_BIT,
+        &&op_REG_MOV_8,
+        &&op_REG_MOV_4,
+        &&op_REG_MOV_1,
+        &&op_REG_MOV_BIT,
+        &&op_REG_TO_REG,
+        &&op_MEM_SET_8,
+        &&op_MEM_SET_4,
+        &&op_MEM_SET_1,
+        &&op_MEM_SET_BIT,
+        &&op_JMP,
+        &&op_IF_JUMP,
+        &&op_IF_NOT_JUMP,
+        &&op_PUSH_CONST,
+        &&op_PUSH_REG,
+        &&op_PUSH_BYTES,
+        &&op_POP,
+        &&op_CALL,
+        &&op_PRINT,
+        &&op_ADD_MEM_8,
+        &&op_ADD_MEM_4,
+        &&op_ADD_MEM_CONST_8,
+        &&op_ADD_MEM_CONST_4,
+        &&op_SUB_MEM_8,
+        &&op_SUB_MEM_4,
+        &&op_SUB_MEM_CONST_8,
+        &&op_SUB_MEM_CONST_4,
+        &&op_MUL_MEM_8,
+        &&op_MUL_MEM_4,
+        &&op_MUL_MEM_CONST_8,
+        &&op_MUL_MEM_CONST_4,
+        &&op_CMP_MEM_8,
+        &&op_CMP_MEM_4,
+        &&op_CMP_MEM_CONST_8,
+        &&op_CMP_MEM_CONST_4,
+        &&op_CMP_REVERSE_MEM_8,
+        &&op_CMP_REVERSE_MEM_4,
+        &&op_CMP_REVERSE_MEM_CONST_8,
+        &&op_CMP_REVERSE_MEM_CONST_4,
+        &&op_IF_NOT_MEM_JUMP,
+        &&op_LD_REG_8,
+        &&op_LD_REG_4,
+        &&op_LD_REG_1,
+        &&op_LD_REG_BIT,
+        &&op_LD_CONST_REG,
+        &&op_REG_TO_REG_4,
+        &&op_REG_TO_REG_1,
+        &&op_REG_TO_REG_BIT,
+        &&op_ADD_REG_8,
+        &&op_ADD_REG_4,
+        &&op_ADD_REG_CONST_8,
+        &&op_ADD_REG_CONST_4,
+        &&op_SUB_REG_8,
+        &&op_SUB_REG_4,
+        &&op_SUB_REG_CONST_8,
+        &&op_SUB_REG_CONST_4,
+        &&op_MUL_REG_8,
+        &&op_MUL_REG_4,
+        &&op_MUL_REG_CONST_8,
+        &&op_MUL_REG_CONST_4,
+        &&op_CMP_REG,
+        &&op_CMP_REG_CONST,
+        &&op_CMP_REVERSE_REG,
+        &&op_CMP_REVERSE_REG_CONST,
+        &&op_IF_NOT_REG_JUMP,
+        &&op_NO_OP,
+    };
+
+    // one handler address per instruction
+    // the program is already decoded, so every OpCode is valid
+    const void** dispatch = nullptr;
+
+    if constexpr (threaded)
+    {
+        dispatchTable.resize(program.size());
+        dispatch = dispatchTable.data();
+
+        for (size_t i = 0; i != program.size(); i++)
+        {
+            dispatch[i] = handlers[(unsigned char) instructions[i].opCode];
+        }
+    }
+
+#endif
+
+    // the threaded engine only goes through the switch for its first instruction
+    while (true)
+    {
+        INSTRUMENT();
+
+        instruction = instructions + pc ++;
+
+        switch (instruction->opCode)
+        {
+
+        HANDLER(EXIT)
+            memcpy(registers, regs, sizeof(registers));
+
+            if constexpr (instrumentation == Instrumentation::TIMING)
+            {
+                stats[current].cycles += readCycleCounter() - last;
+            }
+
+            // exit code is the operand of the EXIT instruction
+            return (Byte) instruction->first;
+
+
+        HANDLER(CMP)
             // set zero flag register to the result of comparison (see x86 asm)
             rZeroFlag = rGeneralA == rGeneralB;
-            break;
+            NEXT();
 
 
-        case OpCode::CMP_REVERSE:
+        HANDLER(CMP_REVERSE)
             // set zero flag register to the result of comparison (see x86 asm)
             rZeroFlag = rGeneralA != rGeneralB;
-            break;
-        
+            NEXT();
+
 
-        case OpCode::ADD:
+        HANDLER(ADD)
             // add value stored in B to A
             rResult = rGeneralA + rGeneralB;
 
@@ -81,378 +480,713 @@ Byte Pvm::execute(const Byte* byteCode)
             // set the zero flag
             rZeroFlag = rResult == 0;
 
-            break;
-        
+            NEXT();
 
-        case OpCode::SUB:
+
+        HANDLER(SUB)
             rResult = rGeneralA - rGeneralB;
 
             rSignFlag = rResult < 0;
 
             rZeroFlag = rResult == 0;
 
-            break;
-        
+            NEXT();
+
 
-        case OpCode::MUL:
+        HANDLER(MUL)
             rResult = rGeneralA * rGeneralB;
 
             rSignFlag = rResult < 0;
 
             rZeroFlag = rResult == 0;
 
-            break;
-        
+            NEXT();
+
+
+        // both would raise SIGFPE instead of an error the host can handle
+        HANDLER(DIV)
+            if (rGeneralB == 0) errors::ZeroDivisionError(rGeneralA);
+            if (rGeneralB == -1 && rGeneralA == LONG_MIN) errors::DivisionOverflowError();
 
-        case OpCode::DIV:
             rResult = rGeneralA / rGeneralB;
 
             rDivisionRemainder = rResult % rGeneralB;
 
             rZeroFlag = rResult == 0;
 
-            break;
-
-        
-        case OpCode::LD_CONST_A_8:
-            rGeneralA = getLongValue(byteCode, offset);
-            break;
-        case OpCode::LD_CONST_A_4:
-            rGeneralA = getIntValue(byteCode, offset);
-            break;
-        case OpCode::LD_CONST_A_1:
-            rGeneralA = getByteValue(byteCode, offset);
-            break;
-        case OpCode::LD_CONST_A_BIT:
-            rGeneralA = (bool) getByteValue(byteCode, offset);
-            break;
-
-
-        case OpCode::LD_CONST_B_8:
-            rGeneralB = getLongValue(byteCode, offset);
-            break;
-        case OpCode::LD_CONST_B_4:
-            rGeneralB = getIntValue(byteCode, offset);
-            break;
-        case OpCode::LD_CONST_B_1:
-            rGeneralB = getByteValue(byteCode, offset);
-            break;
-        case OpCode::LD_CONST_B_BIT:
-            rGeneralB = (bool) getByteValue(byteCode, offset);
-            break;
-
-
-        case OpCode::LD_CONST_RESULT_8:
-            rResult = getLongValue(byteCode, offset);
-            break;
-        case OpCode::LD_CONST_RESULT_4:
-            rResult = getIntValue(byteCode, offset);
-            break;
-        case OpCode::LD_CONST_RESULT_1:
-            rResult = getByteValue(byteCode, offset);
-            break;
-        case OpCode::LD_CONST_RESULT_BIT:
-            rResult = (bool) getByteValue(byteCode, offset);
-            break;
-
-
-        case OpCode::LD_A_8:
-            rGeneralA = memory.getLong(
-                getLongValue(byteCode, offset)
-            );
-            break;
-        case OpCode::LD_A_4:
-            rGeneralA = memory.getInt(
-                getLongValue(byteCode, offset)
-            );
-            break;
-        case OpCode::LD_A_1:
-            rGeneralA = memory.getByte(
-                getLongValue(byteCode, offset)
-            );
-            break;
-        case OpCode::LD_A_BIT:
-            rGeneralA = memory.getBit(
-                getLongValue(byteCode, offset)
-            );
-            break;
-
-
-        case OpCode::LD_B_8:
-            rGeneralB = memory.getLong(
-                    getLongValue(byteCode, offset)
-                );
-                break;
-        case OpCode::LD_B_4:
-            rGeneralB = memory.getInt(
-                    getLongValue(byteCode, offset)
-                );
-                break;
-        case OpCode::LD_B_1:
-            rGeneralB = memory.getByte(
-                    getLongValue(byteCode, offset)
-                );
-                break;
-        case OpCode::LD_B_BIT:
-            rGeneralB = memory.getBit(
-                    getLongValue(byteCode, offset)
-                );
-                break;
-
-
-        case OpCode::LD_RESULT_8:
-            rResult = memory.getLong(
-                getLongValue(byteCode, offset)
-            );
-            break;
-        case OpCode::LD_RESULT_4:
-            rResult = memory.getInt(
-                getLongValue(byteCode, offset)
-            );
-            break;    
-        case OpCode::LD_RESULT_1:
-            rResult = memory.getByte(
-                getLongValue(byteCode, offset)
-            );
-            break;    
-        case OpCode::LD_RESULT_BIT:
-            rResult = memory.getBit(
-                getLongValue(byteCode, offset)
-            );
-            break;       
-
-
-        case OpCode::LD_ZERO_FLAG:
-            rZeroFlag = memory.getBit(
-                getLongValue(byteCode, offset)
-            );
-            break;         
-
-
-        case OpCode::MEM_MOV_8:
-        {
-            const Address addr1 = getLongValue(byteCode, offset);
+            NEXT();
+
+
+        // constants are already converted to their data size by the decoder
+        HANDLER(LD_CONST_A_8)
+        HANDLER(LD_CONST_A_4)
+        HANDLER(LD_CONST_A_1)
+        HANDLER(LD_CONST_A_BIT)
+            rGeneralA = instruction->first;
+            NEXT();
+
+
+        HANDLER(LD_CONST_B_8)
+        HANDLER(LD_CONST_B_4)
+        HANDLER(LD_CONST_B_1)
+        HANDLER(LD_CONST_B_BIT)
+            rGeneralB = instruction->first;
+            NEXT();
+
+
+        HANDLER(LD_CONST_RESULT_8)
+        HANDLER(LD_CONST_RESULT_4)
+        HANDLER(LD_CONST_RESULT_1)
+        HANDLER(LD_CONST_RESULT_BIT)
+            rResult = instruction->first;
+            NEXT();
+
+
+        HANDLER(LD_A_8)
+            rGeneralA = memory.getLong(instruction->first);
+            NEXT();
+        HANDLER(LD_A_4)
+            rGeneralA = memory.getInt(instruction->first);
+            NEXT();
+        HANDLER(LD_A_1)
+            rGeneralA = memory.getByte(instruction->first);
+            NEXT();
+        HANDLER(LD_A_BIT)
+            rGeneralA = memory.getBit(instruction->first);
+            NEXT();
+
+
+        HANDLER(LD_B_8)
+            rGeneralB = memory.getLong(instruction->first);
+            NEXT();
+        HANDLER(LD_B_4)
+            rGeneralB = memory.getInt(instruction->first);
+            NEXT();
+        HANDLER(LD_B_1)
+            rGeneralB = memory.getByte(instruction->first);
+            NEXT();
+        HANDLER(LD_B_BIT)
+            rGeneralB = memory.getBit(instruction->first);
+            NEXT();
+
+
+        HANDLER(LD_RESULT_8)
+            rResult = memory.getLong(instruction->first);
+            NEXT();
+        HANDLER(LD_RESULT_4)
+            rResult = memory.getInt(instruction->first);
+            NEXT();
+        HANDLER(LD_RESULT_1)
+            rResult = memory.getByte(instruction->first);
+            NEXT();
+        HANDLER(LD_RESULT_BIT)
+            rResult = memory.getBit(instruction->first);
+            NEXT();
+
+
+        HANDLER(LD_ZERO_FLAG)
+            rZeroFlag = memory.getBit(instruction->first);
+            NEXT();
+
+
+        HANDLER(MEM_MOV_8)
+            memory.set(instruction->first, memory.getLong(instruction->second));
+            NEXT();
+        HANDLER(MEM_MOV_4)
+            memory.set(instruction->first, memory.getInt(instruction->second));
+            NEXT();
+        HANDLER(MEM_MOV_1)
+            memory.set(instruction->first, memory.getByte(instruction->second));
+            NEXT();
+        HANDLER(MEM_MOV_BIT)
+            memory.set(instruction->first, memory.getBit(instruction->second));
+            NEXT();
+
+
+        HANDLER(REG_MOV_8)
+            memory.set(instruction->first, regs[instruction->reg]);
+            NEXT();
+        HANDLER(REG_MOV_4)
+            memory.set(instruction->first, (int) regs[instruction->reg]);
+            NEXT();
+        HANDLER(REG_MOV_1)
+            memory.set(instruction->first, (Byte) regs[instruction->reg]);
+            NEXT();
+        HANDLER(REG_MOV_BIT)
+            memory.set(instruction->first, (bool) regs[instruction->reg]);
+            NEXT();
+
+
+        HANDLER(REG_TO_REG)
+            // bit registers only ever hold 0 or 1, no conversion is needed
+            regs[instruction->reg] = regs[instruction->reg2];
+            NEXT();
+
+
+        HANDLER(MEM_SET_8)
+            memory.set(instruction->first, instruction->second);
+            NEXT();
+        HANDLER(MEM_SET_4)
+            memory.set(instruction->first, (int) instruction->second);
+            NEXT();
+        HANDLER(MEM_SET_1)
+            memory.set(instruction->first, (Byte) instruction->second);
+            NEXT();
+        HANDLER(MEM_SET_BIT)
+            memory.set(instruction->first, (bool) instruction->second);
+            NEXT();
+
+
+        HANDLER(JMP)
+            // jump targets are instruction indices
+            pc = instruction->first;
+            NEXT();
+
+
+        HANDLER(IF_JUMP)
+            // if zero flag register is set to 1 perform the jump
+            // else pass to the next instruction
+            if (rZeroFlag)
+            {
+                pc = instruction->first;
+            }
+            NEXT();
 
-            const Address addr2 = getLongValue(byteCode, offset);
 
-            memory.set(addr1, memory.getLong(addr2));
+        HANDLER(IF_NOT_JUMP)
+            if (!rZeroFlag)
+            {
+                pc = instruction->first;
+            }
+            NEXT();
 
-            break;
-        }
-        case OpCode::MEM_MOV_4:
-        {
-            const Address addr1 = getLongValue(byteCode, offset);
 
-            const Address addr2 = getLongValue(byteCode, offset);
+        HANDLER(PUSH_CONST)
+            memory.set(rStackPointer, instruction->first);
 
-            memory.set(addr1, memory.getInt(addr2));
+            rStackPointer += sizeof(long);
 
-            break;
-        }
-        case OpCode::MEM_MOV_1:
-        {
-            const Address addr1 = getLongValue(byteCode, offset);
+            NEXT();
 
-            const Address addr2 = getLongValue(byteCode, offset);
 
-            memory.set(addr1, memory.getByte(addr2));
+        HANDLER(PUSH_REG)
+            memory.set(rStackPointer, regs[instruction->reg]);
 
-            break;
-        }
-        case OpCode::MEM_MOV_BIT:
-        {
-            const Address addr1 = getLongValue(byteCode, offset);
+            rStackPointer += sizeof(long);
 
-            const Address addr2 = getLongValue(byteCode, offset);
+            NEXT();
 
-            memory.set(addr1, memory.getBit(addr2));
 
-            break;
-        }
+        // only whole frames are checked, single pushes are caught by the guard pages
+        // a negative stack pointer wraps around and fails the check as well
+        HANDLER(PUSH_BYTES)
+            rStackPointer += instruction->first;
+            if ((size_t) rStackPointer > memorySize) errors::StackOverflowError();
+            NEXT();
 
 
-        case OpCode::REG_MOV_8:
-        {
-            const Address address = getLongValue(byteCode, offset);
+        HANDLER(POP)
+            rStackPointer -= instruction->first;
+            if ((size_t) rStackPointer > memorySize) errors::StackOverflowError();
+            NEXT();
 
-            const Registers reg = (Registers) getByteValue(byteCode, offset);
 
-            memory.set(address, *((long*) getRegister(reg)));
-            
-            break;
-        }
-        case OpCode::REG_MOV_4:
-        {
-            const Address address = getLongValue(byteCode, offset);
+        HANDLER(PRINT)
+            std::cout << rGeneralA;
+            NEXT();
+
+
+        /*
+            fused instructions set every register the replaced sequence would:
+            LD_A, LD_B (or LD_CONST_B), the operation and REG_MOV from RESULT
+            first is the destination address, second and third the operands
+        */
+
+        HANDLER(ADD_MEM_8)
+            rGeneralA = memory.getLong(instruction->second);
+            rGeneralB = memory.getLong(instruction->third);
+            goto add_mem_8;
+        HANDLER(ADD_MEM_CONST_8)
+            rGeneralA = memory.getLong(instruction->second);
+            rGeneralB = instruction->third;
+        add_mem_8:
+            rResult = rGeneralA + rGeneralB;
+            rSignFlag = rResult < 0;
+            rZeroFlag = rResult == 0;
+            memory.set(instruction->first, rResult);
+            NEXT();
+
+        HANDLER(ADD_MEM_4)
+            rGeneralA = memory.getInt(instruction->second);
+            rGeneralB = memory.getInt(instruction->third);
+            goto add_mem_4;
+        HANDLER(ADD_MEM_CONST_4)
+            rGeneralA = memory.getInt(instruction->second);
+            rGeneralB = instruction->third;
+        add_mem_4:
+            rResult = rGeneralA + rGeneralB;
+            rSignFlag = rResult < 0;
+            rZeroFlag = rResult == 0;
+            memory.set(instruction->first, (int) rResult);
+            NEXT();
+
+
+        HANDLER(SUB_MEM_8)
+            rGeneralA = memory.getLong(instruction->second);
+            rGeneralB = memory.getLong(instruction->third);
+            goto sub_mem_8;
+        HANDLER(SUB_MEM_CONST_8)
+            rGeneralA = memory.getLong(instruction->second);
+            rGeneralB = instruction->third;
+        sub_mem_8:
+            rResult = rGeneralA - rGeneralB;
+            rSignFlag = rResult < 0;
+            rZeroFlag = rResult == 0;
+            memory.set(instruction->first, rResult);
+            NEXT();
+
+        HANDLER(SUB_MEM_4)
+            rGeneralA = memory.getInt(instruction->second);
+            rGeneralB = memory.getInt(instruction->third);
+            goto sub_mem_4;
+        HANDLER(SUB_MEM_CONST_4)
+            rGeneralA = memory.getInt(instruction->second);
+            rGeneralB = instruction->third;
+        sub_mem_4:
+            rResult = rGeneralA - rGeneralB;
+            rSignFlag = rResult < 0;
+            rZeroFlag = rResult == 0;
+            memory.set(instruction->first, (int) rResult);
+            NEXT();
+
+
+        HANDLER(MUL_MEM_8)
+            rGeneralA = memory.getLong(instruction->second);
+            rGeneralB = memory.getLong(instruction->third);
+            goto mul_mem_8;
+        HANDLER(MUL_MEM_CONST_8)
+            rGeneralA = memory.getLong(instruction->second);
+            rGeneralB = instruction->third;
+        mul_mem_8:
+            rResult = rGeneralA * rGeneralB;
+            rSignFlag = rResult < 0;
+            rZeroFlag = rResult == 0;
+            memory.set(instruction->first, rResult);
+            NEXT();
+
+        HANDLER(MUL_MEM_4)
+            rGeneralA = memory.getInt(instruction->second);
+            rGeneralB = memory.getInt(instruction->third);
+            goto mul_mem_4;
+        HANDLER(MUL_MEM_CONST_4)
+            rGeneralA = memory.getInt(instruction->second);
+            rGeneralB = instruction->third;
+        mul_mem_4:
+            rResult = rGeneralA * rGeneralB;
+            rSignFlag = rResult < 0;
+            rZeroFlag = rResult == 0;
+            memory.set(instruction->first, (int) rResult);
+            NEXT();
 
-            const Registers reg = (Registers) getByteValue(byteCode, offset);
 
-            memory.set(address, *((int*) getRegister(reg)));
-            
-            break;
-        }
-        case OpCode::REG_MOV_1:
-        {
-            const Address address = getLongValue(byteCode, offset);
+        // first and second are the compared operands
+        HANDLER(CMP_MEM_8)
+            rGeneralA = memory.getLong(instruction->first);
+            rGeneralB = memory.getLong(instruction->second);
+            rZeroFlag = rGeneralA == rGeneralB;
+            NEXT();
+        HANDLER(CMP_MEM_4)
+            rGeneralA = memory.getInt(instruction->first);
+            rGeneralB = memory.getInt(instruction->second);
+            rZeroFlag = rGeneralA == rGeneralB;
+            NEXT();
+        HANDLER(CMP_MEM_CONST_8)
+            rGeneralA = memory.getLong(instruction->first);
+            rGeneralB = instruction->second;
+            rZeroFlag = rGeneralA == rGeneralB;
+            NEXT();
+        HANDLER(CMP_MEM_CONST_4)
+            rGeneralA = memory.getInt(instruction->first);
+            rGeneralB = instruction->second;
+            rZeroFlag = rGeneralA == rGeneralB;
+            NEXT();
 
-            const Registers reg = (Registers) getByteValue(byteCode, offset);
 
-            memory.set(address, *((Byte*) getRegister(reg)));
-            
-            break;
-        }
-        case OpCode::REG_MOV_BIT:
-        {
-            const Address address = getLongValue(byteCode, offset);
+        HANDLER(CMP_REVERSE_MEM_8)
+            rGeneralA = memory.getLong(instruction->first);
+            rGeneralB = memory.getLong(instruction->second);
+            rZeroFlag = rGeneralA != rGeneralB;
+            NEXT();
+        HANDLER(CMP_REVERSE_MEM_4)
+            rGeneralA = memory.getInt(instruction->first);
+            rGeneralB = memory.getInt(instruction->second);
+            rZeroFlag = rGeneralA != rGeneralB;
+            NEXT();
+        HANDLER(CMP_REVERSE_MEM_CONST_8)
+            rGeneralA = memory.getLong(instruction->first);
+            rGeneralB = instruction->second;
+            rZeroFlag = rGeneralA != rGeneralB;
+            NEXT();
+        HANDLER(CMP_REVERSE_MEM_CONST_4)
+            rGeneralA = memory.getInt(instruction->first);
+            rGeneralB = instruction->second;
+            rZeroFlag = rGeneralA != rGeneralB;
+            NEXT();
 
-            const Registers reg = (Registers) getByteValue(byteCode, offset);
 
-            memory.set(address, *((bool*) getRegister(reg)));
-            
-            break;
-        }   
+        // replaces LD_A_BIT, LD_CONST_B_BIT 0, CMP, IF_JUMP
+        HANDLER(IF_NOT_MEM_JUMP)
+            rGeneralA = memory.getBit(instruction->second);
+            rGeneralB = 0;
+            rZeroFlag = !rGeneralA;
+            if (rZeroFlag)
+            {
+                pc = instruction->first;
+            }
+            NEXT();
+
+
+        // register instructions, general registers hold already converted values
+
+        HANDLER(LD_REG_8)
+            regs[instruction->reg] = memory.getLong(instruction->first);
+            NEXT();
+        HANDLER(LD_REG_4)
+            regs[instruction->reg] = memory.getInt(instruction->first);
+            NEXT();
+        HANDLER(LD_REG_1)
+            regs[instruction->reg] = memory.getByte(instruction->first);
+            NEXT();
+        HANDLER(LD_REG_BIT)
+            regs[instruction->reg] = memory.getBit(instruction->first);
+            NEXT();
+
+
+        HANDLER(LD_CONST_REG)
+            regs[instruction->reg] = instruction->first;
+            NEXT();
+
+
+        HANDLER(REG_TO_REG_4)
+            regs[instruction->reg] = (int) regs[instruction->reg2];
+            NEXT();
+        HANDLER(REG_TO_REG_1)
+            regs[instruction->reg] = (Byte) regs[instruction->reg2];
+            NEXT();
+        HANDLER(REG_TO_REG_BIT)
+            regs[instruction->reg] = (bool) regs[instruction->reg2];
+            NEXT();
+
+
+        /*
+            fused register instructions set every register the replaced sequence would:
+            REG_TO_REG into A and B (or LD_CONST_B), the operation and REG_TO_REG from RESULT
+            reg is the destination register, reg2 and reg3 (or first) the operands
+        */
+
+        HANDLER(ADD_REG_8)
+            rGeneralA = regs[instruction->reg2];
+            rGeneralB = regs[instruction->reg3];
+            goto add_reg_8;
+        HANDLER(ADD_REG_CONST_8)
+            rGeneralA = regs[instruction->reg2];
+            rGeneralB = instruction->first;
+        add_reg_8:
+            rResult = rGeneralA + rGeneralB;
+            rSignFlag = rResult < 0;
+            rZeroFlag = rResult == 0;
+            regs[instruction->reg] = rResult;
+            NEXT();
+
+        HANDLER(ADD_REG_4)
+            rGeneralA = regs[instruction->reg2];
+            rGeneralB = regs[instruction->reg3];
+            goto add_reg_4;
+        HANDLER(ADD_REG_CONST_4)
+            rGeneralA = regs[instruction->reg2];
+            rGeneralB = instruction->first;
+        add_reg_4:
+            rResult = rGeneralA + rGeneralB;
+            rSignFlag = rResult < 0;
+            rZeroFlag = rResult == 0;
+            regs[instruction->reg] = (int) rResult;
+            NEXT();
+
+
+        HANDLER(SUB_REG_8)
+            rGeneralA = regs[instruction->reg2];
+            rGeneralB = regs[instruction->reg3];
+            goto sub_reg_8;
+        HANDLER(SUB_REG_CONST_8)
+            rGeneralA = regs[instruction->reg2];
+            rGeneralB = instruction->first;
+        sub_reg_8:
+            rResult = rGeneralA - rGeneralB;
+            rSignFlag = rResult < 0;
+            rZeroFlag = rResult == 0;
+            regs[instruction->reg] = rResult;
+            NEXT();
+
+        HANDLER(SUB_REG_4)
+            rGeneralA = regs[instruction->reg2];
+            rGeneralB = regs[instruction->reg3];
+            goto sub_reg_4;
+        HANDLER(SUB_REG_CONST_4)
+            rGeneralA = regs[instruction->reg2];
+            rGeneralB = instruction->first;
+        sub_reg_4:
+            rResult = rGeneralA - rGeneralB;
+            rSignFlag = rResult < 0;
+            rZeroFlag = rResult == 0;
+            regs[instruction->reg] = (int) rResult;
+            NEXT();
+
+
+        HANDLER(MUL_REG_8)
+            rGeneralA = regs[instruction->reg2];
+            rGeneralB = regs[instruction->reg3];
+            goto mul_reg_8;
+        HANDLER(MUL_REG_CONST_8)
+            rGeneralA = regs[instruction->reg2];
+            rGeneralB = instruction->first;
+        mul_reg_8:
+            rResult = rGeneralA * rGeneralB;
+            rSignFlag = rResult < 0;
+            rZeroFlag = rResult == 0;
+            regs[instruction->reg] = rResult;
+            NEXT();
+
+        HANDLER(MUL_REG_4)
+            rGeneralA = regs[instruction->reg2];
+            rGeneralB = regs[instruction->reg3];
+            goto mul_reg_4;
+        HANDLER(MUL_REG_CONST_4)
+            rGeneralA = regs[instruction->reg2];
+            rGeneralB = instruction->first;
+        mul_reg_4:
+            rResult = rGeneralA * rGeneralB;
+            rSignFlag = rResult < 0;
+            rZeroFlag = rResult == 0;
+            regs[instruction->reg] = (int) rResult;
+            NEXT();
 
 
-        case OpCode::REG_TO_REG:
-        {
-            const Registers regDest = (Registers) getByteValue(byteCode, offset);
+        // reg is compared with reg2 or with the constant in first
+        HANDLER(CMP_REG)
+            rGeneralA = regs[instruction->reg];
+            rGeneralB = regs[instruction->reg2];
+            rZeroFlag = rGeneralA == rGeneralB;
+            NEXT();
+        HANDLER(CMP_REG_CONST)
+            rGeneralA = regs[instruction->reg];
+            rGeneralB = instruction->first;
+            rZeroFlag = rGeneralA == rGeneralB;
+            NEXT();
+        HANDLER(CMP_REVERSE_REG)
+            rGeneralA = regs[instruction->reg];
+            rGeneralB = regs[instruction->reg2];
+            rZeroFlag = rGeneralA != rGeneralB;
+            NEXT();
+        HANDLER(CMP_REVERSE_REG_CONST)
+            rGeneralA = regs[instruction->reg];
+            rGeneralB = instruction->first;
+            rZeroFlag = rGeneralA != rGeneralB;
+            NEXT();
 
-            const Registers regSrc = (Registers) getByteValue(byteCode, offset);
 
-            if (isBitRegister(regSrc))
-            {
-                *(long*) getRegister(regDest) = *(bool*) getRegister(regSrc);
-            }
-            else
+        // replaces REG_TO_REG A, LD_CONST_B_BIT 0, CMP, IF_JUMP
+        HANDLER(IF_NOT_REG_JUMP)
+            rGeneralA = regs[instruction->reg];
+            rGeneralB = 0;
+            rZeroFlag = !rGeneralA;
+            if (rZeroFlag)
             {
-                *(long*) getRegister(regDest) = *(long*) getRegister(regSrc);
+                pc = instruction->first;
             }
+            NEXT();
 
-            break;
-        }
 
+        // instructions without an effect on the machine state
+        HANDLER(CALL)
+        HANDLER(NO_OP)
+            NEXT();
 
-        case OpCode::MEM_SET_8:
-        {
-            const Address address = getLongValue(byteCode, offset);
 
-            const long value = getLongValue(byteCode, offset);
+        } // switch (instruction->opCode)
 
-            memory.set(address, value);
+    } // while (true)
 
-            break;
-        }
-        case OpCode::MEM_SET_4:
-        {
-            const Address address = getLongValue(byteCode, offset);
+}
 
-            const int value = getIntValue(byteCode, offset);
 
-            memory.set(address, value);
+#undef HANDLER
+#undef NEXT
+#undef INSTRUMENT
 
-            break;
-        }
-        case OpCode::MEM_SET_1:
-        {
-            const Address address = getLongValue(byteCode, offset);
 
-            const Byte value = getByteValue(byteCode, offset);
+template <typename Run>
+Byte Pvm::trapOverflows(Run run)
+{
+    Memory::Trap trap;
+
+    // a fault on a guard page jumps back here, out of the run
+    // the mask is left alone, see Memory::onSegmentationFault()
+    if (sigsetjmp(trap.context, 0) != 0)
+    {
+        Memory::disarm(trap);
+        errors::StackOverflowError();
+    }
 
-            memory.set(address, value);
+    memory.arm(trap);
 
-            break;
-        }
-        case OpCode::MEM_SET_BIT:
-        {
-            const Address address = getLongValue(byteCode, offset);
+    try
+    {
+        const Byte exitCode = run();
+        Memory::disarm(trap);
 
-            const bool value = (bool) getByteValue(byteCode, offset);
+        return exitCode;
+    }
+    catch (...)
+    {
+        // errors are thrown instead of ending the process while they're captured
+        Memory::disarm(trap);
+        throw;
+    }
+}
 
-            memory.set(address, value);
 
-            break;
-        }
+Byte Pvm::execute(const ByteCode& byteCode, Engine engine)
+{
+    return execute(decode(byteCode), engine);
+}
 
 
-        case OpCode::JMP:
-            // set offset to the instruction to jump to
-            offset = *((long*) (byteCode + offset));
-            break;
+// rejects programs whose static addresses don't fit in the memory
+// this is what allows memory accesses to go unchecked
+static void checkMemory(const std::vector<Instruction>& program, const Memory& memory)
+{
+    const size_t required = requiredMemory(program);
 
+    if (required > memory.getSize())
+    {
+        errors::InsufficientMemoryError(required, memory.getSize());
+    }
+}
 
-        case OpCode::IF_JUMP:
-            // if zero flag register is set to 1 perform the jump
-            // by updating the offset from the byteCode*
-            if (rZeroFlag)
-            {
-                offset = *((long*) (byteCode + offset));
-                break;
-            }
 
-            // else pass to the next instruction
+Byte Pvm::execute(const std::vector<Instruction>& program, Engine engine)
+{
+    checkMemory(program, memory);
 
-            offset += sizeof(long);
+    return trapOverflows([&]()
+    {
+        return engine == Engine::THREADED
+            ? run<true, Instrumentation::NONE>(program)
+            : run<false, Instrumentation::NONE>(program);
+    });
+}
 
-            break;
-        
-        
-        case OpCode::IF_NOT_JUMP:
-            if (!rZeroFlag)
-            {
-                offset = *((long*) (byteCode + offset));
-                break;
-            }
 
-            offset += sizeof(long);
+Byte Pvm::executeNative(const std::vector<Instruction>& program)
+{
+    const jit::NativeProgram native = jit::NativeProgram(program);
 
-            break;
-            
+    if (!native.isSupported())
+    {
+        return execute(program);
+    }
 
-        case OpCode::PUSH_CONST:
-            memory.set(
-                rStackPointer,
-                getLongValue(byteCode, offset)
-            );
+    checkMemory(program, memory);
 
-            rStackPointer += sizeof(long);
+    jit::Context context = { memory.getBase(), memory.getSize(), rStackPointer, {} };
+    memcpy(context.registers, registers, sizeof(registers));
 
-            break;
+    const Byte exitCode = trapOverflows([&]()
+    {
+        return native.run(context);
+    });
 
+    memcpy(registers, context.registers, sizeof(registers));
+    rStackPointer = context.stackPointer;
 
-        case OpCode::PUSH_REG:
-        {
-            const long value = *(long*) getRegister(
-                (Registers) getByteValue(byteCode, offset)
-            );
+    return exitCode;
+}
 
-            memory.set(rStackPointer, value);
 
-            rStackPointer += sizeof(long);
+Byte Pvm::executeCounting(const std::vector<Instruction>& program, Engine engine)
+{
+    checkMemory(program, memory);
 
-            break;
-        }
+    return trapOverflows([&]()
+    {
+        return engine == Engine::THREADED
+            ? run<true, Instrumentation::COUNTING>(program)
+            : run<false, Instrumentation::COUNTING>(program);
+    });
+}
 
 
-        case OpCode::PUSH_BYTES:
-            rStackPointer += getLongValue(byteCode, offset);
-            break;
+size_t Pvm::getInstructionCount() const
+{
+    return instructionCount;
+}
 
 
-        case OpCode::POP:
-            rStackPointer -= getLongValue(byteCode, offset);
-            break;
+Byte Pvm::executeProfiling(const std::vector<Instruction>& program, Engine engine)
+{
+    checkMemory(program, memory);
 
+    profile.assign(program.size(), InstructionProfile { 0, 0 });
 
-        case OpCode::PRINT:
-            std::cout << rGeneralA;
-            break;
+    return trapOverflows([&]()
+    {
+        return engine == Engine::THREADED
+            ? run<true, Instrumentation::TIMING>(program)
+            : run<false, Instrumentation::TIMING>(program);
+    });
+}
+
+
+const std::vector<InstructionProfile>& Pvm::getProfile() const
+{
+    return profile;
+}
 
 
-        } // switch ((OpCode) byte)
+Byte Pvm::executeSampling(const std::vector<Instruction>& program, Engine engine, unsigned int interval)
+{
+    checkMemory(program, memory);
 
-    } // while (executing)
+    samples.assign(program.size(), 0);
 
+    // stopped when the run ends, even if it ends with an error
+    const SamplingTimer timer(samples.data(), interval);
 
-    return exitCode;
+    return trapOverflows([&]()
+    {
+        return engine == Engine::THREADED
+            ? run<true, Instrumentation::SAMPLING>(program)
+            : run<false, Instrumentation::SAMPLING>(program);
+    });
+}
+
+
+const std::vector<size_t>& Pvm::getSamples() const
+{
+    return samples;
+}
+
+
+// lookup table for Engine string representation
+static const char* const engineRepr[] =
+{
+    "switch",
+    "threaded",
+};
+
+
+const char* pvm::engineName(Engine engine)
+{
+    return engineRepr[(unsigned char) engine];
 }
 
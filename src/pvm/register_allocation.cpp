@@ -0,0 +1,851 @@
+#include "pvm.hh"
+
+#include <algorithm>
+
+
+using namespace pvm;
+
+
+static inline long getLong(const Byte* bytes)
+{
+    return *((long*) bytes);
+}
+
+
+static inline int getInt(const Byte* bytes)
+{
+    return *((int*) bytes);
+}
+
+
+// the ways a memory address can be accessed
+// values must be constant for lookup tables
+typedef enum class Width
+{
+    LONG,
+    INT,
+    BYTE,
+    BIT,
+
+} Width;
+
+
+// number of bytes each Width spans in memory, indexed by Width
+static const size_t widthSizes[] = { 8, 4, 1, 1 };
+
+
+// OpCodes of the register instructions, indexed by Width
+
+static const OpCode loadRegister[] =
+{
+    OpCode::LD_REG_8, OpCode::LD_REG_4, OpCode::LD_REG_1, OpCode::LD_REG_BIT,
+};
+
+static const OpCode copyRegister[] =
+{
+    OpCode::REG_TO_REG, OpCode::REG_TO_REG_4, OpCode::REG_TO_REG_1, OpCode::REG_TO_REG_BIT,
+};
+
+static const OpCode storeRegister[] =
+{
+    OpCode::REG_MOV_8, OpCode::REG_MOV_4, OpCode::REG_MOV_1, OpCode::REG_MOV_BIT,
+};
+
+
+// a static memory access of an instruction
+typedef struct Access
+{
+    Address address;
+    Width width;
+    bool isWrite;
+
+} Access;
+
+
+// the memory accesses of an instruction
+typedef struct Accesses
+{
+    Access list[3];
+    unsigned char count;
+
+    // whether the instruction can be rewritten to use registers instead
+    bool isRewritable;
+
+    void add(const Byte* address, Width width, bool isWrite)
+    {
+        list[count ++] = { (Address) getLong(address), width, isWrite };
+    }
+
+} Accesses;
+
+
+// Width of the memory operands of an OpCode, for OpCodes that access memory
+static Width widthOf(OpCode opCode)
+{
+    switch (opCode)
+    {
+    case OpCode::LD_A_8:
+    case OpCode::LD_B_8:
+    case OpCode::LD_RESULT_8:
+    case OpCode::MEM_MOV_8:
+    case OpCode::REG_MOV_8:
+    case OpCode::MEM_SET_8:
+    case OpCode::LD_REG_8:
+    case OpCode::ADD_MEM_8:
+    case OpCode::ADD_MEM_CONST_8:
+    case OpCode::SUB_MEM_8:
+    case OpCode::SUB_MEM_CONST_8:
+    case OpCode::MUL_MEM_8:
+    case OpCode::MUL_MEM_CONST_8:
+    case OpCode::CMP_MEM_8:
+    case OpCode::CMP_MEM_CONST_8:
+    case OpCode::CMP_REVERSE_MEM_8:
+    case OpCode::CMP_REVERSE_MEM_CONST_8:
+        return Width::LONG;
+
+    case OpCode::LD_A_4:
+    case OpCode::LD_B_4:
+    case OpCode::LD_RESULT_4:
+    case OpCode::MEM_MOV_4:
+    case OpCode::REG_MOV_4:
+    case OpCode::MEM_SET_4:
+    case OpCode::LD_REG_4:
+    case OpCode::ADD_MEM_4:
+    case OpCode::ADD_MEM_CONST_4:
+    case OpCode::SUB_MEM_4:
+    case OpCode::SUB_MEM_CONST_4:
+    case OpCode::MUL_MEM_4:
+    case OpCode::MUL_MEM_CONST_4:
+    case OpCode::CMP_MEM_4:
+    case OpCode::CMP_MEM_CONST_4:
+    case OpCode::CMP_REVERSE_MEM_4:
+    case OpCode::CMP_REVERSE_MEM_CONST_4:
+        return Width::INT;
+
+    case OpCode::LD_A_1:
+    case OpCode::LD_B_1:
+    case OpCode::LD_RESULT_1:
+    case OpCode::MEM_MOV_1:
+    case OpCode::REG_MOV_1:
+    case OpCode::MEM_SET_1:
+    case OpCode::LD_REG_1:
+        return Width::BYTE;
+
+    default:
+        return Width::BIT;
+    }
+}
+
+
+// collects the memory accesses of an instruction
+// returns false if the instruction accesses memory through the stack pointer,
+// whose addresses aren't known before running the program
+static bool accessesOf(const ListInstruction& instruction, Accesses& accesses)
+{
+    const OpCode opCode = instruction.opCode();
+    const Byte* operands = instruction.operands();
+    const Width width = widthOf(opCode);
+
+    accesses.count = 0;
+    accesses.isRewritable = false;
+
+    switch (opCode)
+    {
+    case OpCode::PUSH_CONST:
+    case OpCode::PUSH_REG:
+        return false;
+
+    case OpCode::LD_A_8:
+    case OpCode::LD_A_4:
+    case OpCode::LD_A_1:
+    case OpCode::LD_A_BIT:
+    case OpCode::LD_B_8:
+    case OpCode::LD_B_4:
+    case OpCode::LD_B_1:
+    case OpCode::LD_B_BIT:
+    case OpCode::LD_RESULT_8:
+    case OpCode::LD_RESULT_4:
+    case OpCode::LD_RESULT_1:
+    case OpCode::LD_RESULT_BIT:
+    case OpCode::LD_ZERO_FLAG:
+        accesses.add(operands, width, false);
+        accesses.isRewritable = true;
+        break;
+
+    case OpCode::MEM_MOV_8:
+    case OpCode::MEM_MOV_4:
+    case OpCode::MEM_MOV_1:
+    case OpCode::MEM_MOV_BIT:
+        accesses.add(operands, width, true);
+        accesses.add(operands + sizeof(long), width, false);
+        accesses.isRewritable = true;
+        break;
+
+    case OpCode::REG_MOV_8:
+    case OpCode::REG_MOV_4:
+    case OpCode::REG_MOV_1:
+    case OpCode::REG_MOV_BIT:
+    case OpCode::MEM_SET_8:
+    case OpCode::MEM_SET_4:
+    case OpCode::MEM_SET_1:
+    case OpCode::MEM_SET_BIT:
+        accesses.add(operands, width, true);
+        accesses.isRewritable = true;
+        break;
+
+    // already allocated or fused instructions are left as they are
+    case OpCode::LD_REG_8:
+    case OpCode::LD_REG_4:
+    case OpCode::LD_REG_1:
+    case OpCode::LD_REG_BIT:
+        accesses.add(operands + 1, width, false);
+        break;
+
+    case OpCode::ADD_MEM_8:
+    case OpCode::ADD_MEM_4:
+    case OpCode::SUB_MEM_8:
+    case OpCode::SUB_MEM_4:
+    case OpCode::MUL_MEM_8:
+    case OpCode::MUL_MEM_4:
+        accesses.add(operands + 2 * sizeof(long), width, false);
+        // fall through
+    case OpCode::ADD_MEM_CONST_8:
+    case OpCode::ADD_MEM_CONST_4:
+    case OpCode::SUB_MEM_CONST_8:
+    case OpCode::SUB_MEM_CONST_4:
+    case OpCode::MUL_MEM_CONST_8:
+    case OpCode::MUL_MEM_CONST_4:
+        accesses.add(operands, width, true);
+        accesses.add(operands + sizeof(long), width, false);
+        break;
+
+    case OpCode::CMP_MEM_8:
+    case OpCode::CMP_MEM_4:
+    case OpCode::CMP_REVERSE_MEM_8:
+    case OpCode::CMP_REVERSE_MEM_4:
+        accesses.add(operands + sizeof(long), width, false);
+        // fall through
+    case OpCode::CMP_MEM_CONST_8:
+    case OpCode::CMP_MEM_CONST_4:
+    case OpCode::CMP_REVERSE_MEM_CONST_8:
+    case OpCode::CMP_REVERSE_MEM_CONST_4:
+        accesses.add(operands, width, false);
+        break;
+
+    case OpCode::IF_NOT_MEM_JUMP:
+        accesses.add(operands, Width::BIT, false);
+        break;
+    }
+
+    return true;
+}
+
+
+// register loaded by a memory load instruction
+static Registers loadedRegisterOf(OpCode opCode)
+{
+    switch (opCode)
+    {
+    case OpCode::LD_A_8:
+    case OpCode::LD_A_4:
+    case OpCode::LD_A_1:
+    case OpCode::LD_A_BIT:
+        return Registers::GENERAL_A;
+
+    case OpCode::LD_B_8:
+    case OpCode::LD_B_4:
+    case OpCode::LD_B_1:
+    case OpCode::LD_B_BIT:
+        return Registers::GENERAL_B;
+
+    case OpCode::LD_RESULT_8:
+    case OpCode::LD_RESULT_4:
+    case OpCode::LD_RESULT_1:
+    case OpCode::LD_RESULT_BIT:
+        return Registers::RESULT;
+
+    default:
+        return Registers::ZERO_FLAG;
+    }
+}
+
+
+// offset of the jump target of a jump instruction
+static size_t jumpTargetOf(const ListInstruction& instruction)
+{
+    switch (instruction.opCode())
+    {
+    case OpCode::IF_NOT_MEM_JUMP:
+        return getLong(instruction.operands() + sizeof(long));
+    case OpCode::IF_NOT_REG_JUMP:
+        return getLong(instruction.operands() + 1);
+    default:
+        return getLong(instruction.operands());
+    }
+}
+
+
+// marks offsets that are not the beginning of an instruction
+#define NOT_AN_INSTRUCTION ((size_t) -1)
+
+
+// marks variables that can't be assigned a register
+#define NO_REGISTER ((unsigned char) -1)
+
+
+// a memory address that may be kept in a register
+typedef struct Variable
+{
+    Address address;
+    Width width;
+
+    // whether every access to the variable can be rewritten
+    bool isCandidate;
+
+    // range of instruction indices the variable is live in
+    size_t start;
+    size_t end;
+
+    unsigned char reg;
+
+} Variable;
+
+
+// set of variables, one bit per variable
+typedef std::vector<unsigned long> VariableSet;
+
+#define SET_WORD_BITS (sizeof(unsigned long) * 8)
+
+
+static inline bool contains(const VariableSet& set, size_t variable)
+{
+    return set[variable / SET_WORD_BITS] >> (variable % SET_WORD_BITS) & 1;
+}
+
+
+static inline void insert(VariableSet& set, size_t variable)
+{
+    set[variable / SET_WORD_BITS] |= 1ul << (variable % SET_WORD_BITS);
+}
+
+
+/*
+    Linear scan register allocation over the static addresses of the program.
+
+    Every address accessed with a single width and not overlapping any other
+    address is a variable. Liveness is computed on the control flow graph, so
+    the live range of a variable is the smallest range of instructions it's
+    live in, loops included. Live ranges are then assigned the general purpose
+    registers in order of their start, the ranges that end last giving up their
+    register when they run out.
+    Accesses to the allocated variables are rewritten to the register
+    instructions, which fuseInstructions() then turns into register arithmetic.
+    The memory is kept up to date for whoever reads it after the program exits:
+    writes outside loops are stored right away, while the variables written in
+    a loop are stored once, before the instruction the loop exits to.
+*/
+void ByteList::allocateRegisters()
+{
+    std::vector<ListInstruction> instructions;
+
+    if (!splitInstructions(instructions) || instructions.empty())
+    {
+        return;
+    }
+
+    const size_t count = instructions.size();
+
+    std::vector<Accesses> accesses(count);
+
+    // variable index of every accessed address
+    std::unordered_map<Address, size_t> variableOf;
+    std::vector<Variable> variables;
+
+    for (size_t i = 0; i != count; i++)
+    {
+        if (!accessesOf(instructions[i], accesses[i]))
+        {
+            return;
+        }
+
+        for (unsigned char a = 0; a != accesses[i].count; a++)
+        {
+            const Access& access = accesses[i].list[a];
+
+            const auto inserted = variableOf.emplace(access.address, variables.size());
+
+            if (inserted.second)
+            {
+                variables.push_back({ access.address, access.width, true, count, 0, NO_REGISTER });
+            }
+
+            Variable& variable = variables[inserted.first->second];
+
+            if (variable.width != access.width || !accesses[i].isRewritable)
+            {
+                variable.isCandidate = false;
+            }
+        }
+    }
+
+    // variables overlapping other ones must stay in memory
+    std::unordered_map<Address, size_t> ownerOf;
+    for (size_t v = 0; v != variables.size(); v++)
+    {
+        for (size_t b = 0; b != widthSizes[(unsigned char) variables[v].width]; b++)
+        {
+            const auto inserted = ownerOf.emplace(variables[v].address + b, v);
+
+            if (!inserted.second)
+            {
+                variables[v].isCandidate = false;
+                variables[inserted.first->second].isCandidate = false;
+            }
+        }
+    }
+
+    // maps instruction offsets to indices, the extra slot is past the last instruction
+    const ListInstruction& last = instructions.back();
+    const size_t size = last.offset + instructionSize(last.opCode());
+
+    std::vector<size_t> indexOf(size + 1, NOT_AN_INSTRUCTION);
+    for (size_t i = 0; i != count; i++)
+    {
+        indexOf[instructions[i].offset] = i;
+    }
+    indexOf[size] = count;
+
+    // instruction index every jump goes to, jumps that can't be followed leave the list as it is
+    std::vector<size_t> targetOf(count, count);
+    for (size_t i = 0; i != count; i++)
+    {
+        if (!isJump(instructions[i].opCode()))
+        {
+            continue;
+        }
+
+        const size_t target = jumpTargetOf(instructions[i]);
+
+        if (target > size || indexOf[target] == NOT_AN_INSTRUCTION)
+        {
+            return;
+        }
+
+        targetOf[i] = indexOf[target];
+    }
+
+    // a loop spans a backward jump target and the last jump back there
+    std::vector<size_t> loopEndOf(count, count);
+    for (size_t i = 0; i != count; i++)
+    {
+        if (targetOf[i] <= i)
+        {
+            loopEndOf[targetOf[i]] = i;
+        }
+    }
+
+    const size_t words = (variables.size() + SET_WORD_BITS - 1) / SET_WORD_BITS;
+
+    // variables written in a loop, stored before the instruction following it
+    std::unordered_map<size_t, VariableSet> storedBefore;
+    std::vector<bool> isInLoop(count, false);
+
+    for (size_t start = 0; start != count; start++)
+    {
+        const size_t end = loopEndOf[start];
+
+        if (end == count)
+        {
+            continue;
+        }
+
+        // the stores are only reached if every way out of the loop goes past its end
+        if (end + 1 == count)
+        {
+            return;
+        }
+
+        VariableSet& written = storedBefore.emplace(end + 1, VariableSet(words, 0)).first->second;
+
+        for (size_t i = start; i <= end; i++)
+        {
+            const OpCode opCode = instructions[i].opCode();
+
+            // jumps may only go within the loop or to the instruction following it
+            const bool leaves = isJump(opCode) && (targetOf[i] < start || targetOf[i] > end + 1);
+
+            if (opCode == OpCode::EXIT || leaves)
+            {
+                return;
+            }
+
+            isInLoop[i] = true;
+
+            for (unsigned char a = 0; a != accesses[i].count; a++)
+            {
+                if (accesses[i].list[a].isWrite)
+                {
+                    insert(written, variableOf[accesses[i].list[a].address]);
+                }
+            }
+        }
+    }
+
+    // variables live at the beginning of every instruction, computed backwards
+    // until nothing changes, so that values flowing around loops are accounted for
+    std::vector<VariableSet> liveIn(count, VariableSet(words, 0));
+
+    VariableSet live(words);
+
+    for (bool changed = true; changed; )
+    {
+        changed = false;
+
+        for (size_t i = count; i-- != 0; )
+        {
+            const OpCode opCode = instructions[i].opCode();
+
+            std::fill(live.begin(), live.end(), 0);
+
+            if (opCode != OpCode::JMP && opCode != OpCode::EXIT && i + 1 != count)
+            {
+                live = liveIn[i + 1];
+            }
+
+            if (targetOf[i] != count)
+            {
+                for (size_t w = 0; w != words; w++)
+                {
+                    live[w] |= liveIn[targetOf[i]][w];
+                }
+            }
+
+            // writes kill the variable, then reads make it live
+            for (unsigned char a = 0; a != accesses[i].count; a++)
+            {
+                const size_t variable = variableOf[accesses[i].list[a].address];
+
+                if (accesses[i].list[a].isWrite)
+                {
+                    live[variable / SET_WORD_BITS] &= ~(1ul << (variable % SET_WORD_BITS));
+                }
+            }
+
+            for (unsigned char a = 0; a != accesses[i].count; a++)
+            {
+                if (!accesses[i].list[a].isWrite)
+                {
+                    insert(live, variableOf[accesses[i].list[a].address]);
+                }
+            }
+
+            // the stores at the exit of a loop read what the loop wrote
+            const auto stored = storedBefore.find(i);
+
+            if (stored != storedBefore.end())
+            {
+                for (size_t w = 0; w != words; w++)
+                {
+                    live[w] |= stored->second[w];
+                }
+            }
+
+            if (live != liveIn[i])
+            {
+                liveIn[i].swap(live);
+                changed = true;
+            }
+        }
+    }
+
+    // live ranges, accesses to dead variables included
+    for (size_t i = 0; i != count; i++)
+    {
+        for (size_t v = 0; v != variables.size(); v++)
+        {
+            if (contains(liveIn[i], v))
+            {
+                variables[v].start = std::min(variables[v].start, i);
+                variables[v].end = i;
+            }
+        }
+
+        for (unsigned char a = 0; a != accesses[i].count; a++)
+        {
+            Variable& variable = variables[variableOf[accesses[i].list[a].address]];
+
+            variable.start = std::min(variable.start, i);
+            variable.end = std::max(variable.end, i);
+        }
+    }
+
+    // variables live at the beginning of the program are loaded into their
+    // registers before it, which can't be done if the program loops back there
+    std::vector<size_t> liveAtEntry;
+    for (size_t v = 0; v != variables.size(); v++)
+    {
+        if (contains(liveIn[0], v))
+        {
+            if (instructions[0].isJumpTarget)
+            {
+                variables[v].isCandidate = false;
+            }
+            else
+            {
+                liveAtEntry.push_back(v);
+            }
+        }
+    }
+
+    // linear scan
+    std::vector<size_t> ranges;
+    for (size_t v = 0; v != variables.size(); v++)
+    {
+        if (variables[v].isCandidate)
+        {
+            ranges.push_back(v);
+        }
+    }
+
+    if (ranges.empty())
+    {
+        return;
+    }
+
+    std::sort(ranges.begin(), ranges.end(), [&variables](size_t a, size_t b) {
+        return variables[a].start < variables[b].start;
+    });
+
+    std::vector<unsigned char> freeRegisters;
+    for (unsigned char r = GENERAL_REGISTER_COUNT; r != 0; r--)
+    {
+        freeRegisters.push_back((unsigned char) Registers::R0 + r - 1);
+    }
+
+    // variables holding a register
+    std::vector<size_t> active;
+
+    for (size_t v : ranges)
+    {
+        Variable& variable = variables[v];
+
+        // release the registers of the ranges that ended
+        for (size_t a = 0; a != active.size(); )
+        {
+            if (variables[active[a]].end < variable.start)
+            {
+                freeRegisters.push_back(variables[active[a]].reg);
+                active[a] = active.back();
+                active.pop_back();
+            }
+            else
+            {
+                a ++;
+            }
+        }
+
+        if (!freeRegisters.empty())
+        {
+            variable.reg = freeRegisters.back();
+            freeRegisters.pop_back();
+            active.push_back(v);
+            continue;
+        }
+
+        // the range ending last stays in memory
+        size_t furthest = 0;
+        for (size_t a = 1; a != active.size(); a++)
+        {
+            if (variables[active[a]].end > variables[active[furthest]].end)
+            {
+                furthest = a;
+            }
+        }
+
+        Variable& spilled = variables[active[furthest]];
+
+        if (spilled.end > variable.end)
+        {
+            variable.reg = spilled.reg;
+            spilled.reg = NO_REGISTER;
+            active[furthest] = v;
+        }
+    }
+
+    // register of the variable at the given address, NO_REGISTER if it's in memory
+    const auto registerOf = [&variables, &variableOf](const Byte* address) {
+        return variables[variableOf[(Address) getLong(address)]].reg;
+    };
+
+    // writes outside loops keep the memory up to date as they happen
+    const auto storeOutsideLoops = [&isInLoop](size_t i, const Byte* address, unsigned char reg, unsigned char width, ByteList& output) {
+        if (!isInLoop[i])
+        {
+            output.add(storeRegister[width]);
+            output.add(getLong(address), sizeof(long));
+            output.add((Registers) reg);
+        }
+    };
+
+    rewrite(instructions, [&](const std::vector<ListInstruction>& instructions, size_t i, ByteList& output) -> size_t {
+
+        // jumps out of a loop land on its stores, which come before the instruction
+        const auto stored = storedBefore.find(i);
+
+        if (stored != storedBefore.end())
+        {
+            for (size_t v = 0; v != variables.size(); v++)
+            {
+                if (contains(stored->second, v) && variables[v].reg != NO_REGISTER)
+                {
+                    output.add(storeRegister[(unsigned char) variables[v].width]);
+                    output.add((Value) variables[v].address, sizeof(long));
+                    output.add((Registers) variables[v].reg);
+                }
+            }
+        }
+
+        if (i == 0)
+        {
+            for (size_t v : liveAtEntry)
+            {
+                if (variables[v].reg != NO_REGISTER)
+                {
+                    output.add(loadRegister[(unsigned char) variables[v].width]);
+                    output.add((Registers) variables[v].reg);
+                    output.add((Value) variables[v].address, sizeof(long));
+                }
+            }
+        }
+
+        if (!accesses[i].isRewritable)
+        {
+            return 0;
+        }
+
+        const ListInstruction& instruction = instructions[i];
+        const OpCode opCode = instruction.opCode();
+        const Byte* operands = instruction.operands();
+        const unsigned char width = (unsigned char) widthOf(opCode);
+
+        const unsigned char reg = registerOf(operands);
+
+        switch (opCode)
+        {
+        case OpCode::LD_A_8:
+        case OpCode::LD_A_4:
+        case OpCode::LD_A_1:
+        case OpCode::LD_A_BIT:
+        case OpCode::LD_B_8:
+        case OpCode::LD_B_4:
+        case OpCode::LD_B_1:
+        case OpCode::LD_B_BIT:
+        case OpCode::LD_RESULT_8:
+        case OpCode::LD_RESULT_4:
+        case OpCode::LD_RESULT_1:
+        case OpCode::LD_RESULT_BIT:
+        case OpCode::LD_ZERO_FLAG:
+        {
+            if (reg == NO_REGISTER)
+            {
+                return 0;
+            }
+
+            // registers hold values already converted, a plain copy is enough
+            output.add(OpCode::REG_TO_REG);
+            output.add(loadedRegisterOf(opCode));
+            output.add((Registers) reg);
+            return 1;
+        }
+
+        case OpCode::REG_MOV_8:
+        case OpCode::REG_MOV_4:
+        case OpCode::REG_MOV_1:
+        case OpCode::REG_MOV_BIT:
+            if (reg == NO_REGISTER)
+            {
+                return 0;
+            }
+
+            output.add(copyRegister[width]);
+            output.add((Registers) reg);
+            output.add((Registers) operands[sizeof(long)]);
+            storeOutsideLoops(i, operands, reg, width, output);
+            return 1;
+
+        case OpCode::MEM_SET_8:
+        case OpCode::MEM_SET_4:
+        case OpCode::MEM_SET_1:
+        case OpCode::MEM_SET_BIT:
+        {
+            if (reg == NO_REGISTER)
+            {
+                return 0;
+            }
+
+            // the constant is converted the way storing it would
+            const Byte* value = operands + sizeof(long);
+            long constant;
+
+            switch ((Width) width)
+            {
+            case Width::LONG:
+                constant = getLong(value);
+                break;
+            case Width::INT:
+                constant = getInt(value);
+                break;
+            case Width::BYTE:
+                constant = *value;
+                break;
+            default:
+                constant = (bool) *value;
+                break;
+            }
+
+            output.add(OpCode::LD_CONST_REG);
+            output.add((Registers) reg);
+            output.add((Value) constant, sizeof(long));
+            storeOutsideLoops(i, operands, reg, width, output);
+            return 1;
+        }
+
+        case OpCode::MEM_MOV_8:
+        case OpCode::MEM_MOV_4:
+        case OpCode::MEM_MOV_1:
+        case OpCode::MEM_MOV_BIT:
+        {
+            const unsigned char source = registerOf(operands + sizeof(long));
+
+            if (reg != NO_REGISTER && source != NO_REGISTER)
+            {
+                output.add(OpCode::REG_TO_REG);
+                output.add((Registers) reg);
+                output.add((Registers) source);
+                storeOutsideLoops(i, operands, reg, width, output);
+            }
+            else if (reg != NO_REGISTER)
+            {
+                output.add(loadRegister[width]);
+                output.add((Registers) reg);
+                output.add(getLong(operands + sizeof(long)), sizeof(long));
+                storeOutsideLoops(i, operands, reg, width, output);
+            }
+            else if (source != NO_REGISTER)
+            {
+                output.add(storeRegister[width]);
+                output.add(getLong(operands), sizeof(long));
+                output.add((Registers) source);
+            }
+            else
+            {
+                return 0;
+            }
+
+            return 1;
+        }
+        }
+
+        return 0;
+    });
+}
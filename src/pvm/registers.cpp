@@ -4,26 +4,15 @@
 using namespace pvm;
 
 
-void* Pvm::getRegister(Registers reg) const
+long& Pvm::getRegister(Registers reg)
 {
-    switch (reg)
-    {
-    case Registers::GENERAL_A:
-        return (void*) &rGeneralA;
-    case Registers::GENERAL_B:
-        return (void*) &rGeneralB;
-    case Registers::DIVISION_REMAINDER:
-        return (void*) &rDivisionRemainder;
-    case Registers::ZERO_FLAG:
-        return (void*) &rZeroFlag;
-    case Registers::SIGN_FLAG:
-        return (void*) &rSignFlag;
-    case Registers::RESULT:
-        return (void*) &rResult;   
-    }
-
-    // this code never gets reached
-    return nullptr;
+    return registers[(unsigned char) reg];
+}
+
+
+long Pvm::getRegisterValue(Registers reg) const
+{
+    return registers[(unsigned char) reg];
 }
 
 
@@ -36,6 +25,8 @@ static const char* const registerRepr[] =
     "RESULT",
     "ZERO FLAG",
     "SIGN FLAG",
+    "R0", "R1", "R2", "R3", "R4", "R5", "R6", "R7",
+    "R8", "R9", "R10", "R11", "R12", "R13", "R14", "R15",
 };
 
 
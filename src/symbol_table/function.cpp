@@ -4,8 +4,8 @@
 using namespace symbol_table;
 
 
-Parameter::Parameter(Symbol&& symbol, std::string&& name)
-: symbol(std::move(symbol)), name(std::move(name))
+Parameter::Parameter(Symbol&& symbol, interner::StringId name)
+: symbol(std::move(symbol)), name(name)
 {
     
 }
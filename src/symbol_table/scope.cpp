@@ -5,30 +5,22 @@ using namespace symbol_table;
 
 
 Scope::Scope()
-: localSymbolsSize(0)
+: local(), outer(nullptr), localSymbolsSize(0)
 {   
     // just create a new local scope
     // without inheriting from outer scopes
-    local = Table();
 }
 
 
-Scope::Scope(const Table& _local, const std::optional<Table>& _outer)
+Scope::Scope(const Scope* outer, size_t stackIndex)
     :   
+    local(),
+    outer(outer),
     localSymbolsSize(0), 
-    stackIndex(SymbolTable::getStackPointer())
+    stackIndex(stackIndex)
 {
-    local = Table();
-
-    // copy previous local scope first
-    // local symbols have precedence over outer ones
-    outer = Table(_local);
-    
-    // check if the given outer scope exists
-    if (_outer.has_value())
-    {
-        outer.value().insert(_outer.value().begin(), _outer.value().end());
-    }
+    // the outer Scope is only referenced, local symbols shadow its ones
+    // since they are searched first
 }
 
 
@@ -5,52 +5,37 @@
 using namespace symbol_table;
 
 
-Scope* SymbolTable::scopeStack = nullptr;
+SymbolTable::SymbolTable(const interner::StringInterner& interner)
+: interner(interner), stackPointer(0), globalScope(nullptr), scopeStack(nullptr)
+{
+
+}
 
-Scope* SymbolTable::globalScope = nullptr;
 
-size_t SymbolTable::stackPointer = 0;
+SymbolTable::~SymbolTable()
+{
+    clear();
+}
 
 
-void SymbolTable::assign(std::string* identifier, Value newValue)
+void SymbolTable::assign(interner::StringId identifier, Value newValue)
 {   
     // size compatibility is guaranteed by the tree building phase
 
-    // search in local scope first    
-    if (scopeStack->local.find(*identifier) != scopeStack->local.end())
-    {
-        scopeStack->local[*identifier]->value = newValue;
-        return;
-    }
-
-    if (scopeStack->outer.has_value()
-        && scopeStack->outer.value().find(*identifier) != scopeStack->outer.value().end())
-    {
-        scopeStack->outer.value()[*identifier]->value = newValue;
-        return;
-    }
-
-    if (globalScope->local.find(*identifier) != globalScope->local.end())
-    {
-        globalScope->local[*identifier]->value = newValue;
-        return;
-    }
-
-    // if symbol has not been found, it wasn't declared in 
-    // any reachable scope, thus throw exception
-    errors::UndefinedSymbolError(*identifier);
+    // symbols are searched in the same order as get() does
+    get(identifier)->value = newValue;
 }
 
 
-void SymbolTable::declare(std::string* identifier, Symbol* symbol)
+void SymbolTable::declare(interner::StringId identifier, Symbol* symbol)
 {
     // check if token was already declared in local scope
-    if (scopeStack->local.find(*identifier) != scopeStack->local.end())
+    if (scopeStack->local.find(identifier) != scopeStack->local.end())
     {
-        errors::SymbolRedeclarationError(*identifier, *symbol);
+        errors::SymbolRedeclarationError(interner.get(identifier), *symbol);
     }
 
-    scopeStack->local.emplace(std::make_pair(*identifier, symbol));
+    scopeStack->local.emplace(std::make_pair(identifier, symbol));
 
     symbol->stackPosition = stackPointer;
     
@@ -60,42 +45,39 @@ void SymbolTable::declare(std::string* identifier, Symbol* symbol)
 }
 
 
-Symbol* SymbolTable::get(std::string* identifier)
+Symbol* SymbolTable::get(interner::StringId identifier) const
 {
-    // check in local scope first
-    Table::const_iterator iterator = scopeStack->local.find(*identifier);
-
-    if (iterator != scopeStack->local.cend())
-    {
-        return iterator->second;
-    }
+    // check in local scope first, then in the outer scopes it inherits from
+    // the nearest declaration shadows the outer ones
+    Table::const_iterator iterator;
 
-    if (scopeStack->outer.has_value())
+    for (const Scope* scope = scopeStack; scope != nullptr; scope = scope->outer)
     {
-        iterator = scopeStack->outer.value().find(*identifier);
+        iterator = scope->local.find(identifier);
 
-        if (iterator != scopeStack->outer.value().cend())
+        if (iterator != scope->local.cend())
         {
             return iterator->second;
         }
     }
     
-    iterator = globalScope->local.find(*identifier);
+    // global symbols are visible from independent scopes too
+    iterator = globalScope->local.find(identifier);
 
-    if (iterator != globalScope->local.find(*identifier))
+    if (iterator != globalScope->local.cend())
     {
         return iterator->second;
     }
     
     // if symbol has not been found, it wasn't declared in 
     // any reachable scope, thus throw exception
-    errors::UndefinedSymbolError(*identifier);
+    errors::UndefinedSymbolError(interner.get(identifier));
     // this line never gets reached
     return nullptr;
 }
 
 
-const Scope* SymbolTable::getScope()
+const Scope* SymbolTable::getScope() const
 {
     return scopeStack;
 }
@@ -108,7 +90,8 @@ void SymbolTable::pushScope(bool inherits)
     if (inherits)
     {
         // create a new scope that inherits from the previous scope
-        scope = new Scope(scopeStack->local, scopeStack->outer);
+        // the previous scope outlives this one, so it's referenced rather than copied
+        scope = new Scope(scopeStack, stackPointer);
     }
     else
     {
@@ -132,7 +115,12 @@ void SymbolTable::popScope()
 
 void SymbolTable::clear()
 {
-    popScope();
+    // a failed compilation may leave any number of scopes behind
+    while (scopeStack != nullptr)
+    {
+        popScope();
+    }
+
     globalScope = nullptr;
 }
 
@@ -140,11 +128,15 @@ void SymbolTable::clear()
 void SymbolTable::init()
 {
     scopeStack = new Scope();
+    scopeStack->prev = nullptr;
     globalScope = scopeStack;
+
+    // every compilation lays out its symbols from the beginning of the memory
+    stackPointer = 0;
 }
 
 
-size_t SymbolTable::getStackPointer()
+size_t SymbolTable::getStackPointer() const
 {
     return stackPointer;
 }
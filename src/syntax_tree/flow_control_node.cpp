@@ -4,8 +4,8 @@
 using namespace syntax_tree;
 
 
-ControlFlowNode::ControlFlowNode(pvm::ByteNode* byteNode, OpCodes opCode)
-: byteNode(byteNode), opCode(opCode)
+ControlFlowNode::ControlFlowNode(size_t jumpTarget, OpCodes opCode)
+: jumpTarget(jumpTarget), opCode(opCode)
 {
 
 }
@@ -30,17 +30,19 @@ Tokens::Token* Statement::getLast() const
 }
 
 
-void Statement::remove(Tokens::Token* token, bool del)
+void Statement::remove(Tokens::Token* token)
 {
     // check first if token is root
     if (token == root)
     {
-        if (del)
+        root = token->next;
+
+        // the new root is the beginning of the statement
+        if (root != nullptr)
         {
-            delete root;
+            root->prev = nullptr;
         }
-        
-        root = token->next;
+
         return;
     }
 
@@ -51,11 +53,6 @@ void Statement::remove(Tokens::Token* token, bool del)
     {
         token->next->prev = token->prev;
     }
-    
-    if (del)
-    {
-        delete token;
-    }
 
 }
 
@@ -1,5 +1,6 @@
 #include "syntax_tree.hh"
 #include "symbol_table.hh"
+#include "context.hh"
 
 
 using namespace syntax_tree;
@@ -7,14 +8,14 @@ using namespace symbol_table;
 
 
 SyntaxTree::SyntaxTree()
-: byteList(), statements(), controlFlowNodes()
+: byteList(), statements(), context(nullptr), controlFlowNodes()
 {
 	
 }
 
 
-SyntaxTree::SyntaxTree(Statements&& statements)
-: statements(std::move(statements)), byteList(), controlFlowNodes()
+SyntaxTree::SyntaxTree(Statements&& statements, compilation::Context* context)
+: statements(std::move(statements)), context(context), byteList(), controlFlowNodes()
 {
 	
 }
@@ -22,7 +23,7 @@ SyntaxTree::SyntaxTree(Statements&& statements)
 
 
 SyntaxTree::SyntaxTree(Tokens::TokenList& tokens)
-: byteList(), controlFlowNodes()
+: byteList(), context(tokens.context), controlFlowNodes()
 {
 	if (tokens.first == nullptr)
 	{
@@ -58,7 +59,7 @@ SyntaxTree::SyntaxTree(Tokens::TokenList& tokens)
 		if (statement == nullptr)
 		{
 			tok->prev = nullptr;
-			statement = new Statement(tok);
+			statement = context->arena.make<Statement>(tok);
 		}
 
 		token = tok;
@@ -68,63 +69,41 @@ SyntaxTree::SyntaxTree(Tokens::TokenList& tokens)
 }
 
 
-Tokens::Token* SyntaxTree::getHighestPriority(Tokens::Token* root) 
-{
-	// empty statements are checked by the calling function
-
-	for (Tokens::Token* token = root; token != nullptr; token = token->next)
-	{   
-
-		// don't permorm further checks or operations, 0 priority will never be executed
-		if (token->priority == 0)
-		{
-			continue;
-		}
-
-		// evaluate function declaration operators first since they must have higher priority
-		// than their parameters
-		if (token->opCode == OpCodes::FUNC_DECLARARION)
-		{
-			return token;
-		}
-
-		if (token->priority > root->priority)
-		{
-			root = token;
-		}
-
-		// do not search for tokens to evaluate past the scope
-		// so to prevent a scope's content from being evaluated before
-		// the scope operator
-		if (token->opCode == OpCodes::PUSH_SCOPE)
-		{
-			break;
-		}
-	}
-
-	return root;
-}
-
-
 pvm::ByteCode SyntaxTree::parseToByteCode()
 {
 	byteList = pvm::ByteList();
 
-	SymbolTable::init();
+	context->symbolTable.init();
 
 	// since this is the global scope, pop the symbols at the end
 	parseToByteCodePrivate();
 
-	SymbolTable::clear();
+	context->symbolTable.clear();
+
+	// the front-end nodes won't be used anymore, free them all at once
+	context->arena.release();
+	statements = Statements();
 
 	// add the last exit instruction to the byteList
-	byteList.add(new pvm::ByteNode(pvm::OpCode::EXIT));
-	byteList.add(new pvm::ByteNode(0, 1));
+	byteList.add(pvm::OpCode::EXIT);
+	byteList.add(0, 1);
+
+	if (context->optimize)
+	{
+		byteList.allocateRegisters();
+		byteList.fuseInstructions();
+	}
 
 	return byteList.toByteCode();
 }
 
 
+pvm::ByteCode SyntaxTree::lineTableToByteCode() const
+{
+	return byteList.lineTableToByteCode();
+}
+
+
 void SyntaxTree::parseToByteCodePrivate()
 {
 	/*
@@ -154,13 +133,13 @@ void SyntaxTree::parseToByteCodePrivate()
 	// set linked list's last element to the last evaluated statement
 	statements.end = statement;
 
-	const size_t localSymbolsSize = SymbolTable::getScope()->localSymbolsSize;
+	const size_t localSymbolsSize = context->symbolTable.getScope()->localSymbolsSize;
 
 	// don't add push instructions if there's nothing to push
 	if (localSymbolsSize != 0)
 	{
-		byteList.add(new pvm::ByteNode(pvm::OpCode::PUSH_BYTES));
-		byteList.add(new pvm::ByteNode(localSymbolsSize, 8));
+		byteList.add(pvm::OpCode::PUSH_BYTES);
+		byteList.add(localSymbolsSize, 8);
 	}
 
 	// at the end of tree generation, transform it into byte code
@@ -169,8 +148,8 @@ void SyntaxTree::parseToByteCodePrivate()
 	// don't pop form the stack if nothing was added in the first place
 	if (localSymbolsSize != 0)
 	{
-		byteList.add(new pvm::ByteNode(pvm::OpCode::POP));	
-		byteList.add(new pvm::ByteNode(localSymbolsSize, 8));
+		byteList.add(pvm::OpCode::POP);	
+		byteList.add(localSymbolsSize, 8);
 	}
 
 }
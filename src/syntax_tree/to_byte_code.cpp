@@ -1,4 +1,5 @@
 #include "syntax_tree.hh"
+#include "context.hh"
 #include "pvm.hh"
 #include "errors.hh"
 
@@ -13,35 +14,57 @@ using namespace pvm;
 #define setReturnValueToRegister(token) token->priority = 1
 
 
-// extracts the std::string* identifier from a Token
-#define IdOf(token) ((std::string*) token->value)
+// extracts the interned identifier from a Token
+#define IdOf(token) ((interner::StringId) token->value)
 
 
-#define AddNode(...) byteList.add(new ByteNode(__VA_ARGS__))
+#define Emit(...) byteList.add(__VA_ARGS__)
 
 
-static inline size_t StackPositionOf(const Token* token)
+static inline size_t StackPositionOf(const Token* token, const symbol_table::SymbolTable& symbolTable)
 {
-    return symbol_table::SymbolTable::get(IdOf(token))->stackPosition;
+    return symbolTable.get(IdOf(token))->stackPosition;
 }
 
 
-static void fillFlowControlPlaceholders(const std::vector<ControlFlowNode>& nodes, size_t conditionIndex, size_t exitIndex)
+// register holding the value of a token with its return value in a register
+// boolean operations set the ZERO FLAG, the others the RESULT register
+static inline Registers returnRegisterOf(const Token* token, const symbol_table::SymbolTable& symbolTable)
+{
+    return tokenTypeOf(token, symbolTable) == TokenType::BOOL ? Registers::ZERO_FLAG : Registers::RESULT;
+}
+
+
+// bodyOffset is the offset the body's ByteList was extended at
+static void fillFlowControlPlaceholders(const std::vector<ControlFlowNode>& nodes, size_t bodyOffset,
+    size_t conditionIndex, size_t exitIndex, ByteList& byteList)
 {
     for (const ControlFlowNode& node : nodes)
     {
         if (node.opCode == OpCodes::CONTINUE)
         {
-            node.byteNode->data = conditionIndex;
+            byteList.setJumpTarget(bodyOffset + node.jumpTarget, conditionIndex);
         }
         else // the case of OpCodes::BREAK
         {
-            node.byteNode->data = exitIndex;
+            byteList.setJumpTarget(bodyOffset + node.jumpTarget, exitIndex);
         }
     }
 }
 
 
+// break and continue statements of a scope that isn't a loop body belong to the enclosing loop
+// bodyOffset is the offset the scope's ByteList was extended at
+static void moveFlowControlNodes(const std::vector<ControlFlowNode>& nodes, size_t bodyOffset,
+    std::vector<ControlFlowNode>& enclosingNodes)
+{
+    for (const ControlFlowNode& node : nodes)
+    {
+        enclosingNodes.emplace_back(bodyOffset + node.jumpTarget, node.opCode);
+    }
+}
+
+
 static void addConstLoad(Registers reg, Value value, ByteList& byteList)
 {
     // TODO implement also negative values
@@ -52,18 +75,18 @@ static void addConstLoad(Registers reg, Value value, ByteList& byteList)
         switch (reg)
         {
             case Registers::GENERAL_A:
-                AddNode(OpCode::LD_CONST_A_BIT);
-                AddNode(value, 1);
+                Emit(OpCode::LD_CONST_A_BIT);
+                Emit(value, 1);
                 break;
             
             case Registers::GENERAL_B:
-                AddNode(OpCode::LD_CONST_B_BIT);
-                AddNode(value, 1);
+                Emit(OpCode::LD_CONST_B_BIT);
+                Emit(value, 1);
                 break;
             
             case Registers::RESULT:
-                AddNode(OpCode::LD_CONST_RESULT_BIT);
-                AddNode(value, 1);
+                Emit(OpCode::LD_CONST_RESULT_BIT);
+                Emit(value, 1);
                 break;
         }
         break;
@@ -72,18 +95,18 @@ static void addConstLoad(Registers reg, Value value, ByteList& byteList)
         switch (reg)
         {
             case Registers::GENERAL_A:
-                AddNode(OpCode::LD_CONST_A_1);
-                AddNode(value, 1);
+                Emit(OpCode::LD_CONST_A_1);
+                Emit(value, 1);
                 break;
             
             case Registers::GENERAL_B:
-                AddNode(OpCode::LD_CONST_B_1);
-                AddNode(value, 1);
+                Emit(OpCode::LD_CONST_B_1);
+                Emit(value, 1);
                 break;
             
             case Registers::RESULT:
-                AddNode(OpCode::LD_CONST_RESULT_1);
-                AddNode(value, 1);
+                Emit(OpCode::LD_CONST_RESULT_1);
+                Emit(value, 1);
                 break;
         }
         break;
@@ -92,18 +115,18 @@ static void addConstLoad(Registers reg, Value value, ByteList& byteList)
         switch (reg)
         {
             case Registers::GENERAL_A:
-                AddNode(OpCode::LD_CONST_A_4);
-                AddNode(value, 4);
+                Emit(OpCode::LD_CONST_A_4);
+                Emit(value, 4);
                 break;
             
             case Registers::GENERAL_B:
-                AddNode(OpCode::LD_CONST_B_4);
-                AddNode(value, 4);
+                Emit(OpCode::LD_CONST_B_4);
+                Emit(value, 4);
                 break;
             
             case Registers::RESULT:
-                 AddNode(OpCode::LD_CONST_RESULT_4);
-                AddNode(value, 4);
+                 Emit(OpCode::LD_CONST_RESULT_4);
+                Emit(value, 4);
                 break;
         }
         break;
@@ -112,18 +135,18 @@ static void addConstLoad(Registers reg, Value value, ByteList& byteList)
         switch (reg)
         {
         case Registers::GENERAL_A:
-            AddNode(OpCode::LD_CONST_A_8);
-            AddNode(value, 8);
+            Emit(OpCode::LD_CONST_A_8);
+            Emit(value, 8);
             break;
         
         case Registers::GENERAL_B:
-            AddNode(OpCode::LD_CONST_B_8);
-            AddNode(value, 8);
+            Emit(OpCode::LD_CONST_B_8);
+            Emit(value, 8);
             break;
         
         case Registers::RESULT:
-             AddNode(OpCode::LD_CONST_RESULT_8);
-            AddNode(value, 8);
+             Emit(OpCode::LD_CONST_RESULT_8);
+            Emit(value, 8);
             break;
         }
         break;
@@ -144,22 +167,7 @@ static void addConstLoad(Registers reg, Value value, ByteList& byteList)
 #define DONT_STORE_RESULT false
 
 
-static inline void deleteOperands(Tokens::Token** ops, OpType opType)
-{
-    if (opType == OpType::STANDALONE)
-    {
-        return;
-    }
-    
-    // if not STANDALONE, token is at least a UNARY operator
-    delete ops[0];
-
-    if (opType == OpType::BINARY)
-    {
-        // if it's BINARY, delete also the second operand
-        delete ops[1];
-    }
-}
+static void storeReturnValue(Tokens::Token* token, compilation::Context& context, ByteList& byteList);
 
 
 // lookup table for system interrupts
@@ -169,30 +177,6 @@ static const OpCode systemInterrupts[] =
 };
 
 
-static unsigned int symbolNumber = 0;
-
-static std::string* getTmpSymbolName()
-{
-    // 10 is the number of numeric characters in ASCII
-    // +1 is to round the result up in integer division
-    const unsigned char length = (unsigned char) (symbolNumber / 10 + 1);
-    std::string* string = new std::string(length, '0');
-
-    unsigned int n = symbolNumber;
-
-    for (unsigned char i = 0; i != length; i++)
-    {
-        (*string)[i] = (char) (n % 10 + '0');
-        // integer division discards rightmost digit (e.g. 325 -> 32)
-        n /= 10;
-    }
-
-    symbolNumber ++;
-    
-    return string;
-}
-
-
 void SyntaxTree::parseTokenOperator(Tokens::Token* token)
 {
     // treat token's value as a pointer to an array of token pointers
@@ -224,10 +208,21 @@ void SyntaxTree::parseTokenOperator(Tokens::Token* token)
                 parseTokenOperator(operand);
             }
 
+            // the byte code of the second operand would overwrite the register holding
+            // the first one, so the first one is stored and becomes a reference to it
+            if (i == 0 && opType == OpType::BINARY && hasReturnValueInRegister(operand)
+                && isOperator(operands[1]->opCode) && operands[1]->opCode != OpCodes::PUSH_SCOPE)
+            {
+                storeReturnValue(operand, *context, byteList);
+            }
+
         }
 
     } // if (isFLowOp(token->opCode))
 
+    // the operator's own byte code comes after its operands'
+    byteList.setLocation(token->line, token->column);
+
 
     // if token is a unary operator the result stored in the result register of an
     // eventual operation performed in the evaluation of its operand will not be overwritten 
@@ -250,45 +245,19 @@ void SyntaxTree::parseTokenOperator(Tokens::Token* token)
         token->opCode = OpCodes::REFERENCE;
     }
 
-    // scope tokens do not have a Token** as value, they have a SyntaxTree* instead
-    // it will be deleted in the byteCodeFor() function
-    if (token->opCode != OpCodes::PUSH_SCOPE && (unsigned char) opType != 0)
-    {
-        // delete operands since they won't be accessed anymore after their compilation
-        delete[] operands;
-    }
-    
+    // operand arrays are owned by the compilation's Arena and are freed along with it
 }
 
 
-static void byteCodeForUnaryOperation(Tokens::Token** operands, OpCode opCode, ByteList& byteList)
+static void byteCodeForUnaryOperation(Tokens::Token** operands, OpCode opCode, const symbol_table::SymbolTable& symbolTable, ByteList& byteList)
 {
     using namespace symbol_table;
     
     if (hasReturnValueInRegister(operands[0]))
     {
-        switch (operands[0]->type)
-        {    
-        case TokenType::DOUBLE:
-        case TokenType::LONG:
-            AddNode(OpCode::REG_MOV_8);
-            break;
-        
-        case TokenType::INT:
-        case TokenType::FLOAT:
-            AddNode(OpCode::REG_MOV_4);
-            break;
-        
-        case TokenType::BYTE:
-            AddNode(OpCode::REG_MOV_1);
-            break;
-        
-        case TokenType::BOOL:
-            AddNode(OpCode::REG_MOV_BIT);
-            break;
-        }
-        AddNode(Registers::GENERAL_A);
-        AddNode(Registers::RESULT);
+        Emit(OpCode::REG_TO_REG);
+        Emit(Registers::GENERAL_A);
+        Emit(returnRegisterOf(operands[0], symbolTable));
     }
     else if (operands[0]->opCode == OpCodes::REFERENCE)
     {
@@ -296,23 +265,23 @@ static void byteCodeForUnaryOperation(Tokens::Token** operands, OpCode opCode, B
         {    
         case TokenType::DOUBLE:
         case TokenType::LONG:
-            AddNode(OpCode::LD_A_8);
+            Emit(OpCode::LD_A_8);
             break;
         
         case TokenType::INT:
         case TokenType::FLOAT:
-            AddNode(OpCode::LD_A_4);
+            Emit(OpCode::LD_A_4);
             break;
         
         case TokenType::BYTE:
-            AddNode(OpCode::LD_A_1);
+            Emit(OpCode::LD_A_1);
             break;
         
         case TokenType::BOOL:
-            AddNode(OpCode::LD_A_BIT);
+            Emit(OpCode::LD_A_BIT);
             break;
         }
-        AddNode(StackPositionOf(operands[0]), 8);
+        Emit(StackPositionOf(operands[0], symbolTable), 8);
     }
     else // literal
     {
@@ -321,66 +290,47 @@ static void byteCodeForUnaryOperation(Tokens::Token** operands, OpCode opCode, B
 
     if (opCode != OpCode::NO_OP)
     {
-        AddNode(opCode);
+        Emit(opCode);
     }
 
 }
 
 
 // operation size: 19 bytes
-static void byteCodeForBinaryOperation(Tokens::Token** operands, OpCode opCode, ByteList& byteList)
+static void byteCodeForBinaryOperation(Tokens::Token** operands, OpCode opCode, const symbol_table::SymbolTable& symbolTable, ByteList& byteList)
 {
     using namespace symbol_table;
 
     if (hasReturnValueInRegister(operands[0]))
     {
-        switch (tokenTypeOf(operands[0]))
-        {    
-        case TokenType::DOUBLE:
-        case TokenType::LONG:
-            AddNode(OpCode::REG_MOV_8);
-            break;
-        
-        case TokenType::INT:
-        case TokenType::FLOAT:
-            AddNode(OpCode::REG_MOV_4);
-            break;
-        
-        case TokenType::BYTE:
-            AddNode(OpCode::REG_MOV_1);
-            break;
-        
-        case TokenType::BOOL:
-            AddNode(OpCode::REG_MOV_BIT);
-            break;
-        }
-        AddNode(Registers::GENERAL_A);
-        AddNode(Registers::RESULT);
+        Emit(OpCode::REG_TO_REG);
+        Emit(Registers::GENERAL_A);
+        Emit(returnRegisterOf(operands[0], symbolTable));
     }
     else if (operands[0]->opCode == OpCodes::REFERENCE)
     {
         
-        switch (tokenTypeOf(operands[0]))
+        switch (tokenTypeOf(operands[0], symbolTable))
         {    
         case TokenType::DOUBLE:
         case TokenType::LONG:
-            AddNode(OpCode::LD_A_8);
+            Emit(OpCode::LD_A_8);
             break;
         
         case TokenType::INT:
         case TokenType::FLOAT:
-            AddNode(OpCode::LD_A_4);
+            Emit(OpCode::LD_A_4);
             break;
         
         case TokenType::BYTE:
-            AddNode(OpCode::LD_A_1);
+            Emit(OpCode::LD_A_1);
             break;
         
         case TokenType::BOOL:
-            AddNode(OpCode::LD_A_BIT);
+            Emit(OpCode::LD_A_BIT);
             break;
         }
-        AddNode(StackPositionOf(operands[0]), 8);
+        Emit(StackPositionOf(operands[0], symbolTable), 8);
     }
     else // literal
     {
@@ -389,53 +339,34 @@ static void byteCodeForBinaryOperation(Tokens::Token** operands, OpCode opCode,
 
     if (hasReturnValueInRegister(operands[1]))
     {
-        switch (tokenTypeOf(operands[1]))
-        {    
-        case TokenType::DOUBLE:
-        case TokenType::LONG:
-            AddNode(OpCode::REG_MOV_8);
-            break;
-        
-        case TokenType::INT:
-        case TokenType::FLOAT:
-            AddNode(OpCode::REG_MOV_4);
-            break;
-        
-        case TokenType::BYTE:
-            AddNode(OpCode::REG_MOV_1);
-            break;
-        
-        case TokenType::BOOL:
-            AddNode(OpCode::REG_MOV_BIT);
-            break;
-        }
-        AddNode(Registers::GENERAL_B);
-        AddNode(Registers::RESULT);
+        Emit(OpCode::REG_TO_REG);
+        Emit(Registers::GENERAL_B);
+        Emit(returnRegisterOf(operands[1], symbolTable));
     }
     else if (operands[1]->opCode == OpCodes::REFERENCE)
     {
         
-        switch (tokenTypeOf(operands[1]))
+        switch (tokenTypeOf(operands[1], symbolTable))
         {    
         case TokenType::DOUBLE:
         case TokenType::LONG:
-            AddNode(OpCode::LD_B_8);
+            Emit(OpCode::LD_B_8);
             break;
         
         case TokenType::INT:
         case TokenType::FLOAT:
-            AddNode(OpCode::LD_B_4);
+            Emit(OpCode::LD_B_4);
             break;
         
         case TokenType::BYTE:
-            AddNode(OpCode::LD_B_1);
+            Emit(OpCode::LD_B_1);
             break;
         
         case TokenType::BOOL:
-            AddNode(OpCode::LD_B_BIT);
+            Emit(OpCode::LD_B_BIT);
             break;
         }
-        AddNode(StackPositionOf(operands[1]), 8);
+        Emit(StackPositionOf(operands[1], symbolTable), 8);
     }
     else // literal
     {
@@ -444,24 +375,23 @@ static void byteCodeForBinaryOperation(Tokens::Token** operands, OpCode opCode,
 
     if (opCode != OpCode::NO_OP)
     {
-        AddNode(opCode);
+        Emit(opCode);
     }
 
 }
 
 
-static std::string* storeLiteral(Value value, Tokens::TokenType type, ByteList& byteList)
+static interner::StringId storeLiteral(Value value, Tokens::TokenType type, compilation::Context& context, ByteList& byteList)
 {
     using namespace symbol_table;
     
     // declare a new Symbol holding the value
     // push the operation result onto the stack
 
-    // TODO string pointer should be deleted later
-
-    std::string* name = getTmpSymbolName();
+    // temporary values don't need a name, just a unique identifier
+    const interner::StringId name = context.interner.unique();
 
-    SymbolTable::declare(
+    context.symbolTable.declare(
         name,
         new Symbol(0, type)
     );
@@ -471,42 +401,41 @@ static std::string* storeLiteral(Value value, Tokens::TokenType type, ByteList&
     {
     case TokenType::LONG:
     case TokenType::DOUBLE:
-        AddNode(OpCode::MEM_SET_8);
+        Emit(OpCode::MEM_SET_8);
         break;
     
     case TokenType::INT:
     case TokenType::FLOAT:
-        AddNode(OpCode::MEM_SET_4);
+        Emit(OpCode::MEM_SET_4);
         break;
     
     case TokenType::BYTE:
-            AddNode(OpCode::MEM_SET_1);
+            Emit(OpCode::MEM_SET_1);
             break;
     
     case TokenType::BOOL:
-        AddNode(OpCode::MEM_SET_BIT);
+        Emit(OpCode::MEM_SET_BIT);
         break;
     }
 
-    AddNode(SymbolTable::get(name)->stackPosition, 8);
-    AddNode(value, typeSize(type));
+    Emit(context.symbolTable.get(name)->stackPosition, 8);
+    Emit(value, typeSize(type));
 
     return name;
 }
 
 
-static std::string* storeResult(Registers reg, Tokens::TokenType type, ByteList& byteList)
+static interner::StringId storeResult(Registers reg, Tokens::TokenType type, compilation::Context& context, ByteList& byteList)
 {
     using namespace symbol_table;
 
     // declare a new Symbol holding the value
     // push the operation result onto the stack
 
-    // TODO string pointer should be deleted later
-
-    std::string* name = getTmpSymbolName();
+    // temporary values don't need a name, just a unique identifier
+    const interner::StringId name = context.interner.unique();
 
-    SymbolTable::declare(
+    context.symbolTable.declare(
         name,
         new Symbol(0, type)
     );
@@ -516,90 +445,104 @@ static std::string* storeResult(Registers reg, Tokens::TokenType type, ByteList&
     {    
     case TokenType::DOUBLE:
     case TokenType::LONG:
-        AddNode(OpCode::REG_MOV_8);
+        Emit(OpCode::REG_MOV_8);
         break;
     
     case TokenType::INT:
     case TokenType::FLOAT:
-        AddNode(OpCode::REG_MOV_4);
+        Emit(OpCode::REG_MOV_4);
         break;
     
     case TokenType::BYTE:
-            AddNode(OpCode::REG_MOV_1);
+            Emit(OpCode::REG_MOV_1);
             break;
     
     case TokenType::BOOL:
-        AddNode(OpCode::REG_MOV_BIT);
+        Emit(OpCode::REG_MOV_BIT);
         break;
     }
 
-    AddNode(SymbolTable::get(name)->stackPosition, 8);
-    AddNode(reg);
+    Emit(context.symbolTable.get(name)->stackPosition, 8);
+    Emit(reg);
 
     return name;
 }
 
 
+// stores the value a Token has left in a register, the Token becomes a reference to it
+static void storeReturnValue(Tokens::Token* token, compilation::Context& context, ByteList& byteList)
+{
+    const TokenType type = tokenTypeOf(token, context.symbolTable);
+
+    token->value = toValue(storeResult(returnRegisterOf(token, context.symbolTable), type, context, byteList));
+    token->opCode = OpCodes::REFERENCE;
+    token->type = type;
+    token->priority = 0;
+}
+
+
 size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, bool doStoreResult)
 {
     using namespace symbol_table;
 
+    SymbolTable& symbolTable = context->symbolTable;
+
     switch(token->opCode)
     {
 
     case OpCodes::ASSIGNMENT_ASSIGN:
     {
-        Symbol* lValue = SymbolTable::get((std::string*) operands[0]->value);
+        Symbol* lValue = symbolTable.get(IdOf(operands[0]));
 
         if (hasReturnValueInRegister(operands[1]))
         {
-            switch (tokenTypeOf(operands[1]))
+            switch (tokenTypeOf(operands[1], symbolTable))
             {    
             case TokenType::DOUBLE:
             case TokenType::LONG:
-                AddNode(OpCode::REG_MOV_8);
+                Emit(OpCode::REG_MOV_8);
                 break;
             
             case TokenType::INT:
             case TokenType::FLOAT:
-                AddNode(OpCode::REG_MOV_4);
+                Emit(OpCode::REG_MOV_4);
                 break;
             
             case TokenType::BYTE:
-                AddNode(OpCode::REG_MOV_1);
+                Emit(OpCode::REG_MOV_1);
                 break;
             
             case TokenType::BOOL:
-                AddNode(OpCode::REG_MOV_BIT);
+                Emit(OpCode::REG_MOV_BIT);
                 break;
             }
-            AddNode(lValue->stackPosition, 8);
-            AddNode(Registers::RESULT);
+            Emit(lValue->stackPosition, 8);
+            Emit(returnRegisterOf(operands[1], symbolTable));
         }
         else if (operands[1]->opCode == OpCodes::REFERENCE)
         {
-            switch (tokenTypeOf(operands[1]))
+            switch (tokenTypeOf(operands[1], symbolTable))
             {
             case TokenType::LONG:
             case TokenType::DOUBLE:
-                AddNode(OpCode::MEM_MOV_8);
+                Emit(OpCode::MEM_MOV_8);
                 break;
             
             case TokenType::INT:
             case TokenType::FLOAT:
-                AddNode(OpCode::MEM_MOV_4);
+                Emit(OpCode::MEM_MOV_4);
                 break;
             
             case TokenType::BYTE:
-                AddNode(OpCode::MEM_MOV_1);
+                Emit(OpCode::MEM_MOV_1);
                 break;
             
             case TokenType::BOOL:
-                AddNode(OpCode::MEM_MOV_BIT);
+                Emit(OpCode::MEM_MOV_BIT);
                 break;
             };
-            AddNode(lValue->stackPosition, 8);
-            AddNode(StackPositionOf(operands[1]), 8);
+            Emit(lValue->stackPosition, 8);
+            Emit(StackPositionOf(operands[1], symbolTable), 8);
         }
         else // token is a literal
         {
@@ -610,31 +553,28 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
             {
             case TokenType::LONG:
             case TokenType::DOUBLE:
-                AddNode(OpCode::MEM_SET_8);
+                Emit(OpCode::MEM_SET_8);
                 break;
             
             case TokenType::INT:
             case TokenType::FLOAT:
-                AddNode(OpCode::MEM_SET_4);
+                Emit(OpCode::MEM_SET_4);
                 break;
             
             case TokenType::BYTE:
-                AddNode(OpCode::MEM_SET_1);
+                Emit(OpCode::MEM_SET_1);
                 break;
             
             case TokenType::BOOL:
-                AddNode(OpCode::MEM_SET_BIT);
+                Emit(OpCode::MEM_SET_BIT);
                 break;
             }
-            AddNode(lValue->stackPosition, 8);
+            Emit(lValue->stackPosition, 8);
             // pass as second operand the token's literal value
             // the size is that of the variable the value is being assigned to
             // size compatibility checks have already been performed
-            AddNode(operands[1]->value, typeSize(lValue->type));
+            Emit(operands[1]->value, typeSize(lValue->type));
         }
-        
-        // these operands won't be accessed anymore after compilation
-        deleteOperands(operands, OpType::BINARY);
 
         return lValue->stackPosition;
     }
@@ -642,15 +582,13 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
 
     case OpCodes::ARITHMETICAL_SUM:
     {
-        byteCodeForBinaryOperation(operands, OpCode::ADD, byteList);
+        byteCodeForBinaryOperation(operands, OpCode::ADD, symbolTable, byteList);
 
-        TokenType type = tokenTypeOf(operands[0]);
-
-        deleteOperands(operands, OpType::BINARY);
+        TokenType type = tokenTypeOf(operands[0], symbolTable);
 
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::RESULT, type, byteList);
+            return (size_t) storeResult(Registers::RESULT, type, *context, byteList);
         }
         
         setReturnValueToRegister(token);
@@ -667,39 +605,37 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
         Token one = Token(TokenType::INT, 0, OpCodes::LITERAL, 1);
         Token* ops[2] = {operands[0], &one};
 
-        byteCodeForBinaryOperation(ops, OpCode::ADD, byteList);
+        byteCodeForBinaryOperation(ops, OpCode::ADD, symbolTable, byteList);
 
-        TokenType type = tokenTypeOf(operands[0]);
+        TokenType type = tokenTypeOf(operands[0], symbolTable);
 
         // update the incremented variable
         switch (type)
         {    
         case TokenType::DOUBLE:
         case TokenType::LONG:
-            AddNode(OpCode::REG_MOV_8);
+            Emit(OpCode::REG_MOV_8);
             break;
         
         case TokenType::INT:
         case TokenType::FLOAT:
-            AddNode(OpCode::REG_MOV_4);
+            Emit(OpCode::REG_MOV_4);
             break;
 
         case TokenType::BYTE:
-            AddNode(OpCode::REG_MOV_1);
+            Emit(OpCode::REG_MOV_1);
             break;
             
         case TokenType::BOOL:
-            AddNode(OpCode::REG_MOV_BIT);
+            Emit(OpCode::REG_MOV_BIT);
             break;
         }
-        AddNode(StackPositionOf(operands[0]), 8);
-        AddNode(Registers::RESULT);
-
-        deleteOperands(operands, OpType::UNARY);
+        Emit(StackPositionOf(operands[0], symbolTable), 8);
+        Emit(Registers::RESULT);
         
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::RESULT, type, byteList);
+            return (size_t) storeResult(Registers::RESULT, type, *context, byteList);
         }
         
         setReturnValueToRegister(token);
@@ -714,39 +650,37 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
         Token one = Token(TokenType::INT, 0, OpCodes::LITERAL, 1);
         Token* ops[2] = {operands[0], &one};
 
-        byteCodeForBinaryOperation(ops, OpCode::SUB, byteList);
+        byteCodeForBinaryOperation(ops, OpCode::SUB, symbolTable, byteList);
 
-        TokenType type = tokenTypeOf(operands[0]);
+        TokenType type = tokenTypeOf(operands[0], symbolTable);
 
         // update the decremented variable
         switch (type)
         {    
         case TokenType::DOUBLE:
         case TokenType::LONG:
-            AddNode(OpCode::REG_MOV_8);
+            Emit(OpCode::REG_MOV_8);
             break;
         
         case TokenType::INT:
         case TokenType::FLOAT:
-            AddNode(OpCode::REG_MOV_4);
+            Emit(OpCode::REG_MOV_4);
             break;
         
         case TokenType::BYTE:
-            AddNode(OpCode::REG_MOV_1);
+            Emit(OpCode::REG_MOV_1);
             break;
         
         case TokenType::BOOL:
-            AddNode(OpCode::REG_MOV_BIT);
+            Emit(OpCode::REG_MOV_BIT);
             break;
         }
-        AddNode(StackPositionOf(operands[0]), 8);
-        AddNode(Registers::RESULT);
-
-        deleteOperands(operands, OpType::UNARY);
+        Emit(StackPositionOf(operands[0], symbolTable), 8);
+        Emit(Registers::RESULT);
         
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::RESULT, type, byteList);
+            return (size_t) storeResult(Registers::RESULT, type, *context, byteList);
         }
         
         setReturnValueToRegister(token);
@@ -757,15 +691,13 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
 
     case OpCodes::ARITHMETICAL_SUB:
     {
-        byteCodeForBinaryOperation(operands, OpCode::SUB, byteList);
-
-        TokenType type = tokenTypeOf(operands[0]);
+        byteCodeForBinaryOperation(operands, OpCode::SUB, symbolTable, byteList);
 
-        deleteOperands(operands, OpType::BINARY);
+        TokenType type = tokenTypeOf(operands[0], symbolTable);
 
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::RESULT, type, byteList);
+            return (size_t) storeResult(Registers::RESULT, type, *context, byteList);
         }
         
         setReturnValueToRegister(token);
@@ -776,15 +708,13 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
 
     case OpCodes::ARITHMETICAL_MUL:
     {
-        byteCodeForBinaryOperation(operands, OpCode::MUL, byteList);
+        byteCodeForBinaryOperation(operands, OpCode::MUL, symbolTable, byteList);
 
-        TokenType type = tokenTypeOf(operands[0]);
-
-        deleteOperands(operands, OpType::BINARY);
+        TokenType type = tokenTypeOf(operands[0], symbolTable);
 
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::RESULT, type, byteList);
+            return (size_t) storeResult(Registers::RESULT, type, *context, byteList);
         }
         
         setReturnValueToRegister(token);
@@ -795,15 +725,13 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
 
     case OpCodes::ARITHMETICAL_DIV:
     {
-        byteCodeForBinaryOperation(operands, OpCode::DIV, byteList);
+        byteCodeForBinaryOperation(operands, OpCode::DIV, symbolTable, byteList);
     
-        TokenType type = tokenTypeOf(operands[0]);
-
-        deleteOperands(operands, OpType::BINARY);
+        TokenType type = tokenTypeOf(operands[0], symbolTable);
 
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::RESULT, type, byteList);
+            return (size_t) storeResult(Registers::RESULT, type, *context, byteList);
         }
         
         setReturnValueToRegister(token);
@@ -814,13 +742,11 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
 
     case OpCodes::LOGICAL_EQ:
     {
-        byteCodeForBinaryOperation(operands, OpCode::CMP, byteList);
-
-        deleteOperands(operands, OpType::BINARY);
+        byteCodeForBinaryOperation(operands, OpCode::CMP, symbolTable, byteList);
 
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, byteList);
+            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, *context, byteList);
         }
         
         setReturnValueToRegister(token);
@@ -831,13 +757,11 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
     
     case OpCodes::LOGICAL_NOT_EQ:
     {
-        byteCodeForBinaryOperation(operands, OpCode::CMP_REVERSE, byteList);
-
-        deleteOperands(operands, OpType::BINARY);
+        byteCodeForBinaryOperation(operands, OpCode::CMP_REVERSE, symbolTable, byteList);
 
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, byteList);
+            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, *context, byteList);
         }
         
         setReturnValueToRegister(token);
@@ -852,13 +776,11 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
             tmp = a - b
             zero flag = tmp < 0
         */
-        byteCodeForBinaryOperation(operands, OpCode::SUB, byteList);
-
-        deleteOperands(operands, OpType::BINARY);
+        byteCodeForBinaryOperation(operands, OpCode::SUB, symbolTable, byteList);
 
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, byteList);
+            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, *context, byteList);
         }
         
         setReturnValueToRegister(token);
@@ -876,21 +798,20 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
         @l1:
         */
 
-        byteCodeForBinaryOperation(operands, OpCode::SUB, byteList);
+        byteCodeForBinaryOperation(operands, OpCode::SUB, symbolTable, byteList);
 
-        AddNode(OpCode::IF_JUMP);
+        Emit(OpCode::IF_JUMP);
+        // jump past the jump target operand and the REG_TO_REG instruction
         // 3 is the size of the REG_TO_REG instruction along with its operands
-        AddNode(SymbolTable::getStackPointer() + 3, 8);
+        byteList.addJumpTarget(byteList.getCurrentSize() + sizeof(size_t) + 3);
 
-        AddNode(OpCode::REG_TO_REG);
-        AddNode(Registers::ZERO_FLAG);
-        AddNode(Registers::SIGN_FLAG);
-
-        deleteOperands(operands, OpType::BINARY);
+        Emit(OpCode::REG_TO_REG);
+        Emit(Registers::ZERO_FLAG);
+        Emit(Registers::SIGN_FLAG);
 
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, byteList);
+            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, *context, byteList);
         }
 
         setReturnValueToRegister(token);
@@ -911,21 +832,20 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
 
         Token* ops[2] = {operands[1], operands[0]};
 
-        byteCodeForBinaryOperation(ops, OpCode::SUB, byteList);
+        byteCodeForBinaryOperation(ops, OpCode::SUB, symbolTable, byteList);
 
-        AddNode(OpCode::IF_JUMP);
+        Emit(OpCode::IF_JUMP);
+        // jump past the jump target operand and the REG_TO_REG instruction
         // 3 is the size of the REG_TO_REG instruction along with its operands
-        AddNode(SymbolTable::getStackPointer() + 3, 8);
-
-        AddNode(OpCode::REG_TO_REG);
-        AddNode(Registers::ZERO_FLAG);
-        AddNode(Registers::SIGN_FLAG);
+        byteList.addJumpTarget(byteList.getCurrentSize() + sizeof(size_t) + 3);
 
-        deleteOperands(operands, OpType::BINARY);
+        Emit(OpCode::REG_TO_REG);
+        Emit(Registers::ZERO_FLAG);
+        Emit(Registers::SIGN_FLAG);
 
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, byteList);
+            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, *context, byteList);
         }
 
         setReturnValueToRegister(token);
@@ -944,13 +864,11 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
         // just invert operands
         Token* ops[2] = {operands[1], operands[0]};
 
-        byteCodeForBinaryOperation(ops, OpCode::SUB, byteList);
-
-        deleteOperands(operands, OpType::BINARY);
+        byteCodeForBinaryOperation(ops, OpCode::SUB, symbolTable, byteList);
 
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, byteList);
+            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, *context, byteList);
         }
         
         setReturnValueToRegister(token);
@@ -968,13 +886,11 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
         Token zero = Token(TokenType::INT, 0, OpCodes::LITERAL, 0);
         Token* ops[2] = {operands[0], &zero};
 
-        byteCodeForBinaryOperation(ops, OpCode::CMP, byteList);
-
-        deleteOperands(operands, OpType::UNARY);
+        byteCodeForBinaryOperation(ops, OpCode::CMP, symbolTable, byteList);
 
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, byteList);
+            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, *context, byteList);
         }
         
         setReturnValueToRegister(token);
@@ -986,32 +902,37 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
     case OpCodes::LOGICAL_AND:
     {
         /*
-            zero flag = a != 1
-            if zero flag jump @l1
+            zero flag = a != 0
+            if not zero flag jump @l1
             zero flag = b != 0
         @l1:
         */
 
-        Token one = Token(TokenType::INT, 0, OpCodes::LITERAL, 1);
-        Token* ops[2] = {operands[0], &one};
+        // the comparison of a overwrites the zero flag b may be left in
+        if (hasReturnValueInRegister(operands[1]))
+        {
+            storeReturnValue(operands[1], *context, byteList);
+        }
 
-        byteCodeForBinaryOperation(ops, OpCode::CMP_REVERSE, byteList);
+        Token zero = Token(TokenType::INT, 0, OpCodes::LITERAL, 0);
+        Token* ops[2] = {operands[0], &zero};
 
-        AddNode(OpCode::IF_JUMP);
-        // address to jump to = current stack pointer + size of instructions to jump over
-        AddNode(SymbolTable::getStackPointer() + 19, 8);
+        byteCodeForBinaryOperation(ops, OpCode::CMP_REVERSE, symbolTable, byteList);
+
+        // a is false, so is the result, which is left in the zero flag
+        Emit(OpCode::IF_NOT_JUMP);
+        // the jump target is set after the second operation is compiled
+        const size_t exitTarget = byteList.addJumpTarget();
 
-        Token zero = Token(TokenType::INT, 0, OpCodes::LITERAL, 0);
         ops[0] = operands[1];
-        ops[1] = &zero;
 
-        byteCodeForBinaryOperation(ops, OpCode::CMP_REVERSE, byteList);
+        byteCodeForBinaryOperation(ops, OpCode::CMP_REVERSE, symbolTable, byteList);
 
-        deleteOperands(operands, OpType::BINARY);
+        byteList.setJumpTarget(exitTarget, byteList.getCurrentSize());
 
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, byteList);
+            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, *context, byteList);
         }
         
         setReturnValueToRegister(token);
@@ -1029,24 +950,30 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
         @l1:
         */
 
+        // the comparison of a overwrites the zero flag b may be left in
+        if (hasReturnValueInRegister(operands[1]))
+        {
+            storeReturnValue(operands[1], *context, byteList);
+        }
+
         Token zero = Token(TokenType::INT, 0, OpCodes::LITERAL, 0);
         Token* ops[2] = {operands[0], &zero};
 
-        byteCodeForBinaryOperation(ops, OpCode::CMP_REVERSE, byteList);
+        byteCodeForBinaryOperation(ops, OpCode::CMP_REVERSE, symbolTable, byteList);
 
-        AddNode(OpCode::IF_JUMP);
-        // address to jump to = current stack pointer + size of instructions to jump over
-        AddNode(SymbolTable::getStackPointer() + 19, 8);
+        Emit(OpCode::IF_JUMP);
+        // the jump target is set after the second operation is compiled
+        const size_t exitTarget = byteList.addJumpTarget();
 
         ops[0] = operands[1];
 
-        byteCodeForBinaryOperation(ops, OpCode::CMP_REVERSE, byteList);
+        byteCodeForBinaryOperation(ops, OpCode::CMP_REVERSE, symbolTable, byteList);
 
-        deleteOperands(operands, OpType::BINARY);
+        byteList.setJumpTarget(exitTarget, byteList.getCurrentSize());
 
         if (doStoreResult)
         {
-            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, byteList);
+            return (size_t) storeResult(Registers::ZERO_FLAG, TokenType::BOOL, *context, byteList);
         }
         
         setReturnValueToRegister(token);
@@ -1059,9 +986,7 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
     {
         OpCode code = systemInterrupts[operands[0]->value];
 
-        AddNode(code);
-
-        deleteOperands(operands, OpType::UNARY);
+        Emit(code);
 
         return 0;
     }
@@ -1069,9 +994,7 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
 
     case OpCodes::SYSTEM_LOAD:
     {
-        byteCodeForUnaryOperation(operands, OpCode::NO_OP, byteList);
-
-        deleteOperands(operands, OpType::UNARY);
+        byteCodeForUnaryOperation(operands, OpCode::NO_OP, symbolTable, byteList);
 
         return 0;
     }
@@ -1080,61 +1003,46 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
     case OpCodes::OPEN_PARENTHESIS:
     {
         // save operand's properties to avoid accessing freed memory
-        const TokenType contentType = tokenTypeOf(operands[0]);
+        const TokenType contentType = tokenTypeOf(operands[0], symbolTable);
 
         if (doStoreResult)
         {
             Value contentValue = operands[0]->value;
 
-            deleteOperands(operands, OpType::UNARY);
-
             if (hasReturnValueInRegister(operands[0]))
             {
                 // copy return value from register to memory
-                return (size_t) storeResult(Registers::RESULT, contentType, byteList);
+                return (size_t) storeResult(returnRegisterOf(operands[0], symbolTable), contentType, *context, byteList);
             }
 
-            if (token->opCode == OpCodes::REFERENCE)
+            if (operands[0]->opCode == OpCodes::REFERENCE)
             {
-                return SymbolTable::get((std::string*) contentValue)->stackPosition;
+                return symbolTable.get((interner::StringId) contentValue)->stackPosition;
             }
             
-            return (size_t) storeLiteral(contentValue, contentType, byteList);
+            return (size_t) storeLiteral(contentValue, contentType, *context, byteList);
         }
 
         // if not storeResult:
 
         if (operands[0]->opCode == OpCodes::REFERENCE)
         {
-            // if parenthesis content is a reference, load it into the correct register and return 0
+            // if parenthesis content is a reference, this token becomes the same reference
+            // the operator reads it from memory, two parenthesized operands can't share a register
+            const interner::StringId content = IdOf(operands[0]);
 
-            switch (contentType)
-            {
-            case TokenType::BOOL:
-                // if bool --> load result into a bit register (ZERO FLAG)
-                AddNode(OpCode::LD_ZERO_FLAG);
-                break;
-            
-            case TokenType::BYTE:
-                AddNode(OpCode::LD_RESULT_1);
-                break;
-            
-            case TokenType::INT:
-            case TokenType::FLOAT:
-                AddNode(OpCode::LD_RESULT_4);
-                break;
-            
-            case TokenType::LONG:
-            case TokenType::DOUBLE:
-                AddNode(OpCode::LD_RESULT_8);
-            }
+            token->type = contentType;
+            token->opCode = OpCodes::REFERENCE;
 
-            AddNode(SymbolTable::get(IdOf(operands[0]))->stackPosition, 8);
-            
-            // to have the content's result readily available for the next operator
-            setReturnValueToRegister(token);
+            // token->value will be set to content by the caller function
+            return content;
+        }
 
-            deleteOperands(operands, OpType::UNARY);
+        if (hasReturnValueInRegister(operands[0]))
+        {
+            // the content's result is left in its register for the next operator
+            token->type = contentType;
+            setReturnValueToRegister(token);
 
             return 0;
         }
@@ -1147,8 +1055,6 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
         token->type = operands[0]->type;
         token->opCode = OpCodes::LITERAL;
 
-        deleteOperands(operands, OpType::UNARY);
-
         // token->value will be set to tmpValue by the caller function
         return tmpValue;
     }
@@ -1175,9 +1081,9 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
         // load condition
         if (hasReturnValueInRegister(operands[0]))
         {
-            AddNode(OpCode::REG_TO_REG);
-            AddNode(Registers::GENERAL_A);
-            AddNode(Registers::ZERO_FLAG);
+            Emit(OpCode::REG_TO_REG);
+            Emit(Registers::GENERAL_A);
+            Emit(Registers::ZERO_FLAG);
         }
         else if (operands[0]->opCode == OpCodes::LITERAL)
         {
@@ -1185,66 +1091,62 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
         }
         else if (operands[0]->opCode == OpCodes::REFERENCE)
         {
-            switch (tokenTypeOf(operands[0]))
+            switch (tokenTypeOf(operands[0], symbolTable))
             {    
             case TokenType::DOUBLE:
             case TokenType::LONG:
-                AddNode(OpCode::LD_A_8);
+                Emit(OpCode::LD_A_8);
                 break;
             
             case TokenType::INT:
             case TokenType::FLOAT:
-                AddNode(OpCode::LD_A_4);
+                Emit(OpCode::LD_A_4);
                 break;      
             
             case TokenType::BYTE:
-                AddNode(OpCode::LD_A_1);
+                Emit(OpCode::LD_A_1);
                 break;
             
             case TokenType::BOOL:
-                AddNode(OpCode::LD_A_BIT);
+                Emit(OpCode::LD_A_BIT);
                 break;
             }
 
-            AddNode(StackPositionOf(operands[0]), 8);
+            Emit(StackPositionOf(operands[0], symbolTable), 8);
         }
 
         // invert condition (compare with 0)
         addConstLoad(Registers::GENERAL_B, 0, byteList);
-        AddNode(OpCode::CMP);      
+        Emit(OpCode::CMP);      
         
     // conditional jump instruction
 
-        AddNode(OpCode::IF_JUMP);
-        // bodySizeNode will be set later when the actual if body is compiled
-        // 8 is the size in bytes of size_t, 0 is just to initialize it
-        ByteNode* exitIndexNode = new ByteNode(0, 8);
-        byteList.add(exitIndexNode);
+        Emit(OpCode::IF_JUMP);
+        // the exit index will be set later when the actual if body is compiled
+        const size_t exitIndexTarget = byteList.addJumpTarget();
 
         // if the if's body is a whole scope, extraxt its SyntaxTree and extend
         // this' byteList with the scope tree's
         if (operands[1]->opCode == OpCodes::PUSH_SCOPE)
         {
             SyntaxTree* body = (SyntaxTree*) operands[1]->value;
+
             // body has already been parsed to byte code
+            const size_t bodyOffset = byteList.getCurrentSize();
             byteList.extend(body->byteList);
 
+            moveFlowControlNodes(body->controlFlowNodes, bodyOffset, controlFlowNodes);
+
             // body's SyntaxTree won't be used anymore
-            delete body;
+            context->releaseScopeTree(body);
         }
         else // if operand is just a statement without scope
         {
             parseTokenOperator(operands[1]);
-
-            delete operands[1];
         }
 
         // update the index to jump to
-        exitIndexNode->data = byteList.getCurrentSize();
-
-        // delete just the first operand (bool condition) since the if's body has already
-        // been deleted after being handled
-        delete operands[0];
+        byteList.setJumpTarget(exitIndexTarget, byteList.getCurrentSize());
 
         return 0;
     }
@@ -1280,9 +1182,9 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
         // load condition
         if (hasReturnValueInRegister(operands[0]))
         {
-            AddNode(OpCode::REG_TO_REG);
-            AddNode(Registers::GENERAL_A);
-            AddNode(Registers::ZERO_FLAG);
+            Emit(OpCode::REG_TO_REG);
+            Emit(Registers::GENERAL_A);
+            Emit(Registers::ZERO_FLAG);
         }
         else if (operands[0]->opCode == OpCodes::LITERAL)
         {
@@ -1290,70 +1192,69 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
         }
         else if (operands[0]->opCode == OpCodes::REFERENCE)
         {
-            switch (tokenTypeOf(operands[0]))
+            switch (tokenTypeOf(operands[0], symbolTable))
             {    
             case TokenType::DOUBLE:
             case TokenType::LONG:
-                AddNode(OpCode::LD_A_8);
+                Emit(OpCode::LD_A_8);
                 break;
             
             case TokenType::INT:
             case TokenType::FLOAT:
-                AddNode(OpCode::LD_A_4);
+                Emit(OpCode::LD_A_4);
                 break;
             
             case TokenType::BYTE:
-                AddNode(OpCode::LD_A_1);
+                Emit(OpCode::LD_A_1);
                 break;
             
             case TokenType::BOOL:
-                AddNode(OpCode::LD_A_BIT);
+                Emit(OpCode::LD_A_BIT);
                 break;
             }
 
-            AddNode(StackPositionOf(operands[0]), 8);
+            Emit(StackPositionOf(operands[0], symbolTable), 8);
         }
 
         // invert condition (compare with 0)
         addConstLoad(Registers::GENERAL_B, 0, byteList);
-        AddNode(OpCode::CMP);        
+        Emit(OpCode::CMP);        
     
     // conditional jump
 
-        AddNode(OpCode::IF_JUMP);
-        // save condidional jump's operand's pointer to set it later
-        ByteNode* exitIndexNode = new ByteNode(0, 8);
-        byteList.add(exitIndexNode);
+        Emit(OpCode::IF_JUMP);
+        // save condidional jump's operand's offset to set it later
+        const size_t exitIndexTarget = byteList.addJumpTarget();
 
     // while body
 
         if (operands[1]->opCode == OpCodes::PUSH_SCOPE)
         {
             SyntaxTree* body = (SyntaxTree*) operands[1]->value;
+
+            const size_t bodyOffset = byteList.getCurrentSize();
             byteList.extend(body->byteList);
 
             // add unconditional jump to condition evaluation
-            AddNode(OpCode::JMP);
-            AddNode(conditionInstructionIndex, 8);
+            Emit(OpCode::JMP);
+            byteList.addJumpTarget(conditionInstructionIndex);
 
-            fillFlowControlPlaceholders(body->controlFlowNodes, conditionInstructionIndex, byteList.getCurrentSize());
+            fillFlowControlPlaceholders(body->controlFlowNodes, bodyOffset,
+                conditionInstructionIndex, byteList.getCurrentSize(), byteList);
 
-            delete body;
+            context->releaseScopeTree(body);
         }
         else
         {
             parseTokenOperator(operands[1]);
-            delete operands[1];
 
             // add unconditional jump to condition evaluation
-            AddNode(OpCode::JMP);
-            AddNode(conditionInstructionIndex, 8);
+            Emit(OpCode::JMP);
+            byteList.addJumpTarget(conditionInstructionIndex);
         }
 
         // set exit index to the byte next to the unconditional jump instruction
-        exitIndexNode->data = byteList.getCurrentSize();
-
-        delete operands[0];
+        byteList.setJumpTarget(exitIndexTarget, byteList.getCurrentSize());
 
         return 0;
     }
@@ -1362,10 +1263,14 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
     case OpCodes::PUSH_SCOPE:
     {
         SyntaxTree* tree = (SyntaxTree*) token->value;
+
+        const size_t treeOffset = byteList.getCurrentSize();
         byteList.extend(tree->byteList);
 
+        moveFlowControlNodes(tree->controlFlowNodes, treeOffset, controlFlowNodes);
+
         // after the tree's byte code is extracted, the tree won't be used anymore
-        delete tree;
+        context->releaseScopeTree(tree);
 
         return 0;
     }
@@ -1376,12 +1281,10 @@ size_t SyntaxTree::byteCodeFor(Tokens::Token* token, Tokens::Token** operands, b
     {
         // uncontitional jump to condition evaluation or end of loop
 
-        AddNode(OpCode::JMP);
-        
-        ByteNode* jumpIndexNode = new ByteNode(0, 8);
-        byteList.add(jumpIndexNode);
+        Emit(OpCode::JMP);
 
-        controlFlowNodes.emplace_back(jumpIndexNode, token->opCode);
+        // the jump target is set by the loop this statement belongs to
+        controlFlowNodes.emplace_back(byteList.addJumpTarget(), token->opCode);
 
         return 0;
     }
@@ -1,6 +1,7 @@
 #include "syntax_tree.hh"
 #include "errors.hh"
 #include "symbol_table.hh"
+#include "context.hh"
 #include "keywords.hh"
 
 
@@ -20,21 +21,19 @@ static const char* const sides[2] =
 };
 
 
-#define DELETE true
-
 using namespace Tokens;
 using namespace syntax_tree;
 using namespace symbol_table;
 
 
-static inline void assertToken(Token* caller, Token* got, TokenType required, Side side)
+static inline void assertToken(Token* caller, Token* got, TokenType required, Side side, const SymbolTable& symbolTable)
 {
     if (got == nullptr)
     {
         errors::ExpectedTokenError(*caller, required, sides[side]);
     }
     
-    if (!isCompatible(tokenTypeOf(got), required))
+    if (!isCompatible(tokenTypeOf(got, symbolTable), required))
     {
         errors::TypeError(*caller, required, *got, sides[side]);
     }
@@ -65,7 +64,7 @@ static inline void assertToken(Token* caller, Token* got, OpCodes required, Side
 }
 
 
-static void binarySatisfy(Token* token, TokenType leftType, TokenType rightType, Statement* statement)
+static void binarySatisfy(Token* token, TokenType leftType, TokenType rightType, Statement* statement, compilation::Context& context)
 {
 
     if (token->prev == nullptr)
@@ -77,19 +76,19 @@ static void binarySatisfy(Token* token, TokenType leftType, TokenType rightType,
         errors::ExpectedTokenError(*token, rightType, sides[RIGHT]);
     }
 
-    if (!isCompatible(tokenTypeOf(token->prev), leftType))
+    if (!isCompatible(tokenTypeOf(token->prev, context.symbolTable), leftType))
     {
        errors::TypeError(*token, leftType, *token->prev, sides[LEFT]);
     }
-    else if (!isCompatible(tokenTypeOf(token->next), rightType))
+    else if (!isCompatible(tokenTypeOf(token->next, context.symbolTable), rightType))
     {
         errors::TypeError(*token, rightType, *token->next, sides[RIGHT]);
     }
 
     // pointer to array of token pointers
-    token->value = toValue((new Token*[2] {token->prev, token->next}));
+    token->value = toValue(context.arena.makeArray<Token*>({ token->prev, token->next }));
 
-    token->type = tokenTypeOf(token->prev);
+    token->type = tokenTypeOf(token->prev, context.symbolTable);
 
     // remove tokens to the left and right
     statement->remove(token->prev);
@@ -98,7 +97,7 @@ static void binarySatisfy(Token* token, TokenType leftType, TokenType rightType,
 }
 
 
-static void unarySatisfy(Token* token, TokenType type, Side side, Statement* statement)
+static void unarySatisfy(Token* token, TokenType type, Side side, Statement* statement, compilation::Context& context)
 {
 
     if (side == LEFT)
@@ -107,13 +106,13 @@ static void unarySatisfy(Token* token, TokenType type, Side side, Statement* sta
         {
             errors::ExpectedTokenError(*token, type, sides[LEFT]);
         }
-        if (!isCompatible(tokenTypeOf(token->prev), type))
+        if (!isCompatible(tokenTypeOf(token->prev, context.symbolTable), type))
         {
             errors::TypeError(*token, type, *token->prev, sides[LEFT]);
         }
 
-        token->value = toValue(new Token*[1] {token->prev});
-        token->type = tokenTypeOf(token->prev);
+        token->value = toValue(context.arena.makeArray<Token*>({ token->prev }));
+        token->type = tokenTypeOf(token->prev, context.symbolTable);
 
         statement->remove(token->prev);
 
@@ -124,13 +123,13 @@ static void unarySatisfy(Token* token, TokenType type, Side side, Statement* sta
         {
             errors::ExpectedTokenError(*token, type, sides[RIGHT]);
         }
-        if (!isCompatible(tokenTypeOf(token->next), type))
+        if (!isCompatible(tokenTypeOf(token->next, context.symbolTable), type))
         {
             errors::TypeError(*token, type, *token->next, sides[RIGHT]);
         }
 
-        token->value = toValue(new Token*[1] {token->next});
-        token->type = tokenTypeOf(token->next);
+        token->value = toValue(context.arena.makeArray<Token*>({ token->next }));
+        token->type = tokenTypeOf(token->next, context.symbolTable);
 
         statement->remove(token->next);
 
@@ -140,49 +139,46 @@ static void unarySatisfy(Token* token, TokenType type, Side side, Statement* sta
 
 
 
-static void declarationSatisfy(Token* token, TokenType type, Statement* statement)
+static void declarationSatisfy(Token* token, TokenType type, Statement* statement, compilation::Context& context)
 {
     assertToken(token, token->next, OpCodes::REFERENCE, RIGHT);
 
     // inherit value form next Token (variable's name)
     token->value = token->next->value;
+    token->name = token->next->name;
     // type is the TokenType that has been declared
     token->type = type;
 
-    // set next Token's opCode to NO_OP so that the std::string value
-    // does not get deleted when the token does
-    token->next->opCode = OpCodes::NO_OP;
-
-    // remove and delete the next Token since it won't be used anymore
-    statement->remove(token->next, DELETE);
+    // remove the next Token since it won't be used anymore
+    statement->remove(token->next);
 
     token->opCode = OpCodes::REFERENCE;
 
-    SymbolTable::declare(
-        (std::string*) token->value,
+    context.symbolTable.declare(
+        (interner::StringId) token->value,
         new Symbol(0, token->type)
     );
 
 }
 
 
-static void assignSatisfy(Token* token, Statement* statement)
+static void assignSatisfy(Token* token, Statement* statement, compilation::Context& context)
 {
 
-    TokenType type = tokenTypeOf(token->prev);
+    TokenType type = tokenTypeOf(token->prev, context.symbolTable);
 
     assertToken(token, token->prev, OpCodes::REFERENCE, LEFT);
-    assertToken(token, token->next, type, RIGHT);
+    assertToken(token, token->next, type, RIGHT, context.symbolTable);
 
     // set token's value to an array of its operands
-    token->value = toValue((new Token*[2] {token->prev, token->next}));
+    token->value = toValue(context.arena.makeArray<Token*>({ token->prev, token->next }));
 
     Value newValue;
 
     // check if other token is also a reference and consequently get its value from the symbol table
     if (token->next->opCode == OpCodes::REFERENCE)
     {
-        newValue = SymbolTable::get((std::string*) token->next->value)->value;
+        newValue = context.symbolTable.get((interner::StringId) token->next->value)->value;
     }
     else
     {
@@ -190,8 +186,8 @@ static void assignSatisfy(Token* token, Statement* statement)
     }
 
     // update symbol table
-    SymbolTable::assign(
-        (std::string*) token->prev->value,
+    context.symbolTable.assign(
+        (interner::StringId) token->prev->value,
         newValue
     );
 
@@ -206,24 +202,24 @@ static void assignSatisfy(Token* token, Statement* statement)
 
 
 // increment ++, decrement -- operators
-static void incDecSatisfy(Token* token, Statement* statement)
+static void incDecSatisfy(Token* token, Statement* statement, compilation::Context& context)
 {
     assertToken(token, token->prev, OpCodes::REFERENCE, LEFT);
 
-    token->value = toValue(new Token*[1] { token->prev });
-    token->type = tokenTypeOf(token->prev);
+    token->value = toValue(context.arena.makeArray<Token*>({ token->prev }));
+    token->type = tokenTypeOf(token->prev, context.symbolTable);
 
     statement->remove(token->prev);
 
 }
 
 
-static void addressOfSatisfy(Token* token, Statement* statement)
+static void addressOfSatisfy(Token* token, Statement* statement, compilation::Context& context)
 {
     assertToken(token, token->next, OpCodes::REFERENCE, RIGHT);
     
-    token->value = toValue(new Token*[1] { token->next });
-    token->type = tokenTypeOf(token->next);
+    token->value = toValue(context.arena.makeArray<Token*>({ token->next }));
+    token->type = tokenTypeOf(token->next, context.symbolTable);
 
     statement->remove(token->next);
 }
@@ -240,20 +236,17 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
     {
     case OpCodes::ARITHMETICAL_SUM:
     {
-        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement);
+        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement, *context);
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             Token* op1 = ((Token**) (token->value))[0];
             Token* op2 = ((Token**) (token->value))[1];
 
             if (op1->opCode == OpCodes::LITERAL && op2->opCode == OpCodes::LITERAL)
             {
-                delete[] (Token**) token->value;
                 token->value = op1->value + op2->value;
                 token->opCode = OpCodes::LITERAL;
-                delete op1;
-                delete op2;
             }
         }
 
@@ -262,20 +255,17 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
     case OpCodes::ARITHMETICAL_SUB:
     {
-        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement);
+        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement, *context);
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             Token* op1 = ((Token**) (token->value))[0];
             Token* op2 = ((Token**) (token->value))[1];
 
             if (op1->opCode == OpCodes::LITERAL && op2->opCode == OpCodes::LITERAL)
             {
-                delete[] (Token**) token->value;
                 token->value = op1->value - op2->value;
                 token->opCode = OpCodes::LITERAL;
-                delete op1;
-                delete op2;
             }
         }
 
@@ -284,9 +274,9 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
     case OpCodes::ARITHMETICAL_MUL:
     {
-        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement);
+        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement, *context);
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             Token* op1 = ((Token**) (token->value))[0];
             Token* op2 = ((Token**) (token->value))[1];
@@ -295,20 +285,14 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
             if ((op1->opCode == OpCodes::LITERAL && op1->value == 0)
                 || (op2->opCode == OpCodes::LITERAL && op2->value == 0))
             {
-                delete[] (Token**) token->value;
                 token->value = 0;
                 token->opCode = OpCodes::LITERAL;
-                delete op1;
-                delete op2;
             }
 
             if (op1->opCode == OpCodes::LITERAL && op2->opCode == OpCodes::LITERAL)
             {
-                delete[] (Token**) token->value;
                 token->value = op1->value * op2->value;
                 token->opCode = OpCodes::LITERAL;
-                delete op1;
-                delete op2;
             }
         }
 
@@ -317,9 +301,9 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
     case OpCodes::ARITHMETICAL_DIV:
     {
-        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement);
+        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement, *context);
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             Token* op1 = ((Token**) (token->value))[0];
             Token* op2 = ((Token**) (token->value))[1];
@@ -331,11 +315,8 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
             if (op1->opCode == OpCodes::LITERAL && op2->opCode == OpCodes::LITERAL)
             {
-                delete[] (Token**) token->value;
                 token->value = op1->value / op2->value;
                 token->opCode = OpCodes::LITERAL;
-                delete op1;
-                delete op2;
             }
         }
 
@@ -344,34 +325,31 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
     case OpCodes::ARITHMETICAL_POW:
     {
-        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement);
+        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement, *context);
         break;
     }
 
     case OpCodes::ARITHMETICAL_INC:
     case OpCodes::ARITHMETICAL_DEC:
     {
-        incDecSatisfy(token, statement);
+        incDecSatisfy(token, statement, *context);
         break;
     }
 
 
     case OpCodes::LOGICAL_EQ:
     {
-        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement);
+        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement, *context);
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             Token* op1 = ((Token**) (token->value))[0];
             Token* op2 = ((Token**) (token->value))[1];
 
             if (op1->opCode == OpCodes::LITERAL && op2->opCode == OpCodes::LITERAL)
             {
-                delete[] (Token**) token->value;
                 token->value = op1->value == op2->value;
                 token->opCode = OpCodes::LITERAL;
-                delete op1;
-                delete op2;
             }
         }
 
@@ -380,20 +358,17 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
     case OpCodes::LOGICAL_NOT_EQ:
     {
-        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement);
+        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement, *context);
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             Token* op1 = ((Token**) (token->value))[0];
             Token* op2 = ((Token**) (token->value))[1];
 
             if (op1->opCode == OpCodes::LITERAL && op2->opCode == OpCodes::LITERAL)
             {
-                delete[] (Token**) token->value;
                 token->value = op1->value != op2->value;
                 token->opCode = OpCodes::LITERAL;
-                delete op1;
-                delete op2;
             }
         }
 
@@ -402,20 +377,17 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
     case OpCodes::LOGICAL_AND:
     {
-        binarySatisfy(token, TokenType::BOOL, TokenType::BOOL, statement);
+        binarySatisfy(token, TokenType::BOOL, TokenType::BOOL, statement, *context);
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             Token* op1 = ((Token**) (token->value))[0];
             Token* op2 = ((Token**) (token->value))[1];
 
             if (op1->opCode == OpCodes::LITERAL && op2->opCode == OpCodes::LITERAL)
             {
-                delete[] (Token**) token->value;
                 token->value = op1->value && op2->value;
                 token->opCode = OpCodes::LITERAL;
-                delete op1;
-                delete op2;
             }
         }
 
@@ -424,20 +396,17 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
     case OpCodes::LOGICAL_OR:
     {
-        binarySatisfy(token, TokenType::BOOL, TokenType::BOOL, statement);
+        binarySatisfy(token, TokenType::BOOL, TokenType::BOOL, statement, *context);
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             Token* op1 = ((Token**) (token->value))[0];
             Token* op2 = ((Token**) (token->value))[1];
 
             if (op1->opCode == OpCodes::LITERAL && op2->opCode == OpCodes::LITERAL)
             {
-                delete[] (Token**) token->value;
                 token->value = op1->value || op2->value;
                 token->opCode = OpCodes::LITERAL;
-                delete op1;
-                delete op2;
             }
         }
 
@@ -446,20 +415,17 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
     case OpCodes::LOGICAL_LESS:
     {
-        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement);
+        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement, *context);
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             Token* op1 = ((Token**) (token->value))[0];
             Token* op2 = ((Token**) (token->value))[1];
 
             if (op1->opCode == OpCodes::LITERAL && op2->opCode == OpCodes::LITERAL)
             {
-                delete[] (Token**) token->value;
                 token->value = op1->value < op2->value;
                 token->opCode = OpCodes::LITERAL;
-                delete op1;
-                delete op2;
             }
         }
 
@@ -468,20 +434,17 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
     case OpCodes::LOGICAL_LESS_EQ:
     {
-        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement);
+        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement, *context);
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             Token* op1 = ((Token**) (token->value))[0];
             Token* op2 = ((Token**) (token->value))[1];
 
             if (op1->opCode == OpCodes::LITERAL && op2->opCode == OpCodes::LITERAL)
             {
-                delete[] (Token**) token->value;
                 token->value = op1->value <= op2->value;
                 token->opCode = OpCodes::LITERAL;
-                delete op1;
-                delete op2;
             }
         }
 
@@ -490,20 +453,17 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
     case OpCodes::LOGICAL_GREATER:
     {
-        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement);
+        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement, *context);
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             Token* op1 = ((Token**) (token->value))[0];
             Token* op2 = ((Token**) (token->value))[1];
 
             if (op1->opCode == OpCodes::LITERAL && op2->opCode == OpCodes::LITERAL)
             {
-                delete[] (Token**) token->value;
                 token->value = op1->value > op2->value;
                 token->opCode = OpCodes::LITERAL;
-                delete op1;
-                delete op2;
             }
         }
 
@@ -512,20 +472,17 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
     case OpCodes::LOGICAL_GREATER_EQ:
     {
-        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement);
+        binarySatisfy(token, TokenType::NUMERIC, TokenType::NUMERIC, statement, *context);
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             Token* op1 = ((Token**) (token->value))[0];
             Token* op2 = ((Token**) (token->value))[1];
 
             if (op1->opCode == OpCodes::LITERAL && op2->opCode == OpCodes::LITERAL)
             {
-                delete[] (Token**) token->value;
                 token->value = op1->value >= op2->value;
                 token->opCode = OpCodes::LITERAL;
-                delete op1;
-                delete op2;
             }
         }
 
@@ -534,18 +491,16 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
     
     case OpCodes::LOGICAL_NOT:
     {
-        unarySatisfy(token, TokenType::BOOL, RIGHT, statement);
+        unarySatisfy(token, TokenType::BOOL, RIGHT, statement, *context);
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             Token* op = ((Token**) (token->value))[0];
 
             if (op->opCode == OpCodes::LITERAL)
             {
-                delete[] (Token**) token->value;
                 token->value = !(bool) op->value;
                 token->opCode = OpCodes::LITERAL;
-                delete op;
             }
         }
 
@@ -555,7 +510,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
     case OpCodes::ADDRESS_OF:
     {
-        addressOfSatisfy(token, statement);
+        addressOfSatisfy(token, statement, *context);
         break;
     }
 
@@ -567,37 +522,37 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
     case OpCodes::ASSIGNMENT_POW:
     case OpCodes::ASSIGNMENT_MUL:
     {
-        assignSatisfy(token, statement);
+        assignSatisfy(token, statement, *context);
         break;
     }
 
 
     case OpCodes::DECLARATION_INT:
-        declarationSatisfy(token, TokenType::INT, statement);
+        declarationSatisfy(token, TokenType::INT, statement, *context);
         break;
 
     case OpCodes::DECLARATION_STRING:
-        declarationSatisfy(token, TokenType::STRING, statement);
+        declarationSatisfy(token, TokenType::STRING, statement, *context);
         break;
 
     case OpCodes::DECLARATION_FLOAT:
-        declarationSatisfy(token, TokenType::FLOAT, statement);
+        declarationSatisfy(token, TokenType::FLOAT, statement, *context);
         break;
 
     case OpCodes::DECLARATION_DOUBLE:
-        declarationSatisfy(token, TokenType::DOUBLE, statement);
+        declarationSatisfy(token, TokenType::DOUBLE, statement, *context);
         break;
 
     case OpCodes::DECLARATION_LONG:
-        declarationSatisfy(token, TokenType::LONG, statement);
+        declarationSatisfy(token, TokenType::LONG, statement, *context);
         break;
 
     case OpCodes::DECLARATION_BOOL:
-        declarationSatisfy(token, TokenType::BOOL, statement);
+        declarationSatisfy(token, TokenType::BOOL, statement, *context);
         break;
     
     case OpCodes::DECLARATION_BYTE:
-        declarationSatisfy(token, TokenType::BYTE, statement);
+        declarationSatisfy(token, TokenType::BYTE, statement, *context);
         break;
     
     case OpCodes::DECLARATION_VOID:
@@ -619,11 +574,11 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         // if would have no effect on the program
         if (token->next->opCode == OpCodes::POP_SCOPE)
         {
-            statement->remove(token->next, DELETE);
+            statement->remove(token->next);
             // set the token's value to an empty SyntaxTree
             // no need to parse it to byte code since its byte list is empty
             // don't just remove it since it may be needed by other operators to work
-            token->value = toValue(new SyntaxTree());
+            token->value = toValue(context->addScopeTree(std::make_unique<SyntaxTree>()));
             break;
         }
 
@@ -634,13 +589,13 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         if (token->opCode == OpCodes::PUSH_SCOPE)
         {
             // first push the scope to the SymbolTable
-            SymbolTable::pushScope(DO_INHERIT);
+            context->symbolTable.pushScope(DO_INHERIT);
         }
 
 
         // transfer the part of the statement which is in the new scope
         // to another statement
-        Statement* scopeStatement = new Statement(token->next);
+        Statement* scopeStatement = context->arena.make<Statement>(token->next);
         scopeStatement->next = statement->next;
         
         // set previous token to null since this is the beginning of the statement
@@ -662,8 +617,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
                 // check if the statement actually exists
                 if (scopeStatement == nullptr)
                 {
-                    std::cerr << "Missing closing scope because next statement is missing" << std::endl;
-                    exit(1);
+                    errors::MissingClosingScopeError(*token);
                 }
 
                 tok = scopeStatement->root;
@@ -698,18 +652,14 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
                         tok->prev->next = nullptr;
                     }
 
-                    // delete closing scope token since it won't be used anymore
-                    delete tok;
-
                     // make the outer Statement linked list (Statements)
                     // continue from the next statement
                     statement->next = scopeStatement->next;
 
-                    // if statement's root is the newly deleted token --> delete it
+                    // if statement's root is the closing scope token --> drop the statement
                     if (scopeStatement->root == tok)
                     {
                         scopeStatements.removeLast();
-                        delete scopeStatement;
                     }
                     // whereas if the statement isn't empty
                     else
@@ -724,7 +674,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         }
         
         // create a new SyntaxTree for the scope
-        SyntaxTree* scopeTree = new SyntaxTree(std::move(scopeStatements));
+        SyntaxTree* scopeTree = context->addScopeTree(std::make_unique<SyntaxTree>(std::move(scopeStatements), context));
 
         scopeTree->parseToByteCodePrivate(); 
 
@@ -732,7 +682,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         // function bodies are popped by the function declaration operator
         if (token->opCode == OpCodes::PUSH_SCOPE)
         {     
-            SymbolTable::popScope();
+            context->symbolTable.popScope();
         }
 
         // don't use a Token** since it would be superflous
@@ -748,8 +698,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         Token* content = token->next;
         if (content == nullptr)
         {
-            std::cerr << "Missing statement inside parenthesis" << std::endl;
-            exit(1);
+            errors::MissingStatementError(*token, "Missing statement inside parenthesis");
         }
 
         // check for closing parenthesis
@@ -759,28 +708,25 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
             errors::MissingClosingParenthesisError(*token, "");
         }
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             // transform parenthesis into its content
             copyRelevantData(token, content);
 
-            // to prevent token's destructor from deleting eventual stuff pointed by its value
-            content->opCode = OpCodes::NO_OP;
-
-            statement->remove(content, DELETE),
-            statement->remove(closing, DELETE);
+            statement->remove(content),
+            statement->remove(closing);
 
             break;
         }
 
         // parenthesis' value is it's content
-        token->value = toValue(new Token*[1] { content });
+        token->value = toValue(context->arena.makeArray<Token*>({ content }));
 
         // set parenthesis' type to it's content's
-        token->type = tokenTypeOf(content);
+        token->type = tokenTypeOf(content, context->symbolTable);
 
         statement->remove(content);
-        statement->remove(closing, DELETE);
+        statement->remove(closing);
 
         break;
     }
@@ -789,7 +735,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
     case OpCodes::FLOW_IF:
     {
         Token* condition = token->next;
-        assertToken(token, condition, TokenType::BOOL, RIGHT);
+        assertToken(token, condition, TokenType::BOOL, RIGHT, context->symbolTable);
 
         Token* body = condition->next;
 
@@ -797,7 +743,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         assertToken(condition, body, OpCodes::PUSH_SCOPE, RIGHT);
         
 
-        if (globals::doOptimize)
+        if (context->optimize)
         {
             // remove branch or condition checking if condition's value is known at compile time
             if (
@@ -808,17 +754,17 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
                 if (
                     (condition->opCode == OpCodes::LITERAL && condition->value == 0)
                     || (condition->opCode == OpCodes::REFERENCE
-                        && SymbolTable::get((std::string*) condition->value)->value == 0)
+                        && context->symbolTable.get((interner::StringId) condition->value)->value == 0)
                     )
                 {
                     // remove branch since it's always false
-                    statement->remove(condition, DELETE);
+                    statement->remove(condition);
 
-                    // group all statements inside the body to delete them
+                    // group all statements inside the body to discard them
                     satisfyToken(statement, body);
 
-                    statement->remove(body, DELETE);
-                    statement->remove(token, DELETE);
+                    statement->remove(body);
+                    statement->remove(token);
 
                     break;
                 }
@@ -828,11 +774,8 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
                 // if condition is true transform token into its body (Token holding a SyntaxTree)
                 copyRelevantData(token, body);
                 
-                // set body's opCode to NO_OP to prevent it from deleting its Syntax Tree 
-                // when its destructor is called
-                body->opCode = OpCodes::NO_OP;
-                statement->remove(body, DELETE);
-                statement->remove(condition, DELETE);
+                statement->remove(body);
+                statement->remove(condition);
 
                 break;
             }
@@ -842,7 +785,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         satisfyToken(statement, body);
 
         // set if token's value to an array of its boolean condition and its body
-        token->value = toValue((new Token*[2] { condition, body }));
+        token->value = toValue(context->arena.makeArray<Token*>({ condition, body }));
 
         // remove operands from the statement (this)
         statement->remove(condition);
@@ -855,7 +798,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
     case OpCodes::FLOW_WHILE:
     {
         Token* condition = token->next;
-        assertToken(token, condition, TokenType::BOOL, RIGHT);
+        assertToken(token, condition, TokenType::BOOL, RIGHT, context->symbolTable);
 
         Token* body = condition->next;
 
@@ -868,7 +811,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         satisfyToken(statement, body);
 
         // set if token's value to an array of its boolean condition and its body
-        token->value = toValue((new Token*[2] { condition, body }));
+        token->value = toValue(context->arena.makeArray<Token*>({ condition, body }));
 
         // remove operands from the statement (this)
         statement->remove(condition);
@@ -885,8 +828,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         // check if body exists
         if (body == nullptr)
         {
-            std::cerr << "Missing else statement's body" << std::endl;
-            exit(1);
+            errors::MissingStatementError(*token, "Missing body of else statement");
         }
 
         // do not add "if" statements as leaves
@@ -895,7 +837,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
             break;
         }
 
-        token->value = toValue(new Token*[1] { body });
+        token->value = toValue(context->arena.makeArray<Token*>({ body }));
 
         statement->remove(body);
 
@@ -905,8 +847,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 
     case OpCodes::FLOW_FOR:
     {
-        std::cerr << "not implemented" << std::endl;
-        exit(EXIT_FAILURE);
+        errors::NotImplementedError(*token);
         break;
     }
 
@@ -914,7 +855,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
     case OpCodes::SYSTEM:
     case OpCodes::SYSTEM_LOAD:
     {
-        unarySatisfy(token, TokenType::INT, RIGHT, statement);
+        unarySatisfy(token, TokenType::INT, RIGHT, statement, *context);
         break;
     }
 
@@ -925,7 +866,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         assertToken(token, name, OpCodes::REFERENCE, LEFT);
 
         Token* returnType = name->prev;
-        assertToken(name, returnType, TokenType::KEYWORD, LEFT);
+        assertToken(name, returnType, TokenType::KEYWORD, LEFT, context->symbolTable);
         
         // TODO get eventual modifiers
 
@@ -934,7 +875,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         auto params = std::vector<Parameter>();
 
         // push the new scope the parameters will belong to
-        SymbolTable::pushScope(DONT_INHERIT);
+        context->symbolTable.pushScope(DONT_INHERIT);
 
         // extract parameters
         Token* tok = token->next;
@@ -966,25 +907,22 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
                 declarationSatisfy(
                     tok,
                     keywords::declarationType(tok->opCode),
-                    statement
+                    statement,
+                    *context
                 );
 
                 // create a new Parameter object that will represent the just declared
                 // parameter in the symbol table.
-                // the symbol name's string is moved since it won't be used anymore by the token
                 params.emplace_back(
                     Parameter(
                         Symbol(0, tok->type),
-                        std::move(*(std::string*) tok->value)
+                        (interner::StringId) tok->value
                     )
                 );
                 
-                // to prevent token destructor from deleting string value
-                // set the op code to NO_OP (whose destructor does nothing)
-                tok->opCode = OpCodes::NO_OP;
                 Token* tmpTok = tok->next;
 
-                statement->remove(tok, DELETE);
+                statement->remove(tok);
 
                 tok = tmpTok; 
 
@@ -1001,7 +939,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         {
             errors::MissingClosingParenthesisError(
                 *token,
-                std::string("Function named ") + *(std::string*) name->value
+                std::string("Function named ") + context->interner.get((interner::StringId) name->value)
                     + " is missing closing parenthesis in function call");
         }
 
@@ -1017,7 +955,7 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         satisfyToken(statement, body);
 
         // pop the function's body's scope
-        SymbolTable::popScope();
+        context->symbolTable.popScope();
 
 
         Function* function = new Function(
@@ -1027,26 +965,22 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
         );
 
         // declare the function in the outer (usually global) scope
-        SymbolTable::declare(
-            (std::string*) name->value,
+        context->symbolTable.declare(
+            (interner::StringId) name->value,
             new Symbol(toValue(function), TokenType::FUNCTION)
         );
 
-        // delete tokens since they won't be needed anymore
+        // remove tokens since they won't be needed anymore
         
-        statement->remove(returnType, DELETE);
+        statement->remove(returnType);
 
-        // name is a TEXT token (hold a heap-allocated std::string* as value)
-        // changing its op code to NO_OP prevents the string to be deleted in the
-        // token's destructor
-        name->opCode = OpCodes::NO_OP;
-        statement->remove(name, DELETE);
+        statement->remove(name);
 
-        // remove and delete function declaration operator
-        statement->remove(token, DELETE);
+        // remove function declaration operator
+        statement->remove(token);
 
-        // remove and delete closing parenthesis token
-        statement->remove(tok, DELETE);
+        // remove closing parenthesis token
+        statement->remove(tok);
 
         break;
     }
@@ -1057,19 +991,119 @@ void SyntaxTree::satisfyToken(Statement* statement, Token* token)
 }
 
 
-void SyntaxTree::parseStatement(Statement* statement)
+// a Token of a statement waiting to be satisfied
+typedef struct Candidate
 {
-    for (
-        Tokens::Token* root = getHighestPriority(statement->root);
-        // 0 priority or less means the statement has finished evaluating
-        root != nullptr && root->priority > 0;
-        root = getHighestPriority(statement->root)
-        )
-    {          
+    Token* token;
+
+    // the Token's priority when it was added, since satisfied Tokens get a 0 priority
+    size_t priority;
+
+    bool isFunctionDeclaration;
 
-        // evaluate the Token, satisfy its requirements, declare eventual symbols   
-        satisfyToken(statement, root);
+    // order of the Token in the statement, leftmost Tokens have lower positions
+    size_t position;
+
+} Candidate;
+
+
+// orders Candidates so that the first one to satisfy is at the top of the queue
+typedef struct CandidateOrder
+{
+    bool operator()(const Candidate& a, const Candidate& b) const
+    {
+        if (a.isFunctionDeclaration != b.isFunctionDeclaration)
+        {
+            return b.isFunctionDeclaration;
+        }
 
+        if (a.priority != b.priority)
+        {
+            return a.priority < b.priority;
+        }
+
+        return a.position > b.position;
+    }
+
+} CandidateOrder;
+
+
+// whether the Token hasn't been removed from the statement
+// Statement::remove() unlinks a Token from its neighbours, but not vice versa
+static inline bool isInStatement(const Token* token, const Statement* statement)
+{
+    if (token->prev == nullptr)
+    {
+        return token == statement->root;
     }
+
+    return token->prev->next == token;
 }
 
+
+void SyntaxTree::parseStatement(Statement* statement)
+{
+    std::priority_queue<Candidate, std::vector<Candidate>, CandidateOrder> candidates;
+
+    // first scope of the statement that hasn't been satisfied yet
+    // a scope's content must not be evaluated before the scope operator,
+    // so Tokens past it are added only once it's been satisfied
+    Token* scope = nullptr;
+
+    // next Token to add to the candidates
+    Token* next = statement->root;
+    size_t position = 0;
+
+    while (true)
+    {
+        // resume from the Token after the scope once it has been satisfied
+        if (scope != nullptr && (scope->priority == 0 || !isInStatement(scope, statement)))
+        {
+            next = scope->next;
+            scope = nullptr;
+        }
+
+        if (scope == nullptr)
+        {
+            for (; next != nullptr; next = next->next)
+            {
+                // 0 priority Tokens will never be satisfied
+                if (next->priority == 0)
+                {
+                    continue;
+                }
+
+                candidates.push({
+                    next,
+                    next->priority,
+                    next->opCode == OpCodes::FUNC_DECLARARION,
+                    position ++
+                });
+
+                if (next->opCode == OpCodes::PUSH_SCOPE)
+                {
+                    scope = next;
+                    break;
+                }
+            }
+        }
+
+        // no Tokens left, the statement has finished evaluating
+        if (candidates.empty())
+        {
+            break;
+        }
+
+        Token* token = candidates.top().token;
+        candidates.pop();
+
+        // skip Tokens that have already been satisfied or removed by other operators
+        if (token->priority == 0 || !isInStatement(token, statement))
+        {
+            continue;
+        }
+
+        // evaluate the Token, satisfy its requirements, declare eventual symbols
+        satisfyToken(statement, token);
+    }
+}
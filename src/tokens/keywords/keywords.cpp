@@ -1,12 +1,27 @@
 #include "keywords.hh"
 #include "errors.hh"
 
+#include <array>
+
 
 using namespace keywords;
 
 
-const std::unordered_map<std::string, OpCodes> keywords::keywordsMap
-({
+// size of the perfect hash table of the Words, a power of 2
+#define WORD_TABLE_SIZE 32
+
+
+// perfect for the Words below, no two of them have the same hash
+// adding a Word may require different factors, the table doesn't compile
+// until no two Words collide
+static constexpr size_t wordHash(std::string_view word)
+{
+    return ((unsigned char) word.front() + 7 * (unsigned char) word.back() + 10 * word.size()) & (WORD_TABLE_SIZE - 1);
+}
+
+
+static constexpr Word words[] =
+{
     {"if",      OpCodes::FLOW_IF},
     {"else",    OpCodes::FLOW_ELSE},
     {"while",   OpCodes::FLOW_WHILE},
@@ -22,8 +37,36 @@ const std::unordered_map<std::string, OpCodes> keywords::keywordsMap
     {"system",  OpCodes::SYSTEM},
     {"sysload", OpCodes::SYSTEM_LOAD},
     {"break",   OpCodes::BREAK},
-    {"continue",OpCodes::CONTINUE}
-});
+    {"continue",OpCodes::CONTINUE},
+
+    // predefined values
+    {"true",    OpCodes::NO_OP, 1, Tokens::TokenType::BOOL},
+    {"false",   OpCodes::NO_OP, 0, Tokens::TokenType::BOOL},
+};
+
+
+static constexpr std::array<Word, WORD_TABLE_SIZE> makeWordTable()
+{
+    std::array<Word, WORD_TABLE_SIZE> table = {};
+
+    for (const Word& word : words)
+    {
+        Word& slot = table[wordHash(word.text)];
+
+        if (!slot.text.empty())
+        {
+            throw "two Words have the same hash, change the factors of wordHash()";
+        }
+
+        slot = word;
+    }
+
+    return table;
+}
+
+
+// Words indexed by their hash, the other slots are empty
+static constexpr std::array<Word, WORD_TABLE_SIZE> wordTable = makeWordTable();
 
 
 // switch statements maps
@@ -121,27 +164,12 @@ int keywords::keywordPriority(OpCodes keyword)
 }
 
 
-OpCodes keywords::isKeyword(std::string const& word)
+const Word* keywords::findWord(std::string_view word)
 {
-    auto keyword = keywordsMap.find(word);
-    if (keyword == keywordsMap.end())
-    {
-        return OpCodes::NO_OP;
-    }
-    return keyword->second;
-}
-
+    const Word& entry = wordTable[wordHash(word)];
 
-bool keywords::hasValue(std::string const& word, Value& value, Tokens::TokenType& type)
-{
-    auto val = keywordValues.find(word);
-    if (val == keywordValues.end())
-    {
-        return false;
-    }
-    value = val->second.value;
-    type = val->second.type;
-    return true;
+    // empty slots never match, names are never empty
+    return entry.text == word ? &entry : nullptr;
 }
 
 
@@ -0,0 +1,228 @@
+#include "scanner.hh"
+
+#include <array>
+
+#if SCANNER_SIMD
+    #include <immintrin.h>
+#endif
+
+
+using namespace scanner;
+
+
+// classes of characters, a character may belong to several of them
+typedef enum CharacterClass : unsigned char
+{
+    NAME = 1,
+    DIGIT = 2,
+    BLANK = 4,
+
+} CharacterClass;
+
+
+static constexpr std::array<unsigned char, 256> makeClassTable()
+{
+    std::array<unsigned char, 256> table = {};
+
+    for (int c = 'a'; c <= 'z'; c++)
+    {
+        table[c] |= NAME;
+        table[c - 'a' + 'A'] |= NAME;
+    }
+
+    for (int c = '0'; c <= '9'; c++)
+    {
+        table[c] |= NAME | DIGIT;
+    }
+
+    table['_'] |= NAME;
+
+    table[' '] |= BLANK;
+    table['\t'] |= BLANK;
+    table['\r'] |= BLANK;
+    table[','] |= BLANK;
+
+    return table;
+}
+
+
+// classes of every character, indexed by the character
+static constexpr std::array<unsigned char, 256> classTable = makeClassTable();
+
+
+static void classifyScalar(const char* chars, Block& block)
+{
+    block = Block { 0, 0, 0 };
+
+    for (size_t i = 0; i != SCANNER_BLOCK_SIZE; i++)
+    {
+        const uint64_t classes = classTable[(unsigned char) chars[i]];
+
+        block.name |= (classes & NAME) << i;
+        block.digit |= ((classes & DIGIT) >> 1) << i;
+        block.blank |= ((classes & BLANK) >> 2) << i;
+    }
+}
+
+
+#if SCANNER_SIMD
+
+
+// the characters in [low, high] have every bit set in the result
+// the range is moved to the bottom of the signed bytes, so that a single
+// signed comparison checks both bounds
+__attribute__((target("sse2")))
+static inline __m128i inRange16(__m128i chars, char low, char high)
+{
+    const __m128i shifted = _mm_add_epi8(chars, _mm_set1_epi8((char) (-128 - low)));
+    return _mm_cmplt_epi8(shifted, _mm_set1_epi8((char) (-128 + (high - low) + 1)));
+}
+
+
+__attribute__((target("sse2")))
+static void classifySse2(const char* chars, Block& block)
+{
+    block = Block { 0, 0, 0 };
+
+    for (size_t i = 0; i != SCANNER_BLOCK_SIZE; i += 16)
+    {
+        const __m128i vector = _mm_loadu_si128((const __m128i*) (chars + i));
+
+        // setting the case bit turns upper case letters into lower case ones
+        const __m128i lower = _mm_or_si128(vector, _mm_set1_epi8(0x20));
+
+        const __m128i digit = inRange16(vector, '0', '9');
+
+        const __m128i name = _mm_or_si128(
+            _mm_or_si128(inRange16(lower, 'a', 'z'), digit),
+            _mm_cmpeq_epi8(vector, _mm_set1_epi8('_'))
+        );
+
+        const __m128i blank = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(vector, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(vector, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(vector, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(vector, _mm_set1_epi8(',')))
+        );
+
+        block.name |= (uint64_t) (uint32_t) _mm_movemask_epi8(name) << i;
+        block.digit |= (uint64_t) (uint32_t) _mm_movemask_epi8(digit) << i;
+        block.blank |= (uint64_t) (uint32_t) _mm_movemask_epi8(blank) << i;
+    }
+}
+
+
+__attribute__((target("avx2")))
+static inline __m256i inRange32(__m256i chars, char low, char high)
+{
+    const __m256i shifted = _mm256_add_epi8(chars, _mm256_set1_epi8((char) (-128 - low)));
+    return _mm256_cmpgt_epi8(_mm256_set1_epi8((char) (-128 + (high - low) + 1)), shifted);
+}
+
+
+__attribute__((target("avx2")))
+static void classifyAvx2(const char* chars, Block& block)
+{
+    block = Block { 0, 0, 0 };
+
+    for (size_t i = 0; i != SCANNER_BLOCK_SIZE; i += 32)
+    {
+        const __m256i vector = _mm256_loadu_si256((const __m256i*) (chars + i));
+
+        const __m256i lower = _mm256_or_si256(vector, _mm256_set1_epi8(0x20));
+
+        const __m256i digit = inRange32(vector, '0', '9');
+
+        const __m256i name = _mm256_or_si256(
+            _mm256_or_si256(inRange32(lower, 'a', 'z'), digit),
+            _mm256_cmpeq_epi8(vector, _mm256_set1_epi8('_'))
+        );
+
+        const __m256i blank = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(vector, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(vector, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(vector, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(vector, _mm256_set1_epi8(',')))
+        );
+
+        block.name |= (uint64_t) (uint32_t) _mm256_movemask_epi8(name) << i;
+        block.digit |= (uint64_t) (uint32_t) _mm256_movemask_epi8(digit) << i;
+        block.blank |= (uint64_t) (uint32_t) _mm256_movemask_epi8(blank) << i;
+    }
+}
+
+
+#endif // SCANNER_SIMD
+
+
+// indexed by Isa
+static const Scanner scanners[] =
+{
+    { Isa::SCALAR, "scalar", classifyScalar },
+#if SCANNER_SIMD
+    { Isa::SSE2, "sse2", classifySse2 },
+    { Isa::AVX2, "avx2", classifyAvx2 },
+#endif
+};
+
+
+const Scanner* scanner::get(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::SCALAR:
+        return &scanners[(unsigned char) Isa::SCALAR];
+
+#if SCANNER_SIMD
+    // every x86-64 CPU has SSE2
+    case Isa::SSE2:
+        return &scanners[(unsigned char) Isa::SSE2];
+
+    case Isa::AVX2:
+        return __builtin_cpu_supports("avx2") ? &scanners[(unsigned char) Isa::AVX2] : nullptr;
+#endif
+
+    default:
+        return nullptr;
+    }
+}
+
+
+const Scanner& scanner::best()
+{
+    static const Scanner& fastest = []() -> const Scanner&
+    {
+        for (Isa isa : { Isa::AVX2, Isa::SSE2 })
+        {
+            if (const Scanner* scanner = get(isa))
+            {
+                return *scanner;
+            }
+        }
+
+        return *get(Isa::SCALAR);
+    }();
+
+    return fastest;
+}
+
+
+Cursor::Cursor(std::string_view text, const Scanner& scanner)
+: text(text.data()), size(text.size()), classify(scanner.classify), blockStart(SIZE_MAX), block()
+{
+
+}
+
+
+void Cursor::load(size_t offset)
+{
+    blockStart = offset;
+
+    if (size - offset >= SCANNER_BLOCK_SIZE)
+    {
+        classify(text + offset, block);
+        return;
+    }
+
+    // the last Block is padded with characters of no class
+    char padded[SCANNER_BLOCK_SIZE] = {};
+    memcpy(padded, text + offset, size - offset);
+
+    classify(padded, block);
+}
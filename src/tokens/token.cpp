@@ -1,5 +1,6 @@
 #include "token.hh"
 #include "keywords.hh"
+#include "errors.hh"
 
 
 using namespace Tokens;
@@ -19,23 +20,6 @@ Token::Token(TokenType type, size_t priority, OpCodes opCode)
 }
 
 
-Token::~Token()
-{
-    // NO OP tokens do not own any value
-    if (opCode == OpCodes::NO_OP)
-    {
-        return;
-    }
-
-    if (type == TokenType::TEXT || opCode == OpCodes::REFERENCE)
-    {
-        // text or reference tokens have a string as their value
-        delete (std::string*) value;
-    }
-  
-}
-
-
 std::ostream& operator<<(std::ostream& stream, Token const& token)
 {   
 
@@ -46,10 +30,9 @@ std::ostream& operator<<(std::ostream& stream, Token const& token)
     {
         switch (token.type)
         {
-        case TokenType::TEXT:
         case TokenType::STRING: 
         {
-            stream << '<' << token.type << ": " << *((std::string*) token.value)
+            stream << '<' << token.type << ": " << token.name
                 << " (" << token.priority << ")>";
             return stream;
         }
@@ -96,12 +79,12 @@ std::ostream& operator<<(std::ostream& stream, Token const& token)
         case TokenType::LONG:
         case TokenType::NUMERIC:
         case TokenType::BYTE:
-            stream << '<' << token.type << "*: " << *(std::string*) token.value
+            stream << '<' << token.type << "*: " << token.name
                 << " (" << token.priority << ")>";
             return stream;
         
         case TokenType::TEXT:
-            stream << '<' << TokenType::NONE << "*: " << *(std::string*) token.value
+            stream << '<' << TokenType::NONE << "*: " << token.name
                 << " (" << token.priority << ")>";
             return stream;
         }
@@ -223,9 +206,8 @@ std::ostream& operator<<(std::ostream& stream, Token const& token)
     } // switch (token.opCode)
 
     // if token hasn't been already handled, throw error
-    std::cerr << "Undefined Token: <type=" << token.type << ", value=" << token.value
-        << ", opCode=" << token.opCode << ", priority=" << token.priority << '>' << std::endl;
-    exit(EXIT_FAILURE);
+    errors::UndefinedTokenError(token);
+    return stream;
 }
 
 
@@ -248,5 +230,6 @@ void Tokens::copyRelevantData(Token* dest, const Token* src)
     dest->opCode = src->opCode;
     dest->type = src->type;
     dest->value = src->value;
+    dest->name = src->name;
 }
 
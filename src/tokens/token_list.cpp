@@ -1,4 +1,6 @@
 #include "token.hh"
+#include "context.hh"
+#include "preprocessor.hh"
 #include "op_codes.hh"
 #include "priorities.hh"
 #include "keywords.hh"
@@ -10,6 +12,12 @@ using namespace Tokens;
 
 #define AddToken() add(token); token = nullptr;
 
+// begins a new Token at the current character
+#define NewToken(...) \
+    token = arena.make<Token>(__VA_ARGS__); \
+    token->line = line; \
+    token->column = (uint32_t) (i - lineStart + 1)
+
 
 
 void TokenList::add(Token* token) 
@@ -29,8 +37,6 @@ void TokenList::add(Token* token)
 void TokenList::remove(Token* token)
 {
     Token::removeToken(token);
-
-    delete token;
 }
 
 
@@ -49,16 +55,44 @@ std::ostream& operator<<(std::ostream& stream, const TokenList& list)
 }
 
 
-TokenList::TokenList(std::string& script) 
+TokenList::TokenList(std::string_view script, compilation::Context& context, const preprocessor::Output* source) 
+: context(&context)
 {
+    arena::Arena& arena = context.arena;
+
+    // finds the ends of names, numbers and blanks
+    scanner::Cursor cursor(script, *context.scanner);
+
     Token* token = nullptr;
 
     size_t currentPriority = 0;
 
+    // location of the current character
+    uint32_t line = 1;
+    size_t lineStart = 0;
+
+    // next Piece of the preprocessor Output, where the line changes file
+    size_t nextPiece = 0;
+    const size_t pieceCount = source == nullptr ? 0 : source->getPieces().size();
+
 
     char c;
-    for (size_t i = 0; (c = script[i]) != 0; i++)
+    for (size_t i = 0; i != script.size() && (c = script[i]) != 0; i++)
     {
+        // the character after a newline begins a line
+        if (i != 0 && script[i - 1] == '\n')
+        {
+            line ++;
+            lineStart = i;
+        }
+
+        // the tokenizer may skip characters, so Pieces beginning before i are considered too
+        while (nextPiece != pieceCount && source->getOffsets()[nextPiece] <= i)
+        {
+            line = source->getPieces()[nextPiece].line;
+            lineStart = source->getOffsets()[nextPiece];
+            nextPiece ++;
+        }
 
         if (token != nullptr)
         {
@@ -137,21 +171,6 @@ TokenList::TokenList(std::string& script)
                         break;
                     } // case INT
 
-                    case TokenType::STRING: 
-                    {
-                
-                        // terminate string
-                        if (c == '"')
-                        {
-                            AddToken();
-                            continue;
-                        }
-
-                        // add character to string
-                        *((std::string*) token->value) += c;
-                        continue;
-                    } // case STRING
-
                 } // switch (token->type)
 
                 break;
@@ -167,48 +186,38 @@ TokenList::TokenList(std::string& script)
                     {
                         if (isText(c) || isDigit(c))
                         {
-                            // add character to string
-                            *((std::string*) token->value) += c;
                             continue;
                         }
 
                         // end of text token
-                        // check if text is a keyword
-                        OpCodes opCode = keywords::isKeyword(*(std::string*) token->value);
-                        if (opCode == OpCodes::NO_OP)
-                        {   
-                            // text is not an operator keyword
-                            // check if it has a predefined value
-
-                            // temporary variables
-                            Value _value; 
-                            TokenType _type;
-
-                            if (keywords::hasValue(*(std::string*) token->value, _value, _type))
-                            {
-                                token->type = _type;
-                                token->priority = LITERAL_P;
-                                token->opCode = OpCodes::LITERAL;
-
-                                // delete the string value since it won't be used anymore
-                                delete (std::string*) token->value;
-
-                                token->value = _value;
-                                AddToken();
-                                break;
-                            }
+                        // while being scanned, text tokens hold the index they begin at
+                        const std::string_view text(script.data() + token->value, i - token->value);
+
+                        const keywords::Word* const word = keywords::findWord(text);
 
+                        if (word == nullptr)
+                        {
                             // if word is not a keyword it's a reference
                             token->opCode = OpCodes::REFERENCE;
+                            token->value = context.interner.intern(text);
+                            token->name = context.interner.get((interner::StringId) token->value);
                             AddToken();
-                        } else {
-                            // if word is a keyword instead
-                            token->type = TokenType::KEYWORD;
-                            token->priority = keywords::keywordPriority(opCode) + currentPriority;
-                            token->opCode = opCode;
+                        }
+                        else if (word->keyword == OpCodes::NO_OP)
+                        {
+                            // the word has a predefined value
+                            token->type = word->type;
+                            token->priority = LITERAL_P;
+                            token->opCode = OpCodes::LITERAL;
 
-                            // delete the string value since it won't be used anymore
-                            delete (std::string*) token->value;
+                            token->value = word->value;
+                            AddToken();
+                        }
+                        else
+                        {
+                            token->type = TokenType::KEYWORD;
+                            token->priority = keywords::keywordPriority(word->keyword) + currentPriority;
+                            token->opCode = word->keyword;
 
                             AddToken();
                         }
@@ -367,80 +376,98 @@ TokenList::TokenList(std::string& script)
         {
         case '"':
         {
-            token = new Token(TokenType::STRING, LITERAL_P, OpCodes::LITERAL, toValue(new std::string("")));
+            NewToken(TokenType::STRING, LITERAL_P, OpCodes::LITERAL, 0);
+
+            // an unterminated literal runs to the end of the script
+            const size_t closing = std::min(script.find('"', i + 1), script.size());
+
+            // the literal views its characters in the script, nothing is copied
+            token->name = std::string_view(script.data() + i + 1, closing - i - 1);
+
+            // the loop skips the literal, so its newlines are counted here
+            for (size_t newline = script.find('\n', i + 1); newline < closing; newline = script.find('\n', newline + 1))
+            {
+                line ++;
+                lineStart = newline + 1;
+            }
+
+            AddToken();
+
+            // the loop moves past the closing quote, or stops at the end of the script
+            i = closing == script.size() ? closing - 1 : closing;
             continue;
         }
 
         case '+':
         {
-            token = new Token(TokenType::NONE, SUM_P + currentPriority, OpCodes::ARITHMETICAL_SUM);
+            NewToken(TokenType::NONE, SUM_P + currentPriority, OpCodes::ARITHMETICAL_SUM);
             continue;
         }
         
         case '-':
         {
-            token = new Token(TokenType::NONE, SUBTRACTION_P + currentPriority, OpCodes::ARITHMETICAL_SUB);
+            NewToken(TokenType::NONE, SUBTRACTION_P + currentPriority, OpCodes::ARITHMETICAL_SUB);
             continue;
         }
 
         case '*':
         {
-            token = new Token(TokenType::NONE, MULTIPLICATION_P + currentPriority, OpCodes::ARITHMETICAL_MUL);
+            NewToken(TokenType::NONE, MULTIPLICATION_P + currentPriority, OpCodes::ARITHMETICAL_MUL);
             continue;
         }
 
         case '/':
         {
-            token = new Token(TokenType::NONE, DIVISION_P + currentPriority, OpCodes::ARITHMETICAL_DIV);
+            NewToken(TokenType::NONE, DIVISION_P + currentPriority, OpCodes::ARITHMETICAL_DIV);
             continue;
         }
         
         case '^':
         {
-            token = new Token(TokenType::NONE, POWER_P + currentPriority, OpCodes::ARITHMETICAL_POW);
+            NewToken(TokenType::NONE, POWER_P + currentPriority, OpCodes::ARITHMETICAL_POW);
             continue;
         }
         
         case '=':
         {
-            token = new Token(TokenType::NONE, ASSIGNMENT_P + currentPriority, OpCodes::ASSIGNMENT_ASSIGN);
+            NewToken(TokenType::NONE, ASSIGNMENT_P + currentPriority, OpCodes::ASSIGNMENT_ASSIGN);
             continue;
         }
 
         case '&':
         {
-            token = new Token(TokenType::NONE, ADDRESS_OF_P + currentPriority, OpCodes::ADDRESS_OF);
+            NewToken(TokenType::NONE, ADDRESS_OF_P + currentPriority, OpCodes::ADDRESS_OF);
             continue;
         }
         
         case '|':
         {
-            token = new Token(TokenType::NONE, 0, OpCodes::NO_OP, '|');
+            NewToken(TokenType::NONE, 0, OpCodes::NO_OP, '|');
             continue;
         }
         
         case ';':
         {
-            token = new Token(TokenType::ENDS, LITERAL_P, OpCodes::NO_OP);
+            NewToken(TokenType::ENDS, LITERAL_P, OpCodes::NO_OP);
             AddToken();
             continue;
         }
         
         case '!':
         {
-            token = new Token(TokenType::NONE, NOT_P + currentPriority, OpCodes::LOGICAL_NOT);
+            NewToken(TokenType::NONE, NOT_P + currentPriority, OpCodes::LOGICAL_NOT);
             continue;
         }
 
         case '<':
         {
-            token = new Token(TokenType::NONE, COMPARISON_P + currentPriority, OpCodes::LOGICAL_LESS);
+            NewToken(TokenType::NONE, COMPARISON_P + currentPriority, OpCodes::LOGICAL_LESS);
             continue;
         }
 
         case '>':
         {
-            token = new Token(TokenType::NONE, COMPARISON_P + currentPriority, OpCodes::LOGICAL_GREATER);
+            NewToken(TokenType::NONE, COMPARISON_P + currentPriority, OpCodes::LOGICAL_GREATER);
             continue;
         }
         
@@ -449,14 +476,14 @@ TokenList::TokenList(std::string& script)
             // increment token priority to evaluate stuff in scope first
             currentPriority += SCOPE_P;
 
-            token = new Token(TokenType::SCOPE, currentPriority, OpCodes::PUSH_SCOPE);
+            NewToken(TokenType::SCOPE, currentPriority, OpCodes::PUSH_SCOPE);
             AddToken();
             continue;
         }
         
         case '}':
         {   
-            token = new Token(TokenType::SCOPE, currentPriority, OpCodes::POP_SCOPE);
+            NewToken(TokenType::SCOPE, currentPriority, OpCodes::POP_SCOPE);
 
             currentPriority -= SCOPE_P;
 
@@ -476,18 +503,18 @@ TokenList::TokenList(std::string& script)
                 if (isDeclarationOp(last->prev->opCode))
                 {
                     // function declaration (declaration operator before function name)
-                    token = new Token(TokenType::NONE, currentPriority, OpCodes::FUNC_DECLARARION);
+                    NewToken(TokenType::NONE, currentPriority, OpCodes::FUNC_DECLARARION);
                 }
                 else
                 {   
                     // function call (no declaration operator before function name)
-                    token = new Token(TokenType::NONE, currentPriority, OpCodes::CALL);
+                    NewToken(TokenType::NONE, currentPriority, OpCodes::CALL);
                 }
             }
             else
             {
                 // ordinary parenthesis
-                token = new Token(TokenType::PARENTHESIS, currentPriority, OpCodes::OPEN_PARENTHESIS, '(');
+                NewToken(TokenType::PARENTHESIS, currentPriority, OpCodes::OPEN_PARENTHESIS, '(');
             }
 
             AddToken();
@@ -500,18 +527,24 @@ TokenList::TokenList(std::string& script)
             currentPriority -= PARENTHESIS_P;
 
             // use a closing parentheis token for both ordinary parenthesis and function calls
-            token = new Token(TokenType::PARENTHESIS, 0, OpCodes::CLOSE_PARENTHESIS, ')');
+            NewToken(TokenType::PARENTHESIS, 0, OpCodes::CLOSE_PARENTHESIS, ')');
             
             AddToken();
             continue;
         }
 
-        case ' ':
         case '\n':
+        {
+            continue;
+        }
+
+        case ' ':
         case '\r':
         case '\t':
         case ',':
         {
+            // blanks come in runs, like indentation
+            i = cursor.skipBlanks(i + 1) - 1;
             continue;
         }
 
@@ -519,47 +552,47 @@ TokenList::TokenList(std::string& script)
         {
             if (isDigit(c))
             {
-                token = new Token(TokenType::NUMERIC, LITERAL_P, OpCodes::LITERAL, toDigit(c));
+                NewToken(TokenType::NUMERIC, LITERAL_P, OpCodes::LITERAL, toDigit(c));
+
+                // the rest of the digits are added at once, the character
+                // after them ends the Token in the next iteration
+                const size_t digitsEnd = cursor.skipDigits(i + 1);
+
+                for (i++; i != digitsEnd; i++)
+                {
+                    token->value *= 10;
+                    token->value += toDigit(script[i]);
+                }
+
+                i --;
                 continue;
             }
 
             if (isText(c))
             {
-                token = new Token(TokenType::TEXT, LITERAL_P, OpCodes::NO_OP, toValue(new std::string {c}));
+                NewToken(TokenType::TEXT, LITERAL_P, OpCodes::NO_OP, i);
+
+                // the character after the name ends the Token in the next iteration
+                i = cursor.skipName(i + 1) - 1;
                 continue;
             }
 
 
             // character isn't handled
-            // extract the line of the invalid character
-
-            // use C strings for convenience
-            const char* cString = script.c_str();
-
-            // find the start of the string
-            size_t tmpIndex = i - 1;
-            for (; cString[tmpIndex] != '\n'; tmpIndex--);
-
-            size_t length = i - tmpIndex;
-            const char* start = cString + tmpIndex;
-
-            // find the end of the string
-            tmpIndex = i + 1;
-            for (; cString[tmpIndex] != '\n'; tmpIndex++);
-
-            length = tmpIndex - i;
+            // report the line of the invalid character
+            const size_t lineEnd = std::min(script.find('\n', i), script.size());
 
-            errors::InvalidCharacterError(std::string(start, length), cString[i]);
+            errors::InvalidCharacterError(std::string(script.substr(lineStart, lineEnd - lineStart)), c);
     
 
         } // default
 
         } // switch (c)    
 
-    } // for (uint i = 0; (c = script[i]) != 0; i++)
+    } // for (size_t i = 0; i != script.size() && (c = script[i]) != 0; i++)
 
     // add a closing end of statement token
-    add(new Token(TokenType::ENDS, LITERAL_P, OpCodes::NO_OP));
+    add(arena.make<Token>(TokenType::ENDS, LITERAL_P, OpCodes::NO_OP));
 
 }
 
@@ -82,11 +82,11 @@ TokenType Tokens::typeOfValue(Value value)
 }
 
 
-TokenType Tokens::tokenTypeOf(const Token* token)
+TokenType Tokens::tokenTypeOf(const Token* token, const symbol_table::SymbolTable& symbolTable)
 {
     if (token->opCode == OpCodes::REFERENCE)
     {
-        return symbol_table::SymbolTable::get((std::string*) token->value)->type;
+        return symbolTable.get((interner::StringId) token->value)->type;
     }
     
     return token->type;
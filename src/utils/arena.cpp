@@ -0,0 +1,65 @@
+#include "arena.hh"
+
+
+using namespace arena;
+
+
+Arena::Arena()
+: blocks(), current(nullptr), remaining(0)
+{
+
+}
+
+
+Arena::~Arena()
+{
+    release();
+}
+
+
+void Arena::grow(size_t size)
+{
+    // objects bigger than a block get a block of their own
+    const size_t blockSize = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+
+    current = new char[blockSize];
+    remaining = blockSize;
+
+    blocks.push_back(current);
+}
+
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+    // padding needed to align the first free byte
+    size_t padding = (alignment - (size_t) current % alignment) % alignment;
+
+    if (padding + size > remaining)
+    {
+        // new blocks are aligned for any fundamental type
+        grow(size);
+        padding = 0;
+    }
+
+    void* address = current + padding;
+
+    current += padding + size;
+    remaining -= padding + size;
+
+    return address;
+}
+
+
+void Arena::release()
+{
+    for (char* block : blocks)
+    {
+        delete[] block;
+    }
+
+    blocks.clear();
+
+    current = nullptr;
+    remaining = 0;
+}
+
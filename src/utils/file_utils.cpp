@@ -1,25 +1,111 @@
 #include "utils.hh"
+#include "errors.hh"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
 
 
 using namespace file_utils;
 
 
-bool file_utils::loadFile(const char* path, std::string& output)
+// bytes read at a time from files that can't be mapped
+#define READ_CHUNK_SIZE (64 * 1024)
+
+
+SourceBuffer::SourceBuffer(const char* path)
+: mapping(nullptr), mappingSize(0), content()
 {
-    std::ifstream file(path);
+    const int descriptor = open(path, O_RDONLY);
+
+    if (descriptor == -1)
+    {
+        errors::FileReadError(path);
+    }
+
+    struct stat status;
+
+    if (fstat(descriptor, &status) != 0)
+    {
+        close(descriptor);
+        errors::FileReadError(path);
+    }
 
-    if (file.bad()) 
+    // empty files have nothing to map, mmap rejects a length of 0
+    if (S_ISREG(status.st_mode) && status.st_size != 0)
     {
-        return false;
+        mappingSize = (size_t) status.st_size;
+
+        void* const pages = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+        // the mapping keeps the file open by itself
+        close(descriptor);
+
+        if (pages == MAP_FAILED)
+        {
+            errors::FileReadError(path);
+        }
+
+        mapping = (char*) pages;
+
+        // scripts are read once from the beginning to the end
+        madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+        return;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
+    // pipes and devices have no size to map, they are read until they end
+    // regular files only get here if they are empty
+    char chunk[READ_CHUNK_SIZE];
+
+    while (true)
+    {
+        const ssize_t count = read(descriptor, chunk, sizeof(chunk));
 
-    file.close();
+        if (count == 0)
+        {
+            break;
+        }
 
-    output = buffer.str();
+        if (count == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
 
-    return true;
+            close(descriptor);
+            errors::FileReadError(path);
+        }
+
+        content.append(chunk, (size_t) count);
+    }
+
+    close(descriptor);
+}
+
+
+SourceBuffer::~SourceBuffer()
+{
+    if (mapping != nullptr)
+    {
+        munmap(mapping, mappingSize);
+    }
+}
+
+
+std::string_view SourceBuffer::getView() const
+{
+    return mapping != nullptr
+        ? std::string_view(mapping, mappingSize)
+        : std::string_view(content);
+}
+
+
+bool SourceBuffer::isMapped() const
+{
+    return mapping != nullptr;
 }
 
@@ -4,5 +4,3 @@
 const char* globals::INCLUDE_PATH = "/usr/lib/permalang";
 
 
-bool globals::doOptimize = false;
-
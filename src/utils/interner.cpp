@@ -0,0 +1,46 @@
+#include "interner.hh"
+
+
+using namespace interner;
+
+
+StringInterner::StringInterner()
+: strings(), ids()
+{
+
+}
+
+
+StringId StringInterner::intern(std::string_view string)
+{
+    auto iterator = ids.find(string);
+
+    if (iterator != ids.end())
+    {
+        return iterator->second;
+    }
+
+    const StringId id = (StringId) strings.size();
+
+    // the map's key views the stored copy, not the caller's string
+    ids.emplace(strings.emplace_back(string), id);
+
+    return id;
+}
+
+
+StringId StringInterner::unique()
+{
+    const StringId id = (StringId) strings.size();
+
+    strings.emplace_back();
+
+    return id;
+}
+
+
+const std::string& StringInterner::get(StringId id) const
+{
+    return strings[id];
+}
+
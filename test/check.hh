@@ -0,0 +1,19 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+
+// checks that failed so far, a test returns 1 if any did
+static size_t failures = 0;
+
+
+static void check(bool condition, const std::string& name)
+{
+    if (!condition)
+    {
+        failures ++;
+    }
+
+    std::cout << (condition ? "passed: " : "FAILED: ") << name << std::endl;
+}
@@ -0,0 +1,69 @@
+#include "libpcc.hh"
+
+#include <chrono>
+
+using namespace std;
+
+
+// a short script, like the ones compiled by embedding hosts
+static const char* const SCRIPT =
+    "int i = 0;\n"
+    "int s = 0;\n"
+    "while (i != 100)\n"
+    "{\n"
+    "    s = s + i;\n"
+    "    i++;\n"
+    "}\n";
+
+// scripts that don't compile, their errors must be returned as Diagnostics
+static const char* const INVALID_SCRIPTS[] =
+{
+    "int i = j;",
+    "int a = 1;\nif (a == 1)\n{\n    a = 2;\n",
+    "int a = (",
+};
+
+#define RUNS 20000
+
+
+int main()
+{
+    const pcc::Result<pcc::Compilation, pcc::Diagnostics> first = pcc::compile(SCRIPT);
+
+    if (!first.isOk())
+    {
+        cerr << first.getError()[0].message << endl;
+        return 1;
+    }
+
+    // errors must not leave anything behind for the next compilation
+    for (const char* script : INVALID_SCRIPTS)
+    {
+        const pcc::Result<pcc::Compilation, pcc::Diagnostics> failed = pcc::compile(script);
+
+        if (failed.isOk())
+        {
+            cerr << "invalid script compiled: " << script << endl;
+            return 1;
+        }
+
+        cout << "error: " << failed.getError()[0].message << endl;
+    }
+
+    const auto start = chrono::steady_clock::now();
+
+    for (size_t i = 0; i != RUNS; i++)
+    {
+        const pcc::Result<pcc::Compilation, pcc::Diagnostics> result = pcc::compile(SCRIPT);
+
+        if (!result.isOk() || result.getValue().byteCode != first.getValue().byteCode)
+        {
+            cerr << "compilation " << i << " differs from the first one" << endl;
+            return 1;
+        }
+    }
+
+    const chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+
+    cout << RUNS << " compilations, " << elapsed.count() / RUNS << " us each" << endl;
+}
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+
+import ctypes
+import subprocess
+import tempfile
+import os
+import time
+
+
+COMPILER = 'target/pcc'
+LIBRARY = 'target/libpvm.so'
+
+# a short script, like the ones run by embedding hosts
+SCRIPT = '''int i = 0;
+int s = 0;
+while (i != 100)
+{
+    s = s + i;
+    i++;
+}
+'''
+
+# seconds spent measuring each path
+DURATION = 2.0
+
+
+def load_library() -> ctypes.CDLL:
+    library = ctypes.CDLL(LIBRARY)
+
+    library.pvm_load_executable.argtypes = [ctypes.c_char_p, ctypes.POINTER(ctypes.c_void_p)]
+    library.pvm_create_instance.argtypes = [ctypes.c_size_t, ctypes.POINTER(ctypes.c_void_p)]
+    library.pvm_run.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint8)]
+    library.pvm_free_program.argtypes = [ctypes.c_void_p]
+    library.pvm_free_instance.argtypes = [ctypes.c_void_p]
+    library.pvm_last_error.restype = ctypes.c_char_p
+
+    return library
+
+
+# runs the function for DURATION seconds, returns the executions per second
+def executions_per_second(function) -> float:
+    executions = 0
+    start_time = time.perf_counter()
+
+    while True:
+        function()
+        executions += 1
+
+        elapsed = time.perf_counter() - start_time
+        if elapsed >= DURATION:
+            return executions / elapsed
+
+
+def bench():
+    library = load_library()
+
+    with tempfile.TemporaryDirectory() as directory:
+        script_path = os.path.join(directory, 'script.pf')
+        executable_path = os.path.join(directory, 'script.pfx')
+
+        with open(script_path, 'w') as file:
+            file.write(SCRIPT)
+
+        subprocess.check_output([COMPILER, script_path, '-O', '-o', executable_path], stderr=subprocess.STDOUT)
+
+        spawned = executions_per_second(
+            lambda: subprocess.check_output([COMPILER, executable_path, '-x'], stderr=subprocess.STDOUT))
+
+        program = ctypes.c_void_p()
+        instance = ctypes.c_void_p()
+        exit_code = ctypes.c_uint8()
+
+        if library.pvm_load_executable(executable_path.encode(), ctypes.byref(program)) != 0 \
+                or library.pvm_create_instance(0, ctypes.byref(instance)) != 0:
+            raise RuntimeError(library.pvm_last_error().decode())
+
+        def run():
+            if library.pvm_run(instance, program, ctypes.byref(exit_code)) != 0:
+                raise RuntimeError(library.pvm_last_error().decode())
+
+        in_process = executions_per_second(run)
+
+        library.pvm_free_instance(instance)
+        library.pvm_free_program(program)
+
+    print(f'{"path":>12} {"executions/s":>14}')
+    print(f'{"pcc -x":>12} {spawned:>14.0f}')
+    print(f'{"libpvm":>12} {in_process:>14.0f}')
+    print(f'\nlibpvm is {in_process / spawned:.1f}x faster')
+
+
+if __name__ == '__main__':
+    bench()
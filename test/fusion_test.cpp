@@ -0,0 +1,372 @@
+#include "pvm.hh"
+#include "errors.hh"
+
+#include "check.hh"
+
+using namespace std;
+using pvm::ByteList;
+using pvm::OpCode;
+using pvm::Registers;
+
+
+// the programs only use the first bytes
+#define MEMORY_SIZE 4096
+
+
+// what a program leaves behind
+typedef struct State
+{
+    pvm::Byte exitCode;
+    vector<long> registers;
+    vector<pvm::Byte> memory;
+
+} State;
+
+
+static State run(const ByteList& list)
+{
+    pvm::ByteCode byteCode = list.toByteCode();
+    pvm::Pvm pvm(MEMORY_SIZE);
+
+    State state;
+    state.exitCode = pvm.execute(byteCode);
+
+    for (unsigned int reg = 0; reg != REGISTER_COUNT; reg++)
+    {
+        state.registers.push_back(pvm.getRegisterValue((Registers) reg));
+    }
+
+    const pvm::Byte* const memory = pvm.getMemory().getBase();
+    state.memory.assign(memory, memory + pvm.getMemory().getSize());
+
+    delete[] byteCode.byteCode;
+
+    return state;
+}
+
+
+static size_t instructionCount(const ByteList& list)
+{
+    pvm::ByteCode byteCode = list.toByteCode();
+    const size_t count = pvm::decode(byteCode).size();
+
+    delete[] byteCode.byteCode;
+
+    return count;
+}
+
+
+// fuses the program, then checks that it leaves the same registers and memory
+// removed is the number of instructions fusion is expected to save
+static void checkFusion(const ByteList& program, size_t removed, const char* name)
+{
+    // invalid fused byte code fails the check instead of ending the test
+    const errors::Capture capture;
+
+    try
+    {
+        ByteList fused = program;
+        fused.fuseInstructions();
+
+        const State expected = run(program);
+        const State actual = run(fused);
+
+        const bool isEquivalent = actual.exitCode == expected.exitCode
+            && actual.registers == expected.registers
+            && actual.memory == expected.memory;
+
+        check(isEquivalent && instructionCount(fused) + removed == instructionCount(program), name);
+    }
+    catch (const errors::Error& error)
+    {
+        cout << error.what() << endl;
+        check(false, name);
+    }
+}
+
+
+static void loadA(ByteList& list, OpCode opCode, long address)
+{
+    list.add(opCode);
+    list.add((Value) address, sizeof(long));
+}
+
+
+static void loadB(ByteList& list, OpCode opCode, long address)
+{
+    list.add(opCode);
+    list.add((Value) address, sizeof(long));
+}
+
+
+static void loadConstant(ByteList& list, OpCode opCode, long value, pvm::InstructionSize size)
+{
+    list.add(opCode);
+    list.add((Value) value, size);
+}
+
+
+static void setMemory(ByteList& list, OpCode opCode, long address, long value, pvm::InstructionSize size)
+{
+    list.add(opCode);
+    list.add((Value) address, sizeof(long));
+    list.add((Value) value, size);
+}
+
+
+static void store(ByteList& list, OpCode opCode, long address, Registers reg)
+{
+    list.add(opCode);
+    list.add((Value) address, sizeof(long));
+    list.add(reg);
+}
+
+
+static void copy(ByteList& list, OpCode opCode, Registers destination, Registers source)
+{
+    list.add(opCode);
+    list.add(destination);
+    list.add(source);
+}
+
+
+static void loadRegister(ByteList& list, Registers reg, long value)
+{
+    list.add(OpCode::LD_CONST_REG);
+    list.add(reg);
+    list.add((Value) value, sizeof(long));
+}
+
+
+static void exit(ByteList& list)
+{
+    list.add(OpCode::EXIT);
+    list.add(7, 1);
+}
+
+
+// LD_A_BIT a, LD_CONST_B_BIT 0, CMP, IF_JUMP, jumps if the bit is 0
+// returns the offset of the jump target operand
+static size_t branchOnBit(ByteList& list, long address)
+{
+    loadA(list, OpCode::LD_A_BIT, address);
+    loadConstant(list, OpCode::LD_CONST_B_BIT, 0, 1);
+    list.add(OpCode::CMP);
+    list.add(OpCode::IF_JUMP);
+
+    return list.addJumpTarget();
+}
+
+
+static void testMemoryOperands()
+{
+    ByteList program;
+
+    setMemory(program, OpCode::MEM_SET_4, 0, 7, 4);
+    setMemory(program, OpCode::MEM_SET_4, 4, -3, 4);
+    setMemory(program, OpCode::MEM_SET_8, 8, 1L << 40, 8);
+    setMemory(program, OpCode::MEM_SET_8, 16, 5, 8);
+
+    // ADD_MEM_4
+    loadA(program, OpCode::LD_A_4, 0);
+    loadB(program, OpCode::LD_B_4, 4);
+    program.add(OpCode::ADD);
+    store(program, OpCode::REG_MOV_4, 24, Registers::RESULT);
+
+    // SUB_MEM_CONST_8
+    loadA(program, OpCode::LD_A_8, 8);
+    loadConstant(program, OpCode::LD_CONST_B_8, -9, 8);
+    program.add(OpCode::SUB);
+    store(program, OpCode::REG_MOV_8, 32, Registers::RESULT);
+
+    // MUL_MEM_CONST_4, the constant byte is widened the way the Pvm does
+    loadA(program, OpCode::LD_A_4, 0);
+    loadConstant(program, OpCode::LD_CONST_B_1, 200, 1);
+    program.add(OpCode::MUL);
+    store(program, OpCode::REG_MOV_4, 40, Registers::RESULT);
+
+    // MUL_MEM_8
+    loadA(program, OpCode::LD_A_8, 8);
+    loadB(program, OpCode::LD_B_8, 16);
+    program.add(OpCode::MUL);
+    store(program, OpCode::REG_MOV_8, 48, Registers::RESULT);
+
+    // CMP_MEM_4
+    loadA(program, OpCode::LD_A_4, 0);
+    loadB(program, OpCode::LD_B_4, 4);
+    program.add(OpCode::CMP);
+    store(program, OpCode::REG_MOV_BIT, 56, Registers::ZERO_FLAG);
+
+    // CMP_REVERSE_MEM_CONST_8
+    loadA(program, OpCode::LD_A_8, 16);
+    loadConstant(program, OpCode::LD_CONST_B_4, 5, 4);
+    program.add(OpCode::CMP_REVERSE);
+    store(program, OpCode::REG_MOV_BIT, 57, Registers::ZERO_FLAG);
+
+    // the store width doesn't match the loads, left as it is
+    loadA(program, OpCode::LD_A_4, 0);
+    loadB(program, OpCode::LD_B_4, 4);
+    program.add(OpCode::SUB);
+    store(program, OpCode::REG_MOV_8, 64, Registers::RESULT);
+
+    exit(program);
+
+    // 4 arithmetic sequences of 4 instructions and 2 comparisons of 3
+    checkFusion(program, 4 * 3 + 2 * 2, "arithmetic and comparisons on memory operands");
+}
+
+
+static void testMemoryBranch()
+{
+    for (long bit = 0; bit != 2; bit++)
+    {
+        ByteList program;
+
+        setMemory(program, OpCode::MEM_SET_BIT, 0, bit, 1);
+
+        const size_t skip = branchOnBit(program, 0);
+        setMemory(program, OpCode::MEM_SET_4, 4, 11, 4);
+
+        program.setJumpTarget(skip, program.getCurrentSize());
+        setMemory(program, OpCode::MEM_SET_4, 8, 22, 4);
+
+        exit(program);
+
+        // IF_NOT_MEM_JUMP replaces the 4 instructions of the branch
+        checkFusion(program, 3, bit == 0 ? "branch on a memory bit, taken" : "branch on a memory bit, not taken");
+    }
+}
+
+
+static void testRegisterOperands()
+{
+    ByteList program;
+
+    loadRegister(program, Registers::R0, 40);
+    loadRegister(program, Registers::R1, -2);
+
+    // ADD_REG_4
+    copy(program, OpCode::REG_TO_REG, Registers::GENERAL_A, Registers::R0);
+    copy(program, OpCode::REG_TO_REG, Registers::GENERAL_B, Registers::R1);
+    program.add(OpCode::ADD);
+    copy(program, OpCode::REG_TO_REG_4, Registers::R2, Registers::RESULT);
+
+    // MUL_REG_CONST_8
+    copy(program, OpCode::REG_TO_REG, Registers::GENERAL_A, Registers::R2);
+    loadConstant(program, OpCode::LD_CONST_B_8, 3, 8);
+    program.add(OpCode::MUL);
+    copy(program, OpCode::REG_TO_REG, Registers::R3, Registers::RESULT);
+
+    // CMP_REG_CONST
+    copy(program, OpCode::REG_TO_REG, Registers::GENERAL_A, Registers::R3);
+    loadConstant(program, OpCode::LD_CONST_B_1, 1, 1);
+    program.add(OpCode::CMP);
+    store(program, OpCode::REG_MOV_BIT, 0, Registers::ZERO_FLAG);
+
+    store(program, OpCode::REG_MOV_8, 8, Registers::R2);
+    store(program, OpCode::REG_MOV_8, 16, Registers::R3);
+
+    // IF_NOT_REG_JUMP
+    loadRegister(program, Registers::R4, 0);
+    copy(program, OpCode::REG_TO_REG, Registers::GENERAL_A, Registers::R4);
+    loadConstant(program, OpCode::LD_CONST_B_BIT, 0, 1);
+    program.add(OpCode::CMP);
+    program.add(OpCode::IF_JUMP);
+    const size_t over = program.addJumpTarget();
+
+    store(program, OpCode::REG_MOV_8, 24, Registers::R0);
+
+    program.setJumpTarget(over, program.getCurrentSize());
+    exit(program);
+
+    // 2 arithmetic sequences, a comparison and a branch
+    checkFusion(program, 3 + 3 + 2 + 3, "arithmetic, comparisons and branches on registers");
+}
+
+
+// the loop jumps back to the second instruction of a fusable sequence
+static void testJumpIntoWindow()
+{
+    ByteList program;
+
+    setMemory(program, OpCode::MEM_SET_4, 0, 0, 4);
+    setMemory(program, OpCode::MEM_SET_4, 4, 3, 4);
+
+    loadA(program, OpCode::LD_A_4, 0);
+
+    const size_t loop = program.getCurrentSize();
+    loadB(program, OpCode::LD_B_4, 4);
+    program.add(OpCode::ADD);
+    store(program, OpCode::REG_MOV_4, 0, Registers::RESULT);
+
+    // CMP_MEM_CONST_4, then the exit of the loop
+    loadA(program, OpCode::LD_A_4, 0);
+    loadConstant(program, OpCode::LD_CONST_B_1, 30, 1);
+    program.add(OpCode::CMP);
+    program.add(OpCode::IF_JUMP);
+    const size_t end = program.addJumpTarget();
+
+    program.add(OpCode::JMP);
+    program.addJumpTarget(loop);
+
+    program.setJumpTarget(end, program.getCurrentSize());
+    exit(program);
+
+    // only the comparison is fused
+    checkFusion(program, 2, "jump to the second instruction of a fusable sequence");
+}
+
+
+// a branch jumps to the third or the fourth instruction of a fusable sequence
+static void testJumpIntoWindowEnd()
+{
+    for (long bit = 0; bit != 2; bit++)
+    {
+        for (size_t skipped = 2; skipped != 4; skipped++)
+        {
+            ByteList program;
+
+            setMemory(program, OpCode::MEM_SET_8, 0, 5, 8);
+            setMemory(program, OpCode::MEM_SET_BIT, 16, bit, 1);
+            loadConstant(program, OpCode::LD_CONST_RESULT_8, 77, 8);
+
+            const size_t target = branchOnBit(program, 16);
+
+            loadA(program, OpCode::LD_A_8, 0);
+            loadConstant(program, OpCode::LD_CONST_B_1, 2, 1);
+
+            if (skipped == 2)
+            {
+                program.setJumpTarget(target, program.getCurrentSize());
+            }
+
+            program.add(OpCode::SUB);
+
+            if (skipped == 3)
+            {
+                program.setJumpTarget(target, program.getCurrentSize());
+            }
+
+            store(program, OpCode::REG_MOV_8, 8, Registers::RESULT);
+            exit(program);
+
+            // only the branch is fused
+            checkFusion(program, 3,
+                skipped == 2 ? "jump to the third instruction of a fusable sequence" : "jump to the fourth instruction of a fusable sequence");
+        }
+    }
+}
+
+
+int main()
+{
+    testMemoryOperands();
+    testMemoryBranch();
+    testRegisterOperands();
+    testJumpIntoWindow();
+    testJumpIntoWindowEnd();
+
+    cout << "\nFailed checks: " << failures << endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,248 @@
+#include "libpvm.h"
+#include "pvm.hh"
+
+#include "check.hh"
+
+#include <climits>
+#include <thread>
+
+using namespace std;
+using pvm::OpCode;
+
+
+#define THREADS 4
+#define RUNS_PER_THREAD 100
+
+// a single page, so that the stack overflows quickly
+#define SMALL_MEMORY 4096
+
+
+static void put(vector<uint8_t>& code, OpCode opCode)
+{
+    code.push_back((uint8_t) opCode);
+}
+
+
+static void put(vector<uint8_t>& code, long operand)
+{
+    const uint8_t* const bytes = (const uint8_t*) &operand;
+    code.insert(code.end(), bytes, bytes + sizeof(long));
+}
+
+
+// whether loading the byte code is rejected
+static bool rejected(const vector<uint8_t>& code)
+{
+    PvmProgram* program = nullptr;
+
+    if (pvm_load_byte_code(code.data(), code.size(), &program) == PVM_OK)
+    {
+        pvm_free_program(program);
+        return false;
+    }
+
+    return *pvm_last_error() != 0;
+}
+
+
+// loads A with a constant, then exits with the given code
+static vector<uint8_t> exitingProgram(uint8_t exitCode)
+{
+    vector<uint8_t> code;
+
+    put(code, OpCode::LD_CONST_A_8);
+    put(code, 42L);
+    put(code, OpCode::EXIT);
+    code.push_back(exitCode);
+
+    return code;
+}
+
+
+// pushes forever, until the stack runs into the guard page past the memory
+static vector<uint8_t> overflowingProgram()
+{
+    vector<uint8_t> code;
+
+    put(code, OpCode::PUSH_CONST);
+    put(code, 1L);
+    put(code, OpCode::JMP);
+    put(code, 0L);
+
+    return code;
+}
+
+
+static void testMalformedByteCode()
+{
+    check(rejected({}), "empty program is rejected");
+
+    vector<uint8_t> code = exitingProgram(0);
+    code.resize(5);
+    check(rejected(code), "truncated instruction is rejected");
+
+    code = {};
+    put(code, OpCode::NO_OP);
+    check(rejected(code), "program ending with NO_OP is rejected");
+
+    code = {};
+    put(code, OpCode::LD_CONST_A_8);
+    put(code, 1L);
+    check(rejected(code), "program without EXIT is rejected");
+
+    // the jump target is the end of the byte code
+    code = {};
+    put(code, OpCode::IF_JUMP);
+    put(code, (long) (2 * (1 + sizeof(long))));
+    put(code, OpCode::JMP);
+    put(code, 0L);
+    check(rejected(code), "jump past the last instruction is rejected");
+
+    code = { 0xff };
+    check(rejected(code), "invalid OpCode is rejected");
+}
+
+
+static void testRun()
+{
+    const vector<uint8_t> exiting = exitingProgram(3);
+    const vector<uint8_t> overflowing = overflowingProgram();
+
+    PvmProgram* program = nullptr;
+    PvmProgram* overflow = nullptr;
+    PvmInstance* instance = nullptr;
+    uint8_t exitCode = 0;
+
+    check(pvm_load_byte_code(exiting.data(), exiting.size(), &program) == PVM_OK
+        && pvm_load_byte_code(overflowing.data(), overflowing.size(), &overflow) == PVM_OK
+        && pvm_create_instance(SMALL_MEMORY, &instance) == PVM_OK, "programs and instance are created");
+
+    check(pvm_run(instance, program, &exitCode) == PVM_OK && exitCode == 3
+        && pvm_get_register(instance, (unsigned int) pvm::Registers::GENERAL_A) == 42, "valid program runs");
+
+    check(pvm_run(instance, overflow, &exitCode) == PVM_ERROR
+        && string(pvm_last_error()).find("Stack Overflow") != string::npos, "stack overflow is returned as an error");
+
+    check(pvm_run(instance, program, &exitCode) == PVM_OK && exitCode == 3, "instance is reusable after a stack overflow");
+
+    pvm_free_instance(instance);
+    pvm_free_program(overflow);
+    pvm_free_program(program);
+}
+
+
+// divides the constants, then exits
+static vector<uint8_t> dividingProgram(long dividend, long divisor)
+{
+    vector<uint8_t> code;
+
+    put(code, OpCode::LD_CONST_A_8);
+    put(code, dividend);
+    put(code, OpCode::LD_CONST_B_8);
+    put(code, divisor);
+    put(code, OpCode::DIV);
+    put(code, OpCode::EXIT);
+    code.push_back(0);
+
+    return code;
+}
+
+
+// whether running the program returns an error containing the message
+static bool failsWith(PvmInstance* instance, const vector<uint8_t>& code, const char* message)
+{
+    PvmProgram* program = nullptr;
+    uint8_t exitCode = 0;
+
+    if (pvm_load_byte_code(code.data(), code.size(), &program) != PVM_OK)
+    {
+        return false;
+    }
+
+    const bool isFailed = pvm_run(instance, program, &exitCode) == PVM_ERROR
+        && string(pvm_last_error()).find(message) != string::npos;
+
+    pvm_free_program(program);
+
+    return isFailed;
+}
+
+
+// divisions that would raise SIGFPE must not end the host process
+static void testDivision()
+{
+    PvmInstance* instance = nullptr;
+    pvm_create_instance(SMALL_MEMORY, &instance);
+
+    check(failsWith(instance, dividingProgram(7, 0), "Zero Division"), "division by zero is returned as an error");
+    check(failsWith(instance, dividingProgram(LONG_MIN, -1), "Division Overflow"), "overflowing division is returned as an error");
+
+    const vector<uint8_t> dividing = dividingProgram(-21, 4);
+    PvmProgram* program = nullptr;
+    uint8_t exitCode = 1;
+
+    check(pvm_load_byte_code(dividing.data(), dividing.size(), &program) == PVM_OK
+        && pvm_run(instance, program, &exitCode) == PVM_OK && exitCode == 0
+        && pvm_get_register(instance, (unsigned int) pvm::Registers::RESULT) == -5, "instance is reusable after a division error");
+
+    pvm_free_program(program);
+    pvm_free_instance(instance);
+}
+
+
+// every thread creates its own instances, the program is shared
+static void testThreads()
+{
+    const vector<uint8_t> overflowing = overflowingProgram();
+
+    PvmProgram* overflow = nullptr;
+    pvm_load_byte_code(overflowing.data(), overflowing.size(), &overflow);
+
+    size_t errors[THREADS] = {};
+    thread threads[THREADS];
+
+    for (size_t i = 0; i != THREADS; i++)
+    {
+        threads[i] = thread([overflow, &errors, i]()
+        {
+            for (size_t run = 0; run != RUNS_PER_THREAD; run++)
+            {
+                PvmInstance* instance = nullptr;
+                uint8_t exitCode = 0;
+
+                if (pvm_create_instance(SMALL_MEMORY, &instance) == PVM_OK
+                    && pvm_run(instance, overflow, &exitCode) == PVM_ERROR)
+                {
+                    errors[i] ++;
+                }
+
+                pvm_free_instance(instance);
+            }
+        });
+    }
+
+    size_t total = 0;
+
+    for (size_t i = 0; i != THREADS; i++)
+    {
+        threads[i].join();
+        total += errors[i];
+    }
+
+    check(total == THREADS * RUNS_PER_THREAD, "stack overflows on concurrent instances are returned as errors");
+
+    pvm_free_program(overflow);
+}
+
+
+int main()
+{
+    testMalformedByteCode();
+    testRun();
+    testDivision();
+    testThreads();
+
+    cout << "\nFailed checks: " << failures << endl;
+
+    return failures == 0 ? 0 : 1;
+}
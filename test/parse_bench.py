@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+
+import subprocess
+import tempfile
+import os
+import time
+
+
+COMPILER = 'target/pcc'
+
+# number of operators in the longest expression
+MAX_OPERATORS = 32000
+# the smallest expression is the longest one halved this many times
+STEPS = 6
+
+RUNS = 3
+
+
+def generate_expression(operators: int) -> str:
+    # alternate operators with different priorities so that the statement
+    # is not satisfied just from left to right
+    script = 'int a = 1;\nint b = 2;\nint c = a'
+
+    for i in range(operators):
+        script += ' * b' if i % 3 == 0 else ' + a'
+
+    return script + ';\n'
+
+
+def compile_time(script_path: str) -> float:
+    best = None
+
+    for _ in range(RUNS):
+        start_time = time.perf_counter()
+        subprocess.check_output([COMPILER, script_path, '-o', os.devnull], stderr=subprocess.STDOUT)
+        elapsed = time.perf_counter() - start_time
+
+        if best is None or elapsed < best:
+            best = elapsed
+
+    return best
+
+
+def bench():
+    print(f'{"operators":>10} {"time (ms)":>12} {"us/operator":>12}')
+
+    with tempfile.TemporaryDirectory() as directory:
+        script_path = os.path.join(directory, 'expression.pf')
+
+        for step in reversed(range(STEPS)):
+            operators = MAX_OPERATORS >> step
+
+            with open(script_path, 'w') as file:
+                file.write(generate_expression(operators))
+
+            elapsed = compile_time(script_path)
+
+            print(f'{operators:>10} {elapsed * 1000:>12.2f} {elapsed * 1e6 / operators:>12.3f}')
+
+
+if __name__ == '__main__':
+    bench()
+
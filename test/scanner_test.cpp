@@ -0,0 +1,232 @@
+#include "scanner.hh"
+
+#include "check.hh"
+
+#include <memory>
+#include <random>
+
+using namespace std;
+using scanner::Isa;
+using scanner::Block;
+
+
+// fixed, so that failures can be reproduced
+#define SEED 7
+
+#define RANDOM_BLOCKS 20000
+#define RANDOM_TEXTS 2000
+#define MAX_RANDOM_SIZE 300
+
+
+static const Isa isas[] = { Isa::SCALAR, Isa::SSE2, Isa::AVX2 };
+
+
+// characters around the bounds of every class, the rest is drawn from all the bytes
+static const char boundaries[] = "azAZ09_`{@[/: \t\r,\n\v\f-+;\"\x7f\x80\xc3\xff\x01";
+
+
+static char randomChar(mt19937& random)
+{
+    if (random() % 2 == 0)
+    {
+        return boundaries[random() % (sizeof(boundaries) - 1)];
+    }
+
+    return (char) (random() % 256);
+}
+
+
+static string randomText(mt19937& random, size_t size)
+{
+    string text(size, ' ');
+
+    for (size_t i = 0; i != size; i++)
+    {
+        // runs of the same class are common in scripts
+        text[i] = i != 0 && random() % 4 == 0 ? text[i - 1] : randomChar(random);
+    }
+
+    return text;
+}
+
+
+static bool isName(char c)
+{
+    return isalnum((unsigned char) c) || c == '_';
+}
+
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+
+static bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == ',';
+}
+
+
+// the first character at or after the offset outside the class, one character at a time
+static size_t skipScalar(const string& text, size_t offset, bool (*isInClass)(char))
+{
+    while (offset < text.size() && isInClass(text[offset]))
+    {
+        offset ++;
+    }
+
+    return offset;
+}
+
+
+static bool isSame(const Block& a, const Block& b)
+{
+    return a.name == b.name && a.digit == b.digit && a.blank == b.blank;
+}
+
+
+// every Classifier against the scalar one, on random Blocks at every alignment
+static void testClassifiers(mt19937& random)
+{
+    const scanner::Classifier scalar = scanner::get(Isa::SCALAR)->classify;
+
+    // room to move the Block to every offset within a vector register
+    char chars[SCANNER_BLOCK_SIZE + 32];
+
+    for (Isa isa : isas)
+    {
+        const scanner::Scanner* const scanner = scanner::get(isa);
+
+        if (scanner == nullptr)
+        {
+            continue;
+        }
+
+        bool isEquivalent = true;
+
+        for (size_t run = 0; run != RANDOM_BLOCKS && isEquivalent; run++)
+        {
+            for (char& c : chars)
+            {
+                c = randomChar(random);
+            }
+
+            const char* const start = chars + run % 32;
+
+            Block expected;
+            Block actual;
+            scalar(start, expected);
+            scanner->classify(start, actual);
+
+            isEquivalent = isSame(expected, actual);
+        }
+
+        // every byte value, a Block at a time
+        for (size_t first = 0; first != 256 && isEquivalent; first += SCANNER_BLOCK_SIZE)
+        {
+            for (size_t i = 0; i != SCANNER_BLOCK_SIZE; i++)
+            {
+                chars[i] = (char) (first + i);
+            }
+
+            Block expected;
+            Block actual;
+            scalar(chars, expected);
+            scanner->classify(chars, actual);
+
+            isEquivalent = isSame(expected, actual);
+        }
+
+        check(isEquivalent, string(scanner->name) + " classifier matches the scalar one");
+    }
+}
+
+
+// every run a Cursor finds in the text is the one found a character at a time
+static bool isCursorEquivalent(const scanner::Scanner& scanner, const string& text, mt19937& random)
+{
+    // the text is copied to its own allocation, followed by a name character
+    // that a Cursor reading past the end would count in a run
+    const unique_ptr<char[]> exact(new char[text.size() + 1]);
+    memcpy(exact.get(), text.data(), text.size());
+    exact[text.size()] = 'a';
+
+    scanner::Cursor cursor(string_view(exact.get(), text.size()), scanner);
+
+    // offsets in order, then in a random order, so that Blocks are reloaded
+    for (size_t i = 0; i != 2 * (text.size() + 1); i++)
+    {
+        const size_t offset = i <= text.size() ? i : random() % (text.size() + 1);
+
+        if (cursor.skipName(offset) != skipScalar(text, offset, isName)
+            || cursor.skipDigits(offset) != skipScalar(text, offset, isDigit)
+            || cursor.skipBlanks(offset) != skipScalar(text, offset, isBlank))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+static void testCursors(mt19937& random)
+{
+    for (Isa isa : isas)
+    {
+        const scanner::Scanner* const scanner = scanner::get(isa);
+
+        if (scanner == nullptr)
+        {
+            continue;
+        }
+
+        const string name = scanner->name;
+
+        bool isEquivalent = true;
+
+        for (size_t run = 0; run != RANDOM_TEXTS && isEquivalent; run++)
+        {
+            isEquivalent = isCursorEquivalent(*scanner, randomText(random, random() % MAX_RANDOM_SIZE), random);
+        }
+
+        check(isEquivalent, name + " cursor matches on random texts");
+
+        // sizes around the Block size, the last Block is padded
+        isEquivalent = true;
+
+        for (size_t size = 0; size <= 3 * SCANNER_BLOCK_SIZE + 1 && isEquivalent; size++)
+        {
+            isEquivalent = isCursorEquivalent(*scanner, randomText(random, size), random);
+        }
+
+        check(isEquivalent, name + " cursor matches on every size up to 3 Blocks");
+
+        // a run that reaches the end of the text stops there, the padding has no class
+        isEquivalent = true;
+
+        for (size_t size : { 1, SCANNER_BLOCK_SIZE - 1, SCANNER_BLOCK_SIZE, SCANNER_BLOCK_SIZE + 1, 2 * SCANNER_BLOCK_SIZE })
+        {
+            for (char c : { 'x', '7', ' ' })
+            {
+                isEquivalent = isEquivalent && isCursorEquivalent(*scanner, string(size, c), random);
+            }
+        }
+
+        check(isEquivalent, name + " cursor stops runs at the end of the text");
+    }
+}
+
+
+int main()
+{
+    mt19937 random(SEED);
+
+    testClassifiers(random);
+    testCursors(random);
+
+    cout << "\nFailed checks: " << failures << endl;
+
+    return failures == 0 ? 0 : 1;
+}
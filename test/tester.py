@@ -7,8 +7,31 @@ import time
 
 
 IMPL_TEST_DIR = pathlib.Path('impl/test')
+PREPROCESSOR_TEST_DIR = IMPL_TEST_DIR / 'preprocessor'
+# scripts that declare the variables of the test scripts with the values they must end with
+EXPECTED_TEST_DIR = IMPL_TEST_DIR / 'expected'
 COMPILER = 'target/pcc'
 
+# scripts, the pcc flags they're compiled with and the script they must preprocess to
+PREPROCESSOR_CASES = [
+    ('define.pf', '', 'define.expected.pf'),
+    ('conditionals.pf', '', 'conditionals.expected.pf'),
+    ('command_line.pf', '-D TRACE -D LIMIT=100', 'command_line.defined.pf'),
+    ('command_line.pf', '', 'command_line.undefined.pf'),
+    ('pragma_once.pf', '', 'pragma_once.expected.pf'),
+    ('string_literals.pf', '', 'string_literals.expected.pf'),
+]
+
+# scripts the preprocessor rejects and the error they're rejected with
+PREPROCESSOR_ERRORS = [
+    ('unmatched_else.pf', '[Unmatched Conditional Error] #else'),
+    ('double_else.pf', '[Unmatched Conditional Error] #else'),
+    ('unmatched_endif.pf', '[Unmatched Conditional Error] #endif'),
+    ('unterminated.pf', '[Unterminated Conditional Error] The conditional at line 2'),
+    ('recursive_include.pf', '[Recursive Include Error]'),
+    ('invalid_directive.pf', '[Invalid Preprocessor Error] "undefine"'),
+]
+
 test_count = 0
 failed_count = 0
 passed_count = 0
@@ -51,11 +74,217 @@ def compile_test():
             compile_file(path, True)
 
 
+def execute(cmd: str) -> str:
+    return subprocess.check_output(cmd, stderr=subprocess.STDOUT, shell=True, universal_newlines=True)
+
+
+def memory_of(output: str) -> str:
+    # the registers are left out, optimized programs keep their values elsewhere
+    return output[output.index('Memory:'):]
+
+
+def memory_bytes(output: str) -> list:
+    # the bytes of the memory printed by -v, without the addresses
+    lines = memory_of(output).splitlines()[1:]
+    return [byte for line in lines if not line.startswith('Exit code') for byte in line.split()[1:]]
+
+
+def values_file(script_path: str, expected_path: str):
+    global test_count
+    test_count += 1
+
+    executable_path = f'{script_path}.pfx'
+    expected_executable_path = f'{expected_path}.pfx'
+    cmd = f'{COMPILER} "{script_path}" -o "{executable_path}"'
+
+    # the variables come first in memory, temporary values are stored after them
+    try:
+        execute(cmd)
+        execute(f'{COMPILER} "{expected_path}" -o "{expected_executable_path}"')
+        output = memory_bytes(execute(f'{COMPILER} "{executable_path}" -x -v'))
+        expected = memory_bytes(execute(f'{COMPILER} "{expected_executable_path}" -x -v'))
+    except subprocess.CalledProcessError as exc:
+        logError(cmd, exc.output)
+        return
+    finally:
+        for path in (executable_path, expected_executable_path):
+            if os.path.exists(path):
+                os.remove(path)
+
+    if output[:len(expected)] != expected:
+        logError(cmd, f'expected the variables:\n{" ".join(expected)}\ngot:\n{" ".join(output[:len(expected)])}')
+    else:
+        logSuccess(cmd)
+
+
+def values_test():
+    for filename in os.listdir(EXPECTED_TEST_DIR):
+        if filename.endswith('.pf'):
+            values_file(IMPL_TEST_DIR / filename, EXPECTED_TEST_DIR / filename)
+
+
+def optimize_file(script_path: str):
+    global test_count
+    test_count += 1
+
+    reference_path = f'{script_path}.O0.pfx'
+    optimized_path = f'{script_path}.O.pfx'
+    cmd = f'{COMPILER} "{script_path}" -O -o "{optimized_path}"'
+
+    # register allocation and fusion must leave the memory exactly like the unoptimized program
+    try:
+        execute(f'{COMPILER} "{script_path}" -o "{reference_path}"')
+        execute(cmd)
+        expected = execute(f'{COMPILER} "{reference_path}" -x -v')
+        output = execute(f'{COMPILER} "{optimized_path}" -x -v')
+    except subprocess.CalledProcessError as exc:
+        logError(cmd, exc.output)
+        return
+    finally:
+        for path in (reference_path, optimized_path):
+            if os.path.exists(path):
+                os.remove(path)
+
+    if memory_of(output) != memory_of(expected):
+        logError(cmd, f'expected:\n{expected}\ngot:\n{output}')
+    else:
+        logSuccess(cmd)
+
+
+def optimize_test():
+    for filename in os.listdir(IMPL_TEST_DIR):
+        if filename.endswith('.pf'):
+            optimize_file(os.path.join(IMPL_TEST_DIR, filename))
+
+
+def tokens_of(output: str) -> str:
+    # the token list printed by -v, what the compiler sees of the preprocessed script
+    start = output.index('Token List: {')
+    return output[start:output.index('\n}', start)]
+
+
+def preprocessor_file(script_path: str, flags: str, expected_path: str):
+    global test_count
+    test_count += 1
+
+    cmd = f'{COMPILER} "{script_path}" {flags} -v'
+
+    # the script must be compiled exactly like the one written without directives
+    try:
+        output = execute(cmd)
+        expected = execute(f'{COMPILER} "{expected_path}" -v')
+    except subprocess.CalledProcessError as exc:
+        logError(cmd, exc.output)
+        return
+
+    if tokens_of(output) != tokens_of(expected):
+        logError(cmd, f'expected:\n{tokens_of(expected)}\ngot:\n{tokens_of(output)}')
+    else:
+        logSuccess(cmd)
+
+
+def preprocessor_error_file(script_path: str, error: str):
+    global test_count
+    test_count += 1
+
+    cmd = f'{COMPILER} "{script_path}"'
+
+    try:
+        output = execute(cmd)
+    except subprocess.CalledProcessError as exc:
+        output = exc.output
+
+        if error in output:
+            logSuccess(cmd)
+            return
+
+    logError(cmd, f'expected the error:\n{error}\ngot:\n{output}')
+
+
+def preprocessor_test():
+    for script, flags, expected in PREPROCESSOR_CASES:
+        preprocessor_file(PREPROCESSOR_TEST_DIR / script, flags, PREPROCESSOR_TEST_DIR / expected)
+
+    for script, error in PREPROCESSOR_ERRORS:
+        preprocessor_error_file(PREPROCESSOR_TEST_DIR / 'errors' / script, error)
+
+
+def jit_file(executable_path: str):
+    global test_count
+    test_count += 1
+
+    cmd = f'{COMPILER} "{executable_path}" -x --jit -v'
+
+    # the native code must behave exactly like the interpreter
+    # -v prints the registers and the memory left by the program, not only its exit code
+    try:
+        expected = execute(f'{COMPILER} "{executable_path}" -x -v')
+        output = execute(cmd)
+    except subprocess.CalledProcessError as exc:
+        logError(cmd, exc.output)
+        return
+
+    if output != expected:
+        logError(cmd, f'expected:\n{expected}\ngot:\n{output}')
+    else:
+        logSuccess(cmd)
+
+
+def jit_test():
+    # run the executables generated by compile_test()
+    for filename in os.listdir(IMPL_TEST_DIR):
+        if filename.endswith('.pfx'):
+            jit_file(os.path.join(IMPL_TEST_DIR, filename))
+
+
+def native_file(script_path: str, optimize: bool):
+    global test_count
+    test_count += 1
+
+    native_path = f'{script_path}.out'
+    flags = ' -O' if optimize else ''
+    cmd = f'{COMPILER} "{script_path}"{flags} -t native -o "{native_path}"'
+
+    # the native executable must behave exactly like the interpreter running the same byte code
+    # -v makes both print the registers and the memory left by the program
+    try:
+        execute(cmd)
+        execute(f'{COMPILER} "{script_path}"{flags}')
+        expected = execute(f'{COMPILER} "{script_path}.pfx" -x -v')
+        process = subprocess.run([native_path, '-v'], stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    except subprocess.CalledProcessError as exc:
+        logError(cmd, exc.output)
+        return
+    finally:
+        if os.path.exists(native_path):
+            os.remove(native_path)
+
+    output = f'{process.stdout}Exit code: {process.returncode}\n'
+
+    if output != expected:
+        logError(cmd, f'expected:\n{expected}\ngot:\n{output}')
+    else:
+        logSuccess(cmd)
+
+
+def native_test():
+    for filename in os.listdir(IMPL_TEST_DIR):
+        if filename.endswith('.pf'):
+            path = os.path.join(IMPL_TEST_DIR, filename)
+            native_file(path, False)
+            native_file(path, True)
+
+
 if __name__ == '__main__':
 
     start_time = time.time()
 
     compile_test()
+    preprocessor_test()
+    values_test()
+    optimize_test()
+    jit_test()
+    native_test()
 
     end_time = time.time()
 
@@ -0,0 +1,202 @@
+#include "token.hh"
+#include "context.hh"
+#include "scanner.hh"
+
+#include <chrono>
+#include <iomanip>
+
+using namespace std;
+
+
+// approximate size of every generated input
+#define INPUT_SIZE (8 * 1024 * 1024)
+
+#define RUNS 5
+
+
+// a declaration of a long variable name from another one
+static string identifierLine(size_t i)
+{
+    return "int accumulated_value_" + to_string(i) + " = previous_total_value_" + to_string(i) + " * scale_factor;\n";
+}
+
+
+// a long string literal, like the messages of tracing scripts
+static string stringLine(size_t i)
+{
+    return "string message_" + to_string(i) + " = \"the quick brown fox jumps over the lazy dog, line " + to_string(i)
+        + " of the generated script, padded so that the literal is longer than a name\";\n";
+}
+
+
+// deeply indented statements with aligned operands
+static string blankLine(size_t i)
+{
+    return "                        x    =    y    +    " + to_string(i % 10) + "    ,    z    ;\n";
+}
+
+
+// short names, numbers and operators
+static string expressionLine(size_t i)
+{
+    return "a = (b + " + to_string(i) + ") * c - d / 7 + e;\n";
+}
+
+
+static string generate(string (*line)(size_t))
+{
+    string script;
+    script.reserve(INPUT_SIZE + 256);
+
+    for (size_t i = 0; script.size() < INPUT_SIZE; i++)
+    {
+        script += line(i);
+    }
+
+    return script;
+}
+
+
+// tokenizes the script RUNS times with the Scanner, each time in a new Context
+// returns the best throughput in MB/s
+static double throughput(string& script, const scanner::Scanner* scanner, size_t& tokens)
+{
+    double best = 0;
+
+    for (size_t run = 0; run != RUNS; run++)
+    {
+        compilation::Context context(false);
+        context.scanner = scanner;
+
+        const auto start = chrono::steady_clock::now();
+
+        const Tokens::TokenList list(script, context);
+
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        tokens = 0;
+        for (const Tokens::Token* token = list.first; token != nullptr; token = token->next)
+        {
+            tokens ++;
+        }
+
+        best = max(best, (double) script.size() / (1024.0 * 1024.0) / elapsed.count());
+    }
+
+    return best;
+}
+
+
+// walks the script from run to run of names, digits and blanks, without
+// making Tokens, RUNS times with the Scanner
+// returns the best throughput in MB/s
+static double scanThroughput(string& script, const scanner::Scanner* scanner, size_t& runs)
+{
+    double best = 0;
+
+    for (size_t run = 0; run != RUNS; run++)
+    {
+        runs = 0;
+
+        const auto start = chrono::steady_clock::now();
+
+        scanner::Cursor cursor(script, *scanner);
+
+        for (size_t i = 0; i != script.size(); runs++)
+        {
+            const char c = script[i];
+
+            if (isDigit(c))
+            {
+                i = cursor.skipDigits(i + 1);
+            }
+            else if (isText(c))
+            {
+                i = cursor.skipName(i + 1);
+            }
+            else if (c == ' ' || c == '\t' || c == '\r' || c == ',')
+            {
+                i = cursor.skipBlanks(i + 1);
+            }
+            else
+            {
+                i ++;
+            }
+        }
+
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        best = max(best, (double) script.size() / (1024.0 * 1024.0) / elapsed.count());
+    }
+
+    return best;
+}
+
+
+// prints a row of the table for every input, measured with every Scanner
+static void printTable(const char* title, const vector<const scanner::Scanner*>& scanners, double (*measure)(string&, const scanner::Scanner*, size_t&))
+{
+    const pair<const char*, string (*)(size_t)> inputs[] =
+    {
+        { "identifiers", identifierLine },
+        { "strings", stringLine },
+        { "blanks", blankLine },
+        { "expressions", expressionLine },
+    };
+
+    cout << '\n' << title << '\n' << left << setw(14) << "input" << right << setw(10) << "MB" << setw(12) << "count";
+
+    for (const scanner::Scanner* scanner : scanners)
+    {
+        cout << setw(14) << string(scanner->name) + " MB/s";
+    }
+
+    cout << setw(12) << "speedup" << endl;
+
+    for (const auto& input : inputs)
+    {
+        string script = generate(input.second);
+
+        cout << left << setw(14) << input.first << right << fixed << setprecision(2)
+            << setw(10) << (double) script.size() / (1024.0 * 1024.0);
+
+        double scalar = 0;
+        double speed = 0;
+
+        for (const scanner::Scanner* scanner : scanners)
+        {
+            size_t count = 0;
+            speed = measure(script, scanner, count);
+
+            if (scanner == scanners.front())
+            {
+                scalar = speed;
+                cout << setw(12) << count;
+            }
+
+            cout << setw(14) << speed;
+        }
+
+        // of the fastest Scanner over the scalar one
+        cout << setw(11) << speed / scalar << 'x' << endl;
+    }
+}
+
+
+int main()
+{
+    // the Scanners the CPU supports, scalar first
+    vector<const scanner::Scanner*> scanners;
+
+    for (scanner::Isa isa : { scanner::Isa::SCALAR, scanner::Isa::SSE2, scanner::Isa::AVX2 })
+    {
+        if (const scanner::Scanner* supported = scanner::get(isa))
+        {
+            scanners.push_back(supported);
+        }
+    }
+
+    printTable("Tokenizing, count of Tokens", scanners, throughput);
+
+    printTable("Scanning only, count of runs", scanners, scanThroughput);
+}